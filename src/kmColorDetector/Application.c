@@ -36,6 +36,30 @@
 #include "Settings.h"
 #include "SoundPlayer.h"
 #include "Serial.h"
+#include "Training.h"
+#include "Clustering.h"
+#include "Smoothing.h"
+#include "Events.h"
+#include "Power.h"
+#include "TimerManager.h"
+#include "Format.h"
+#include "Shell.h"
+#ifndef KMCD_NO_TELEMETRY
+#include "Telemetry.h"
+#endif
+#include "Trace.h"
+#ifndef KMCD_NO_DASHBOARD
+#include "Dashboard.h"
+#endif
+#ifndef KMCD_NO_BAUD_SWITCH
+#include "BaudSwitch.h"
+#endif
+#ifdef KMCD_ONE_SHOT_TIMERS
+#include "OneShot.h"
+#endif
+#ifdef KMCD_SOFT_SERIAL_DEBUG
+#include "SoftSerial.h"
+#endif
 
 #include "Debug.h"
 
@@ -44,23 +68,193 @@
 #include "LiquidCrystal.h"
 #endif
 
+#ifndef KMCD_NO_SERIAL_DEBUG
+/// Room for reply of "set" or "get" with up to four values, longer replies like "clusters" can wait for serial
+#define APP_REPLY_BYTES (4 * FMT_BUFFER_SIZE_OF)
+/// Transfers of the reply, name, values and line end
+#define APP_REPLY_TRANSFERS 3
+/// Index of "dump" when it's not running
+#define APP_DUMP_IDLE 0xFF
+#endif
+
 // "private" functions
 void callbackDebugLed(void *userData, SwtValueType *newTimerValue);
 void callbackButton(void *userData, SwtValueType *newTimerValue);
 void callbackSensorMeasureReady(void *userData);
+void appApplyColorSettings(void);
+void appTrainingLongPress(void);
+void appMeasureRequest(void);
+void appMeasureFinished(void);
+#ifndef KMCD_NO_TELEMETRY
+uint8_t appMeasureFlags(uint32_t colorError);
+#endif
+#ifndef KMCD_NO_SERIAL_DEBUG
+void callbackStream(void *userData, SwtValueType *newTimerValue);
+void appSerialReceived(void);
+void appSerialWritable(void);
+bool appSerialIdle(uint8_t bytes, uint8_t transfers);
+bool appSerialOutput(void);
+bool appSerialMeasure(void);
+void appStoreMeasure(bool training, RgbColor8_t norm, uint8_t colorClass, uint32_t colorError);
+void appDumpNext(void);
+void appReply(const char *name, uint8_t count, const uint32_t *values);
+void appReplyModel(uint8_t classId);
+bool appParseValues(uint8_t argc, char **argv, uint8_t count, uint32_t max, uint32_t *values);
+bool appCmdMeasure(uint8_t argc, char **argv);
+bool appCmdStream(uint8_t argc, char **argv);
+bool appCmdTrain(uint8_t argc, char **argv);
+bool appCmdCommit(uint8_t argc, char **argv);
+bool appCmdCancel(uint8_t argc, char **argv);
+bool appCmdClusters(uint8_t argc, char **argv);
+bool appCmdStore(uint8_t argc, char **argv);
+bool appCmdSet(uint8_t argc, char **argv);
+bool appCmdGet(uint8_t argc, char **argv);
+bool appCmdDump(uint8_t argc, char **argv);
+#ifdef EVT_LATENCY_STATS
+bool appCmdLatency(uint8_t argc, char **argv);
+#endif
+#ifdef SWT_STATS
+bool appCmdTimers(uint8_t argc, char **argv);
+#endif
+bool appParamIntegration(uint8_t argc, char **argv);
+bool appParamScaling(uint8_t argc, char **argv);
+bool appParamBlack(uint8_t argc, char **argv);
+bool appParamWhite(uint8_t argc, char **argv);
+bool appParamModel(uint8_t argc, char **argv);
+#ifndef KMCD_NO_TELEMETRY
+bool appParamOutput(uint8_t argc, char **argv);
+#endif
+bool appParamSmoothing(uint8_t argc, char **argv);
+#ifndef KMCD_NO_DASHBOARD
+bool appParamDashboard(uint8_t argc, char **argv);
+#endif
+#endif
+
+// "private" global variables
+#ifndef KMCD_NO_SERIAL_DEBUG
+#ifndef KMCD_NO_BAUD_SWITCH
+// First character of two character command
+static int _appCommandPrefix = 0;
+#endif
+// Complete line received over serial, it's split into words in place by the shell
+static char _appLine[SHL_LINE_SIZE_OF];
+// Pause between streamed measures in ms, 0 if streaming is stopped
+static SwtValueType _appStreamInterval = 0;
+// The latest measure waiting for serial output, handlers print only what fits in the transmission buffer
+// and the rest is printed after EVT_SERIAL_TX, so finished measure never waits for serial
+static bool _appMeasurePending = false;
+static bool _appMeasureTraining = false;
+static RgbColor16_t _appMeasureRaw;
+static RgbColor8_t _appMeasureNorm;
+static uint8_t _appMeasureClass = 0;
+static uint32_t _appMeasureError = 0;
+// Text line of the measure printed in parts, lines of measures and replies are never mixed
+static uint8_t _appLinePart = 0;
+static uint8_t _appLineParts = 0;
+static bool _appLineTraining = false;
+static RgbColor16_t _appLineRaw;
+// Next parameter and color model printed by "dump", APP_DUMP_IDLE if it's not running
+static uint8_t _appDumpIndex = APP_DUMP_IDLE;
+static uint8_t _appDumpModel = 0;
+
+// Names of the commands and parameters, shared by the tables and replies
+static const char _appNameMeasure[] PROGMEM = "measure";
+static const char _appNameStream[] PROGMEM = "stream";
+static const char _appNameTrain[] PROGMEM = "train";
+static const char _appNameCommit[] PROGMEM = "commit";
+static const char _appNameAdd[] PROGMEM = "add";
+static const char _appNameReplace[] PROGMEM = "replace";
+static const char _appNameCancel[] PROGMEM = "cancel";
+static const char _appNameClusters[] PROGMEM = "clusters";
+static const char _appNameStore[] PROGMEM = "store";
+static const char _appNameSet[] PROGMEM = "set";
+static const char _appNameGet[] PROGMEM = "get";
+static const char _appNameDump[] PROGMEM = "dump";
+#ifdef EVT_LATENCY_STATS
+static const char _appNameLatency[] PROGMEM = "latency";
+#endif
+#ifdef SWT_STATS
+static const char _appNameTimers[] PROGMEM = "timers";
+#endif
+static const char _appNameIntegration[] PROGMEM = "integration";
+static const char _appNameScaling[] PROGMEM = "scaling";
+static const char _appNameBlack[] PROGMEM = "black";
+static const char _appNameWhite[] PROGMEM = "white";
+static const char _appNameModel[] PROGMEM = "model";
+#ifndef KMCD_NO_TELEMETRY
+static const char _appNameOutput[] PROGMEM = "output";
+static const char _appNameAscii[] PROGMEM = "ascii";
+static const char _appNameBinary[] PROGMEM = "binary";
+#endif
+static const char _appNameSmoothing[] PROGMEM = "smoothing";
+#ifndef KMCD_NO_DASHBOARD
+static const char _appNameDashboard[] PROGMEM = "dashboard";
+#endif
+
+// Commands accepted over serial debug, see Shell.h
+static const ShlCommand_t _appCommands[] PROGMEM = {
+	{_appNameMeasure, appCmdMeasure},
+	{_appNameStream, appCmdStream},
+	{_appNameTrain, appCmdTrain},
+	{_appNameCommit, appCmdCommit},
+	{_appNameCancel, appCmdCancel},
+	{_appNameClusters, appCmdClusters},
+	{_appNameStore, appCmdStore},
+	{_appNameSet, appCmdSet},
+	{_appNameGet, appCmdGet},
+	{_appNameDump, appCmdDump},
+#ifdef EVT_LATENCY_STATS
+	{_appNameLatency, appCmdLatency},
+#endif
+#ifdef SWT_STATS
+	{_appNameTimers, appCmdTimers},
+#endif
+};
+
+// Parameters of "set" and "get" commands, handler sets the parameter if it gets any arguments
+// and replies with its current value in the form accepted by "set"
+static const ShlCommand_t _appParameters[] PROGMEM = {
+	{_appNameIntegration, appParamIntegration},
+	{_appNameScaling, appParamScaling},
+	{_appNameBlack, appParamBlack},
+	{_appNameWhite, appParamWhite},
+	{_appNameModel, appParamModel},
+#ifndef KMCD_NO_TELEMETRY
+	{_appNameOutput, appParamOutput},
+#endif
+	{_appNameSmoothing, appParamSmoothing},
+#ifndef KMCD_NO_DASHBOARD
+	{_appNameDashboard, appParamDashboard},
+#endif
+};
+
+// Output frequency scaling of the sensor in percents, indexed by TscOutputFrequencyScaling
+static const uint8_t _appScalingPercent[] PROGMEM = {0, 2, 20, 100};
+#endif
 
 // Implementation
 void appInit(void) {
 	// Initialize all available ports as pull-up inputs
 	dbPullUpAllPorts();
+	// Initialize event queue before any of the modules posting events
+	evtInit();
+	// Initialize allocation of hardware timers before any of the modules reserving them
+	tmrInit();
 #ifndef KMCD_NO_DEBUG
 	// In case basic debug enabled - initialize it
 	dbInit();
 #endif
-	// Initialize software callbacks with one of default resolution interval
-	swtInit(SWT_INTERVAL_10MS);
+	// Initialize software callbacks in tickless mode, so Timer2 wakes up only when any timer expires,
+	// reservations of hardware timers fail only with conflicting configuration, reported after output is initialized
+	bool timersReserved = swtInit(SWT_INTERVAL_TICKLESS);
+	// Initialize sleep manager, it uses swtMillis clock to measure the time without activity
+	pwrInit();
 	// Initialize TCS3200 Color Sensor
-	tscInit();
+	timersReserved = tscInit() && timersReserved;
+#ifdef KMCD_ONE_SHOT_TIMERS
+	// Initialize one-shot timers sharing Timer1 time base with the sensor gate
+	timersReserved = ostInit() && timersReserved;
+#endif
 	// Initialize button routines with specific PIN as defined in config.h
 	btnInit(BUTTON_PIN);
 #ifndef KMCD_NO_SERIAL_DEBUG
@@ -73,13 +267,46 @@ void appInit(void) {
 	serPrintLnString_P(KMCD_INIT_STR);
 	serPrintString_P(KMCD_INIT_VERSION);
 	serPrintLnString(APP_VERSION);
+	if (false == timersReserved) {
+		serPrintLnString_P(KMCD_INIT_TIMERS_FAILED);
+	}
+#ifndef KMCD_NO_TELEMETRY
+	// Measures are sent as human readable lines until binary telemetry is selected
+	tlmInit(FMT_SINK_SERIAL);
+#endif
+#ifndef KMCD_NO_DASHBOARD
+	// Measures are shown as lines until the dashboard is started with "set dashboard 1"
+	dshInit(FMT_SINK_SERIAL);
+#endif
+#ifndef KMCD_NO_TRACE
+	// Trace frames are sent in between debug output, see TraceMessages.h
+	trcInit();
+#endif
+#ifndef KMCD_NO_BAUD_SWITCH
+	// Host can switch to faster rate, SWT_TIMER_2 measures the timeout of verification
+	bswInit(SWT_TIMER_2, PLYR_SERIAL_BAUD_RATE);
+#endif
+	// Serial console can't wake up uC from power-down, so only idle mode is used
+	pwrAllowPowerDown(PWR_APPLICATION, false);
 #else
 #ifndef KMCD_NO_DF_PLAYER
 	// In case sound module is enabled and serial debug disabled - 
-	// Initialize sound module
-	sndInit();
+	// Initialize sound module, SWT_TIMER_4 paces queued commands
+	sndInit(SWT_TIMER_4);
 #endif
 #endif
+#ifdef KMCD_SOFT_SERIAL_DEBUG
+	// Debug output runs on software UART, so it can be observed also when DF Player uses USART
+	if (true == swsInit(SWS_BAUD_RATE)) {
+		fmtString_P(FMT_SINK_SOFT_SERIAL, KMCD_INIT_STR);
+		fmtString_P(FMT_SINK_SOFT_SERIAL, PSTR("\r\n"));
+#ifndef KMCD_NO_TELEMETRY
+		// without serial console measures are always sent as binary telemetry frames
+		tlmInit(FMT_SINK_SOFT_SERIAL);
+		tlmSetMode(TLM_MODE_BINARY);
+#endif
+	}
+#endif
 #ifndef KMCD_NO_LCD
 	// In case LCD debug tools are enabled
 	// Initialize LCD for debug output
@@ -91,6 +318,10 @@ void appInit(void) {
 	lcdSetCursor(0, 0);
 	// and write application name and version
 	lcdPrint(APP_NAME " " APP_VERSION);
+	if (false == timersReserved) {
+		lcdSetCursor(0, 1);
+		lcdPrint_P(KMCD_INIT_TIMERS_FAILED);
+	}
 #endif
 	// Initialize settings
 	settingsInit();
@@ -98,8 +329,12 @@ void appInit(void) {
 	colorSetBlackReference(settingsGetBlackReference());
 	// Get current white reference level of sensor from settings and set it in color tools
 	colorSetWhiteReference(settingsGetWhiteReference());
-	// Get available color models from settings and set them in colorTools for #colorFindNearest function
-	colorSetModels(settingsGetColorModels(), settingsGetAvailableColorModels());
+	// Get available color models and prototypes from settings and set them in colorTools
+	appApplyColorSettings();
+	// Clear clusters of unknown colors
+	cluInit();
+	// Initialize smoothing of consecutive measures
+	smtInit(KMCD_SMOOTHING_POLICY);
 
 #ifndef KMCD_NO_DEBUG
 	// In case basic debug is enabled
@@ -107,6 +342,10 @@ void appInit(void) {
 	swtRegisterCallback(SWT_TIMER_0, SWT_USER_DATA(DEBUG_MAIN_PIN), callbackDebugLed);
 	// and start the software timer
 	swtStart(SWT_TIMER_0, DEBUG_BLINK_INTERVAL);
+#endif
+#ifndef KMCD_NO_SERIAL_DEBUG
+	// Register callback starting streamed measures, timer is started with "stream" command
+	swtRegisterCallback(SWT_TIMER_3, NULL, callbackStream);
 #endif
 	// Register callback routine for checking if button has been pressed,
 	swtRegisterCallback(SWT_TIMER_1, NULL, callbackButton);
@@ -114,44 +353,550 @@ void appInit(void) {
 	swtStart(SWT_TIMER_1, BUTTON_CHECK_INTERVAL);
 	// Register callback in the Color Sensor to be called when measure is finished.
 	tscRegisterCallbackMeasureFinished(callbackSensorMeasureReady, NULL);
+	// Register handlers of events posted by interrupts and callbacks,
+	// finished measure has the highest priority, so it's never delayed by serial processing
+	evtRegisterHandler(EVT_MEASURE_DONE, tscLoop);
+	evtRegisterHandler(EVT_TIMER_EXPIRED, swtLoop);
+	evtRegisterHandler(EVT_BUTTON, appMeasureRequest);
+#ifndef KMCD_NO_SERIAL_DEBUG
+	evtRegisterHandler(EVT_SERIAL_RX, appSerialReceived);
+	// output deferred until there is room in the transmission buffer
+	evtRegisterHandler(EVT_SERIAL_TX, appSerialWritable);
+#ifndef KMCD_NO_TRACE
+	// stored trace messages are sent when all other events are handled
+	evtRegisterHandler(EVT_TRACE, trcLoop);
+#endif
+#else
+#ifndef KMCD_NO_DF_PLAYER
+	evtRegisterHandler(EVT_SERIAL_RX, sndLoop);
+#endif
+#endif
 	// Enable interrupts.
 	sei();
 }
 
 void appLoop(void) {
-	// Loop Software Interrupts
-	swtLoop();
-	// Loop Color Sensor
-	tscLoop();
-#ifndef KMCD_NO_DF_PLAYER
-	// Loop Sound Player
-	sndLoop();
-#endif
-	// Button is looped in one of Software Interrupts
-	// Check if button has been pressed since last time
-#ifdef KMCD_NO_SERIAL_DEBUG
-	if (true == btnPressed()) {
-#else
-	if (true == btnPressed() || ' ' == serRead()) {
-#endif
-		// Reset button state
-		btnReset();
+	// Run handlers of pending events in order of their priority,
+	// Software Timers, Color Sensor, Sound Player and serial are handled there
+	evtLoop();
+	// Sleep until next interrupt, all events are already handled
+	pwrSleep();
+}
+
+void appMeasureRequest(void) {
+	// Measure request is an activity of the user, delaying power-down
+	pwrActivity();
+	// Reset button state
+	btnReset();
+	// Start measure routine for Color Sensor, request during running measure is dropped,
+	// its result is reported to all requesters
+	if (false == tscStartMeasure()) {
+		return;
+	}
+	TRC_LOG0(TRC_MEASURE_START);
 #ifndef KMCD_NO_DEBUG
-		// In case basic LED debug enabled - toggle button LED
-		dbToggle(DEBUG_BUTTON_PIN);
+	// In case basic LED debug enabled - toggle button LED
+	dbToggle(DEBUG_BUTTON_PIN);
 #endif
 #ifndef KMCD_NO_LCD
-		// In case LCD debug enabled - Show information about measure start
-		lcdSetCursor(0, 1);
-		lcdPrint_P(KMCD_MEASURE_START);
+	// In case LCD debug enabled - Show information about measure start
+	lcdSetCursor(0, 1);
+	lcdPrint_P(KMCD_MEASURE_START);
 #endif
 #ifndef KMCD_NO_SERIAL_DEBUG
-		// Send information about measure start to serial debug - if enabled
+	// Send information about measure start to serial debug - if enabled,
+	// it's skipped while the previous measure is still printed, e.g. when streaming at 9600 baud
+#ifndef KMCD_NO_TELEMETRY
+	// binary telemetry stream contains only frames
+	if (TLM_MODE_ASCII == tlmGetMode())
+#endif
+	if (true == appSerialIdle(0, 2)) {
 		serPrintLnString_P(KMCD_MEASURE_START);
+	}
+#endif
+}
+
+#ifndef KMCD_NO_SERIAL_DEBUG
+void appSerialReceived(void) {
+	// Process all complete lines received over serial since the last event,
+	// incomplete line stays in the receive buffer until its terminator comes
+	int c;
+	pwrActivity();
+	while ((c = serPeek()) >= 0) {
+		if (false == appSerialIdle(APP_REPLY_BYTES, APP_REPLY_TRANSFERS)) {
+			// reply would wait for serial, the rest is processed in appSerialWritable
+			break;
+		}
+#ifndef KMCD_NO_BAUD_SWITCH
+		if (true == bswVerifying()) {
+			// only the probe at the new rate is expected
+			bswReceived(serRead());
+			continue;
+		}
+		if (BSW_COMMAND == _appCommandPrefix) {
+			// code of the rate follows the baud switch command
+			_appCommandPrefix = 0;
+			bswRequest(serRead());
+			continue;
+		}
+		if (BSW_COMMAND == c) {
+			// baud switch at the beginning of the line isn't terminated, so the host doesn't need to know the terminator
+			_appCommandPrefix = serRead();
+			continue;
+		}
+#endif
+		if (' ' == c) {
+			// Space at the beginning of the line starts measure the same way as the button
+			serRead();
+			if (true == tscMeasureActive()) {
+				serPrintLnString_P(PSTR("?"));
+			} else {
+				evtPost(EVT_BUTTON);
+			}
+			continue;
+		}
+		if ('\n' == c) {
+			// rest of "\r\n" line end
+			serRead();
+			continue;
+		}
+		if (serReadLine(_appLine, sizeof(_appLine)) < 0) {
+			break;
+		}
+		if (false == shlExecute(_appCommands, SHL_COMMANDS_SIZE_OF(_appCommands), _appLine)) {
+			serPrintLnString_P(PSTR("?"));
+		}
+	}
+}
+
+void appSerialWritable(void) {
+	// output deferred by handlers comes first, commands received meanwhile are processed after it
+	if (true == appSerialOutput() && serAvailable() > 0) {
+		appSerialReceived();
+	}
+}
+
+bool appSerialIdle(uint8_t bytes, uint8_t transfers) {
+	return false == _appMeasurePending && 0 == _appLineParts && APP_DUMP_IDLE == _appDumpIndex
+			&& true == serWritable(bytes, transfers);
+}
+
+bool appSerialOutput(void) {
+	// measure line is finished before the next reply of "dump", so lines are never mixed
+	while (true == appSerialMeasure()) {
+		if (APP_DUMP_IDLE == _appDumpIndex) {
+			return true;
+		}
+		if (false == serWritable(APP_REPLY_BYTES, APP_REPLY_TRANSFERS)) {
+			return false;
+		}
+		appDumpNext();
+	}
+	return false;
+}
+
+bool appSerialMeasure(void) {
+	if (0 == _appLineParts) {
+		if (false == _appMeasurePending) {
+			return true;
+		}
+#ifndef KMCD_NO_TELEMETRY
+		if (TLM_MODE_BINARY == tlmGetMode()) {
+			// single frame always fits in the transmission buffer
+			if (false == serWritable(TLM_FRAME_SIZE_OF(TLM_RECORD_MAX_SIZE_OF), 1)) {
+				return false;
+			}
+			tlmSendMeasure(_appMeasureRaw, _appMeasureNorm, _appMeasureClass,
+					true == _appMeasureTraining ? TLM_FLAG_TRAINING : appMeasureFlags(_appMeasureError));
+			_appMeasurePending = false;
+			return true;
+		}
+#endif
+#ifndef KMCD_NO_DASHBOARD
+		if (false == _appMeasureTraining && true == dshActive()) {
+			// only changed fields are sent, so the update fits in empty transmission buffer
+			// unless the screen was just redrawn
+			if (0 != serPendingTransfers()) {
+				return false;
+			}
+			dshUpdateMeasure(_appMeasureRaw, _appMeasureNorm, _appMeasureClass, _appMeasureError);
+			_appMeasurePending = false;
+			return true;
+		}
 #endif
-		// Start measure routine for Color Sensor
-		tscStartMeasure();
+		// the latest measure is copied, so the next one can be stored while the line is printed
+		_appLineRaw = _appMeasureRaw;
+		_appLineTraining = _appMeasureTraining;
+		_appLineParts = true == _appLineTraining ? DB_TRAINING_PARTS_SIZE_OF : DB_MEASURE_PARTS_SIZE_OF;
+		_appLinePart = 0;
+		_appMeasurePending = false;
 	}
+	while (_appLinePart < _appLineParts) {
+		if (true == _appLineTraining) {
+			if (false == serWritable(DB_TRAINING_PART_BYTES, DB_TRAINING_PART_TRANSFERS)) {
+				return false;
+			}
+			dbTrainingPartToSerial(_appLinePart);
+		} else {
+			if (false == serWritable(DB_MEASURE_PART_BYTES, DB_MEASURE_PART_TRANSFERS)) {
+				return false;
+			}
+			dbMeasurePartToSerial(_appLineRaw, _appLinePart);
+		}
+		_appLinePart++;
+	}
+	_appLineParts = 0;
+	// measure finished meanwhile is printed in the next call
+	return false == _appMeasurePending;
+}
+
+void appStoreMeasure(bool training, RgbColor8_t norm, uint8_t colorClass, uint32_t colorError) {
+	// measure not printed yet is replaced with the latest one
+	_appMeasureTraining = training;
+	_appMeasureRaw = tscGetColor();
+	_appMeasureNorm = norm;
+	_appMeasureClass = colorClass;
+	_appMeasureError = colorError;
+	_appMeasurePending = true;
+	appSerialMeasure();
+}
+
+void appDumpNext(void) {
+	// single reply at once, color models one by one
+	if (SHL_COMMANDS_SIZE_OF(_appParameters) == _appDumpIndex) {
+		appCmdStream(0, NULL);
+		_appDumpIndex = APP_DUMP_IDLE;
+		return;
+	}
+	ShlHandler *handler = (ShlHandler *)pgm_read_ptr(&_appParameters[_appDumpIndex].handler);
+	if (appParamModel == handler) {
+		if (_appDumpModel < settingsGetAvailableColorModels()) {
+			appReplyModel(_appDumpModel++);
+			return;
+		}
+		_appDumpModel = 0;
+	} else {
+		handler(0, NULL);
+	}
+	_appDumpIndex++;
+}
+#endif
+
+void appApplyColorSettings(void) {
+	// Set available color models in colorTools for #colorFindNearest function
+	colorSetModels(settingsGetColorModels(), settingsGetAvailableColorModels());
+	// Set color prototypes, so several reference points can be used for single color
+	colorSetPrototypes(settingsGetColorPrototypes(), settingsGetAvailableColorPrototypes());
+}
+
+#ifndef KMCD_NO_SERIAL_DEBUG
+void appReply(const char *name, uint8_t count, const uint32_t *values) {
+	// reply has the same form as "set" command, e.g. "black 212 184 210"
+	serPrintString_P(name);
+	for (uint8_t i = 0; i < count; i++) {
+		serWriteChar(' ');
+		fmtDec(FMT_SINK_SERIAL, values[i]);
+	}
+	serPrintLn();
+}
+
+bool appParseValues(uint8_t argc, char **argv, uint8_t count, uint32_t max, uint32_t *values) {
+	if (argc != count) {
+		return false;
+	}
+	for (uint8_t i = 0; i < count; i++) {
+		if (false == shlParseUint(argv[i], max, &values[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool appCmdMeasure(uint8_t argc, char **argv) {
+	if (true == tscMeasureActive()) {
+		// previous measure is not finished yet
+		return false;
+	}
+	// Measure is started the same way as with the button
+	evtPost(EVT_BUTTON);
+	return true;
+}
+
+bool appCmdStream(uint8_t argc, char **argv) {
+	uint32_t interval = _appStreamInterval;
+	if (argc > 0) {
+		// pause between measures in ms, 0 stops streaming
+		if (false == appParseValues(argc, argv, 1, UINT16_MAX, &interval)) {
+			return false;
+		}
+		if (0 == _appStreamInterval && interval > 0) {
+			// next measures are started when the previous one is finished
+			swtStart(SWT_TIMER_3, interval);
+		}
+		_appStreamInterval = interval;
+	}
+	appReply(_appNameStream, 1, &interval);
+	return true;
+}
+
+bool appCmdTrain(uint8_t argc, char **argv) {
+	// Selects the class and starts training, following measures become its samples
+	uint32_t classId;
+	if (false == appParseValues(argc, argv, 1, KMCD_MAX_COLOR_MODELS - 1, &classId)) {
+		return false;
+	}
+	trnStart(classId);
+	serPrintString_P(KMCD_TRAINING_CLASS);
+	fmtDec(FMT_SINK_SERIAL, classId);
+	serPrintLn();
+	return true;
+}
+
+bool appCmdCommit(uint8_t argc, char **argv) {
+	// Store trained model and use it immediately, "commit add" keeps other prototypes of the class,
+	// "commit" or "commit replace" replaces the model and the first prototype
+	TrnCommitMode mode = TRN_COMMIT_REPLACE;
+	if (argc > 0) {
+		if (1 == argc && 0 == strcmp_P(argv[0], _appNameAdd)) {
+			mode = TRN_COMMIT_ADD;
+		} else if (1 != argc || 0 != strcmp_P(argv[0], _appNameReplace)) {
+			return false;
+		}
+	}
+	if (false == trnCommit(mode)) {
+		return false;
+	}
+	appApplyColorSettings();
+	serPrintLnString_P(KMCD_TRAINING_STORED);
+	return true;
+}
+
+bool appCmdCancel(uint8_t argc, char **argv) {
+	// Drop collected samples
+	trnCancel();
+	serPrintLnString_P(KMCD_TRAINING_CANCEL);
+	return true;
+}
+
+bool appCmdClusters(uint8_t argc, char **argv) {
+	// Show candidates for new color models found in unknown colors
+	dbClustersToSerial();
+	return true;
+}
+
+bool appCmdStore(uint8_t argc, char **argv) {
+	// Keep remotely tuned models and references after reset
+	settingsStore();
+	return true;
+}
+
+bool appCmdSet(uint8_t argc, char **argv) {
+	// parameter name followed by its new value
+	if (argc < 2) {
+		return false;
+	}
+	return shlDispatch(_appParameters, SHL_COMMANDS_SIZE_OF(_appParameters), argc, argv);
+}
+
+bool appCmdGet(uint8_t argc, char **argv) {
+	// only parameter name, so its handler replies with the current value
+	if (1 != argc) {
+		return false;
+	}
+	return shlDispatch(_appParameters, SHL_COMMANDS_SIZE_OF(_appParameters), argc, argv);
+}
+
+bool appCmdDump(uint8_t argc, char **argv) {
+	// All parameters, replies can be sent back prefixed with "set" to restore them,
+	// those not fitting in the transmission buffer are printed in appSerialWritable
+	_appDumpIndex = 0;
+	_appDumpModel = 0;
+	appSerialOutput();
+	return true;
+}
+
+#ifdef EVT_LATENCY_STATS
+bool appCmdLatency(uint8_t argc, char **argv) {
+	// Show worst-case latencies of events and start measuring them again
+	dbEventsToSerial();
+	evtResetLatency();
+	return true;
+}
+#endif
+
+#ifdef SWT_STATS
+bool appCmdTimers(uint8_t argc, char **argv) {
+	// Show lateness and duration of software timer callbacks and start collecting them again
+	dbTimersToSerial();
+	swtResetStats();
+	return true;
+}
+#endif
+
+bool appParamIntegration(uint8_t argc, char **argv) {
+	uint32_t microseconds;
+	if (argc > 0 && (false == appParseValues(argc, argv, 1, TSC_MAX_INTEGRATION_TIME, &microseconds)
+			|| false == tscSetIntegrationTime(microseconds))) {
+		return false;
+	}
+	microseconds = tscGetIntegrationTime();
+	appReply(_appNameIntegration, 1, &microseconds);
+	return true;
+}
+
+bool appParamScaling(uint8_t argc, char **argv) {
+	uint32_t percent;
+	if (argc > 0) {
+		if (false == appParseValues(argc, argv, 1, 100, &percent)) {
+			return false;
+		}
+		uint8_t scaling = TSC_PERCENT_2;
+		while (scaling <= TSC_PERCENT_100 && pgm_read_byte(&_appScalingPercent[scaling]) != percent) {
+			scaling++;
+		}
+		if (false == tscSetFrequencyScaling((TscOutputFrequencyScaling)scaling)) {
+			return false;
+		}
+	}
+	percent = pgm_read_byte(&_appScalingPercent[tscGetFrequencyScaling()]);
+	appReply(_appNameScaling, 1, &percent);
+	return true;
+}
+
+bool appParamBlack(uint8_t argc, char **argv) {
+	uint32_t values[3];
+	if (argc > 0) {
+		if (false == appParseValues(argc, argv, 3, UINT16_MAX, values)) {
+			return false;
+		}
+		settingsSetBlackReference((RgbColor16_t){.r = values[0], .g = values[1], .b = values[2]});
+		colorSetBlackReference(settingsGetBlackReference());
+	}
+	RgbColor16_t reference = settingsGetBlackReference();
+	values[0] = reference.r;
+	values[1] = reference.g;
+	values[2] = reference.b;
+	appReply(_appNameBlack, 3, values);
+	return true;
+}
+
+bool appParamWhite(uint8_t argc, char **argv) {
+	uint32_t values[3];
+	if (argc > 0) {
+		if (false == appParseValues(argc, argv, 3, UINT16_MAX, values)) {
+			return false;
+		}
+		settingsSetWhiteReference((RgbColor16_t){.r = values[0], .g = values[1], .b = values[2]});
+		colorSetWhiteReference(settingsGetWhiteReference());
+	}
+	RgbColor16_t reference = settingsGetWhiteReference();
+	values[0] = reference.r;
+	values[1] = reference.g;
+	values[2] = reference.b;
+	appReply(_appNameWhite, 3, values);
+	return true;
+}
+
+bool appParamModel(uint8_t argc, char **argv) {
+	uint32_t values[4];
+	if (argc > 0) {
+		// class number followed by normalized color, the first prototype of the class follows it
+		if (false == appParseValues(argc, argv, 4, UINT8_MAX, values)
+				|| false == trnSetModel(values[0], (RgbColor8_t){.r = values[1], .g = values[2], .b = values[3]})) {
+			return false;
+		}
+		appApplyColorSettings();
+	}
+	// all models, each in separate line
+	for (uint8_t i = 0; i < settingsGetAvailableColorModels(); i++) {
+		appReplyModel(i);
+	}
+	return true;
+}
+
+void appReplyModel(uint8_t classId) {
+	RgbColor8_t model = settingsGetColorModel(classId);
+	uint32_t values[4] = {classId, model.r, model.g, model.b};
+	appReply(_appNameModel, 4, values);
+}
+
+#ifndef KMCD_NO_TELEMETRY
+bool appParamOutput(uint8_t argc, char **argv) {
+	TlmMode mode = tlmGetMode();
+	if (argc > 0) {
+		if (1 == argc && 0 == strcmp_P(argv[0], _appNameAscii)) {
+			mode = TLM_MODE_ASCII;
+		} else if (1 == argc && 0 == strcmp_P(argv[0], _appNameBinary)) {
+			mode = TLM_MODE_BINARY;
+		} else {
+			return false;
+		}
+	}
+	// reply is sent before the switch, so binary stream contains only frames
+	serPrintString_P(_appNameOutput);
+	serWriteChar(' ');
+	serPrintLnString_P(TLM_MODE_BINARY == mode ? _appNameBinary : _appNameAscii);
+	tlmSetMode(mode);
+	return true;
+}
+#endif
+
+bool appParamSmoothing(uint8_t argc, char **argv) {
+	// combination of SMT_POLICY_* values
+	uint32_t policy;
+	if (argc > 0) {
+		if (false == appParseValues(argc, argv, 1, SMT_POLICY_EMA | SMT_POLICY_MAJORITY | SMT_POLICY_HYSTERESIS,
+				&policy)) {
+			return false;
+		}
+		smtSetPolicy(policy);
+	}
+	policy = smtGetPolicy();
+	appReply(_appNameSmoothing, 1, &policy);
+	return true;
+}
+
+#ifndef KMCD_NO_DASHBOARD
+bool appParamDashboard(uint8_t argc, char **argv) {
+	uint32_t active;
+	if (argc > 0) {
+		if (false == appParseValues(argc, argv, 1, 1, &active)) {
+			return false;
+		}
+		if (1 == active && false == dshActive()) {
+			dshStart();
+		} else if (0 == active && true == dshActive()) {
+			dshStop();
+		}
+	}
+	// reply is printed in the scrolling region below the dashboard
+	active = dshActive();
+	appReply(_appNameDashboard, 1, &active);
+	return true;
+}
+#endif
+#endif
+
+#ifndef KMCD_NO_TELEMETRY
+uint8_t appMeasureFlags(uint32_t colorError) {
+	// flags of the telemetry record describing classification of the measure
+	uint8_t flags = colorError > KMCD_UNKNOWN_COLOR_ERROR ? TLM_FLAG_UNKNOWN : 0;
+	if (SMT_POLICY_NONE != smtGetPolicy()) {
+		flags |= TLM_FLAG_SMOOTHED;
+	}
+	return flags;
+}
+#endif
+
+void appMeasureFinished(void) {
+	// Re-enable possibility to start measure with button again
+	swtStart(SWT_TIMER_1, BUTTON_CHECK_INTERVAL);
+#ifndef KMCD_NO_SERIAL_DEBUG
+	if (_appStreamInterval > 0) {
+		// streamed measure follows after the pause
+		swtStart(SWT_TIMER_3, _appStreamInterval);
+	}
+#endif
 }
 
 // Callbacks
@@ -172,27 +917,134 @@ void callbackButton(void *userData, SwtValueType *newTimerValue) {
 		// this if allows to press the button only once
 		// restarts timer once measure is ready in callbackMeasureReady
 		*newTimerValue = BUTTON_CHECK_INTERVAL;
+	} else if (btnLongPressed() == true) {
+		// Long press drives training, so it's available also without serial console
+		btnReset();
+		appTrainingLongPress();
+		*newTimerValue = BUTTON_CHECK_INTERVAL;
+	} else {
+		// Measure is started in the handler of the button event
+		evtPost(EVT_BUTTON);
 	}
 }
 
-void callbackSensorMeasureReady(void *userData) {
+void appTrainingLongPress(void) {
+	// Short presses measure samples of the selected class in training mode
+	const char *message = NULL;
+	uint8_t classId = trnGetClass();
+	if (false == trnActive()) {
+		// first long press starts training of the first class
+		classId = 0;
+		trnStart(classId);
+	} else if (0 == trnGetSamplesCount()) {
+		// without samples long press selects the next class, training ends after the last one
+		if (classId + 1 < KMCD_MAX_COLOR_MODELS) {
+			trnStart(++classId);
+		} else {
+			trnCancel();
+			message = KMCD_TRAINING_CANCEL;
+		}
+	} else if (true == trnCommit(TRN_COMMIT_REPLACE)) {
+		// samples become the model of the class, which is used immediately
+		appApplyColorSettings();
+		message = KMCD_TRAINING_STORED;
 #ifndef KMCD_NO_DF_PLAYER
+		sndSetTrack(classId + 1);
+#endif
+	} else {
+		// too few samples to build the model
+		trnCancel();
+		message = KMCD_TRAINING_CANCEL;
+	}
+#ifndef KMCD_NO_DF_PLAYER
+	if (NULL == message) {
+		// Player announces the selected class with its track, the same as the stored one
+		sndSetTrack(classId + 1);
+	}
+#endif
+#ifndef KMCD_NO_SERIAL_DEBUG
+	if (NULL == message) {
+		serPrintString_P(KMCD_TRAINING_CLASS);
+		fmtDec(FMT_SINK_SERIAL, classId);
+		serPrintLn();
+	} else {
+		serPrintLnString_P(message);
+	}
+#endif
+#ifndef KMCD_NO_LCD
+	if (NULL == message) {
+		dbTrainingToLCD();
+	} else {
+		lcdSetCursor(0, 1);
+		lcdPrint_P(message);
+		lcdFillSpacesToEndOfTheLine();
+	}
+#endif
+}
+
+#ifndef KMCD_NO_SERIAL_DEBUG
+void callbackStream(void *userData, SwtValueType *newTimerValue) {
+	if (_appStreamInterval > 0 && false == tscMeasureActive()) {
+		// the timer is started again when the measure is finished
+		evtPost(EVT_BUTTON);
+	}
+}
+#endif
+
+void callbackSensorMeasureReady(void *userData) {
+	if (true == trnActive()) {
+		// In training mode measure is only collected as a sample of the trained class
+		trnAddSample(colorNormalize(tscGetColor()));
+		TRC_LOG2(TRC_TRAINING_SAMPLE, trnGetClass(), trnGetSamplesCount());
+#ifndef KMCD_NO_SERIAL_DEBUG
+		appStoreMeasure(true, colorNormalize(tscGetColor()), trnGetClass(), 0);
+#endif
+#ifndef KMCD_NO_LCD
+		dbTrainingToLCD();
+#endif
+		appMeasureFinished();
+		return;
+	}
 	// Get color from Color Sensor after measure is finished,
-	// Then normalize it, and find nearest matching color using Color Tools.
-	uint8_t colorNumber = colorFindNearest(colorNormalize(tscGetColor()));
+	// Then normalize and smooth it, and find nearest matching color class using Color Tools.
+	RgbColor8_t colorNorm = smtFilterColor(colorNormalize(tscGetColor()));
+	uint32_t colorError = 0;
+	uint8_t colorNumber = colorFindNearestWithError(colorNorm, &colorError);
+	if (colorError > KMCD_UNKNOWN_COLOR_ERROR) {
+		// Color doesn't match any of known colors, let clustering find recurring ones
+		cluAddSample(colorNorm);
+		TRC_LOG1(TRC_UNKNOWN_COLOR, colorError > UINT16_MAX ? UINT16_MAX : (uint16_t)colorError);
+	}
+	// Apply majority vote and hysteresis, so single noisy measure doesn't change the output
+	colorNumber = smtFilterClass(colorNumber);
+	TRC_LOG4(TRC_MEASURE_DONE, colorNorm.r, colorNorm.g, colorNorm.b, colorNumber);
+#ifndef KMCD_NO_DF_PLAYER
 	// Set the track number as color + 1 since tracks start from number 1
 	// in the DFRobot Mini Player
 	sndSetTrack(colorNumber + 1);
 #else
 #ifndef KMCD_NO_SERIAL_DEBUG
-	// Send measure to serial in case serial is enabled
-	dbMeasureToSerial();
+	// Send measure to serial in case serial is enabled, as frame, dashboard update or line,
+	// what doesn't fit in the transmission buffer now is printed in appSerialWritable
+#ifndef KMCD_NO_DASHBOARD
+	if (true == dshActive()) {
+		dshCountMeasure(colorError);
+	}
+#endif
+	appStoreMeasure(false, colorNorm, colorNumber, colorError);
+#endif
+#endif
+#ifdef KMCD_SOFT_SERIAL_DEBUG
+	// Send measure to software UART, also when DF Player is enabled
+#ifndef KMCD_NO_TELEMETRY
+	tlmSendMeasure(tscGetColor(), colorNorm, colorNumber, appMeasureFlags(colorError));
+#else
+	dbMeasureToSoftSerial();
 #endif
 #endif
 #ifndef KMCD_NO_LCD
 	// Send measure to LCD in case LCD is enabled
 	dbMeasureToLCD();
 #endif
-	// Re-enable possibility to start measure with button again
-	swtStart(SWT_TIMER_1, BUTTON_CHECK_INTERVAL);
+	appMeasureFinished();
 }
@@ -0,0 +1,118 @@
+/*
+ * BaudSwitch.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/pgmspace.h>
+
+#include "BaudSwitch.h"
+#include "Serial.h"
+#include "SoftwareTimer.h"
+
+// "Private" global variables.
+static const uint32_t _bswRates[BSW_RATES_SIZE_OF] PROGMEM = {
+	9600, 19200, 38400, 57600, 115200, 230400, 460800, 691200, 1382400
+};
+
+static uint8_t _bswTimerNo = 0;
+static uint32_t _bswCurrentRate = 0;
+static uint32_t _bswPreviousRate = 0;
+static bool _bswVerifying = false;
+
+// "Private" functions.
+void bswCallbackTimeout(void *userData, SwtValueType *newTimerValue);
+void bswSwitch(uint32_t baud);
+
+// Implementation
+void bswInit(uint8_t timerNo, uint32_t baud) {
+	_bswTimerNo = timerNo;
+	_bswCurrentRate = baud;
+	_bswPreviousRate = baud;
+	_bswVerifying = false;
+}
+
+uint32_t bswGetBaudRate(uint8_t code) {
+	if (code < '0' || code >= '0' + BSW_RATES_SIZE_OF) {
+		return 0;
+	}
+	return pgm_read_dword(&_bswRates[code - '0']);
+}
+
+bool bswRequest(uint8_t code) {
+	uint32_t baud = bswGetBaudRate(code);
+	// with U2X bit rate is F_CPU / 8 / (UBRR + 1), so it has to divide F_CPU / 8 exactly
+	if (0 == baud || _bswVerifying || 0 != (F_CPU / 8) % baud) {
+		serPrintString_P(PSTR("B?\r\n"));
+		return false;
+	}
+	serWriteChar(BSW_COMMAND);
+	serWriteChar(code);
+	serPrintLn();
+	_bswPreviousRate = _bswCurrentRate;
+	bswSwitch(baud);
+	_bswVerifying = true;
+	swtRegisterCallback(_bswTimerNo, NULL, bswCallbackTimeout);
+	swtStart(_bswTimerNo, KMCD_BAUD_SWITCH_TIMEOUT);
+	return true;
+}
+
+bool bswVerifying(void) {
+	return _bswVerifying;
+}
+
+void bswReceived(uint8_t c) {
+	if (false == _bswVerifying || BSW_PROBE != c) {
+		return;
+	}
+	serWriteChar(BSW_PROBE);
+	_bswVerifying = false;
+	swtUnregisterCallback(_bswTimerNo);
+}
+
+uint32_t bswGetCurrentBaudRate(void) {
+	return _bswCurrentRate;
+}
+
+void bswSwitch(uint32_t baud) {
+	// agreement is sent completely at the old rate
+	serFlush();
+	serSetBaudRate(baud);
+	// bytes received during the switch are garbage
+	while (serRead() >= 0) {
+	}
+	_bswCurrentRate = baud;
+}
+
+void bswCallbackTimeout(void *userData, SwtValueType *newTimerValue) {
+	if (true == _bswVerifying) {
+		// host didn't send the probe at the new rate, both sides go back to the previous one
+		_bswVerifying = false;
+		bswSwitch(_bswPreviousRate);
+		serPrintString_P(PSTR("B?\r\n"));
+	}
+	// timer is not restarted
+}
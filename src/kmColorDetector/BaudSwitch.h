@@ -0,0 +1,94 @@
+/** @file
+ * @brief Host initiated switch of serial debug baud rate.
+ * BaudSwitch.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Handshake:
+ *  -# host sends 'B' and code of the new rate ('0'..'8', see #bswGetBaudRate) at current rate,
+ *  -# detector agrees with "B<code>\\r\\n" at current rate, waits until it's sent and switches,
+ *     invalid or inexact rate is rejected with "B?\\r\\n" and nothing changes,
+ *  -# host switches and sends #BSW_PROBE, detector echoes it and keeps the new rate,
+ *  -# if the probe doesn't come within #KMCD_BAUD_SWITCH_TIMEOUT, detector goes back to the previous rate;
+ *     host does the same if it doesn't get the echo.
+ *
+ *  Only rates with exact U2X divisor are accepted. With 11.0592MHz crystal these are all rates
+ *  from the table except 921600, which would need UBRR = 0.5.
+ *  DF Player link is not affected, it's always initialized with PLYR_SERIAL_BAUD_RATE.
+ */
+
+#ifndef BAUDSWITCH_H_
+#define BAUDSWITCH_H_
+
+#include "common.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// Command starting the switch, followed by the code of the rate
+#define BSW_COMMAND 'B'
+/// Byte sent by the host at the new rate and echoed by the detector
+#define BSW_PROBE 0x55
+/// Number of available rates
+#define BSW_RATES_SIZE_OF 9
+
+/**
+Initializes baud switch, current rate is the one used in #serInit.
+@param timerNo Software timer used for the timeout of verification.
+@param baud Current baud rate of serial debug.
+*/
+void bswInit(uint8_t timerNo, uint32_t baud);
+
+/**
+Returns baud rate of the code used in the handshake.
+@param code Code of the rate from '0' (9600) to '8' (1382400).
+@result Baud rate or 0 for invalid code.
+*/
+uint32_t bswGetBaudRate(uint8_t code);
+
+/**
+Starts the switch requested by the host, agrees and switches or rejects the rate.
+@param code Code of the rate as received after #BSW_COMMAND.
+@result true if the rate is switched and waits for verification.
+*/
+bool bswRequest(uint8_t code);
+
+/**
+Returns if the switch waits for the probe at the new rate.
+All received bytes should be passed to #bswReceived then.
+@result true if verification is pending.
+*/
+bool bswVerifying(void);
+
+/**
+Processes byte received while verification is pending, probe is echoed and confirms the new rate.
+Other bytes (e.g. garbage received during the switch) are ignored.
+@param c Received byte.
+*/
+void bswReceived(uint8_t c);
+
+/**
+Returns currently used baud rate.
+@result Baud rate of serial debug.
+*/
+uint32_t bswGetCurrentBaudRate(void);
+
+#endif /* BAUDSWITCH_H_ */
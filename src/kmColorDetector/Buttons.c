@@ -32,6 +32,14 @@
 static uint8_t _btnPin = 0;
 static bool _btnPreviousState = false;
 static bool _btnPressed = false;
+static bool _btnLongPressed = false;
+// Number of btnLoop calls while the button is held, saturated at the long press
+static uint8_t _btnHeldChecks = 0;
+
+#define BUTTON_LONG_PRESS_CHECKS (BUTTON_LONG_PRESS_TIME / BUTTON_CHECK_INTERVAL)
+
+_Static_assert(BUTTON_LONG_PRESS_CHECKS > 0 && BUTTON_LONG_PRESS_CHECKS < 256,
+		"BUTTON_LONG_PRESS_TIME has to be from 1 to 255 times BUTTON_CHECK_INTERVAL");
 
 // "Private" functions
 bool btnGetState(void);
@@ -49,6 +57,8 @@ void btnInit(uint8_t pin) {
 	_btnPin = pin;
 	_btnPreviousState = false;
 	_btnPressed = false;
+	_btnLongPressed = false;
+	_btnHeldChecks = 0;
 
 	// set button pin as input
 	BUTTON_DDR &=~ _BV(_btnPin);
@@ -61,9 +71,14 @@ void btnLoop(void) {
 	bool currentState = btnGetState();
 	if (currentState != _btnPreviousState) {
 		if (currentState == false) {
+			// press is reported when button is released, so its length is known
 			_btnPressed = true;
+			_btnLongPressed = _btnHeldChecks >= BUTTON_LONG_PRESS_CHECKS;
 		}
+		_btnHeldChecks = 0;
 		_btnPreviousState = currentState;
+	} else if (currentState == true && _btnHeldChecks < BUTTON_LONG_PRESS_CHECKS) {
+		_btnHeldChecks++;
 	}
 }
 
@@ -71,6 +86,11 @@ bool btnPressed(void) {
 	return _btnPressed;
 }
 
+bool btnLongPressed(void) {
+	return _btnLongPressed;
+}
+
 void btnReset(void) {
 	_btnPressed = false;
+	_btnLongPressed = false;
 }
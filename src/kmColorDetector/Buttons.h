@@ -37,6 +37,8 @@ Following definitions to be set in config.h file @n
 #define \b BUTTON_DDR  data direction register for button port (e.g DDRC) @n
 #define \b BUTTON_PORT_IN button port input (e.g PINC) @n
 #define \b BUTTON_PIN button pin (e.g PC1) @n
+#define \b BUTTON_CHECK_INTERVAL interval of #btnLoop calls in ms @n
+#define \b BUTTON_LONG_PRESS_TIME time in ms the button has to be held to report long press @n
 @param pin - pin to which button is connected
 */
 void btnInit(uint8_t pin);
@@ -52,6 +54,13 @@ Returns true in case button has been pressed since last btnReset function issued
 */
 bool btnPressed(void);
 
+/**
+Returns true in case the press reported by #btnPressed was long, i.e. the button was held
+at least BUTTON_LONG_PRESS_TIME before it was released.
+@return true in case of long press
+*/
+bool btnLongPressed(void);
+
 /**
 Resets the button state so application is ready for the next press.
 */
@@ -0,0 +1,122 @@
+/*
+ * Clustering.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Clustering.h"
+
+// Internal definition of types.
+typedef struct {
+	// cluster center in Q8.8 format
+	uint16_t r;
+	uint16_t g;
+	uint16_t b;
+	uint16_t count;
+	// value of the sample clock when the cluster was updated last time
+	uint16_t updated;
+} cluCluster;
+
+// "Private" global variables.
+static cluCluster _clusters[KMCD_CLUSTER_BUDGET];
+static uint8_t _clustersCount = 0;
+// Number of added samples, age of the cluster is counted modulo 2^16 samples
+static uint16_t _cluClock = 0;
+
+// "Private" functions.
+uint16_t cluUpdateCenter(uint16_t center, uint8_t value, uint16_t weight);
+RgbColor8_t cluGetColor(const cluCluster *cluster);
+
+// Implementation
+uint16_t cluUpdateCenter(uint16_t center, uint8_t value, uint16_t weight) {
+	// center += (x - center) / weight
+	int32_t delta = ((int32_t)value << 8) - center;
+	return (uint16_t)(center + delta / weight);
+}
+
+RgbColor8_t cluGetColor(const cluCluster *cluster) {
+	RgbColor8_t result;
+	result.r = (cluster->r + 0x80) >> 8;
+	result.g = (cluster->g + 0x80) >> 8;
+	result.b = (cluster->b + 0x80) >> 8;
+	return result;
+}
+
+void cluInit(void) {
+	_clustersCount = 0;
+	_cluClock = 0;
+}
+
+uint8_t cluAddSample(RgbColor8_t sample) {
+	uint32_t minDifference = UINT32_MAX;
+	uint8_t result = 0;
+	for (uint8_t i = 0; i < _clustersCount; i++) {
+		uint32_t difference = colorDifferenceErrorRGB(sample, cluGetColor(&_clusters[i]));
+		if (difference < minDifference) {
+			minDifference = difference;
+			result = i;
+		}
+	}
+
+	if (minDifference > KMCD_CLUSTER_RADIUS) {
+		// sample is far from all clusters - it becomes leader of a new one
+		if (_clustersCount < KMCD_CLUSTER_BUDGET) {
+			result = _clustersCount++;
+		} else {
+			// budget exceeded, replace the least recently updated cluster
+			result = 0;
+			for (uint8_t i = 1; i < _clustersCount; i++) {
+				if ((uint16_t)(_cluClock - _clusters[i].updated) > (uint16_t)(_cluClock - _clusters[result].updated)) {
+					result = i;
+				}
+			}
+		}
+		_clusters[result].r = (uint16_t)sample.r << 8;
+		_clusters[result].g = (uint16_t)sample.g << 8;
+		_clusters[result].b = (uint16_t)sample.b << 8;
+		_clusters[result].count = 1;
+	} else {
+		cluCluster *cluster = &_clusters[result];
+		if (cluster->count < UINT16_MAX) {
+			cluster->count++;
+		}
+		uint16_t weight = cluster->count < KMCD_CLUSTER_WEIGHT_LIMIT ? cluster->count : KMCD_CLUSTER_WEIGHT_LIMIT;
+		cluster->r = cluUpdateCenter(cluster->r, sample.r, weight);
+		cluster->g = cluUpdateCenter(cluster->g, sample.g, weight);
+		cluster->b = cluUpdateCenter(cluster->b, sample.b, weight);
+	}
+	_clusters[result].updated = _cluClock++;
+	return result;
+}
+
+uint8_t cluGetClustersCount(void) {
+	return _clustersCount;
+}
+
+CluCandidate_t cluGetCandidate(uint8_t clusterNumber) {
+	CluCandidate_t result;
+	result.color = cluGetColor(&_clusters[clusterNumber]);
+	result.count = _clusters[clusterNumber].count;
+	return result;
+}
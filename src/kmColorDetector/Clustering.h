@@ -0,0 +1,84 @@
+/** @file
+ * @brief Online clustering of colors that don't match any of the known color models.
+ * Clustering.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  References:
+ * -# https://en.wikipedia.org/wiki/Leader_clustering
+ * -# https://en.wikipedia.org/wiki/K-means_clustering#Online_k-means
+ */
+
+#ifndef CLUSTERING_H_
+#define CLUSTERING_H_
+
+#include "common.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ColorTools.h"
+
+/**
+Definition of the candidate cluster of the unknown colors.
+*/
+typedef struct {
+	/// Normalized color of the cluster center.
+	RgbColor8_t color;
+	/// Number of samples assigned to the cluster.
+	uint16_t count;
+} CluCandidate_t;
+
+/**
+Initializes (or clears) all clusters.
+Following definitions to be set in config.h file @n
+#define \b KMCD_CLUSTER_BUDGET maximum number of clusters kept in RAM@n
+#define \b KMCD_CLUSTER_RADIUS sum of squared differences below which sample joins existing cluster@n
+#define \b KMCD_CLUSTER_WEIGHT_LIMIT number of samples after which cluster center follows new samples
+with constant weight (so it can adapt to slow drift)@n
+*/
+void cluInit(void);
+
+/**
+Adds normalized sample to the nearest cluster or starts a new cluster (leader algorithm)
+in case sample is further than #KMCD_CLUSTER_RADIUS from all existing clusters.
+If all clusters are in use, the least recently updated cluster is replaced, so clusters of colors
+which don't appear anymore age out and new recurring color isn't starved by old populated clusters.
+Cluster center is updated incrementally (online k-means), so samples are not stored.
+@param sample Normalized color sample.
+@result Number of the cluster the sample was assigned to.
+*/
+uint8_t cluAddSample(RgbColor8_t sample);
+
+/**
+Returns number of clusters currently in use.
+@result Number of clusters (up to #KMCD_CLUSTER_BUDGET).
+*/
+uint8_t cluGetClustersCount(void);
+
+/**
+Returns candidate cluster of specific number.
+@param clusterNumber Number of the cluster (0 to #cluGetClustersCount - 1).
+@result Center of the cluster and number of samples assigned to it.
+*/
+CluCandidate_t cluGetCandidate(uint8_t clusterNumber);
+
+#endif /* CLUSTERING_H_ */
@@ -24,29 +24,69 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
+#include <avr/pgmspace.h>
 
 #include "ColorTools.h"
+#include "FixedPoint.h"
 
 
 // Number of available color models
-#define COLOR_NORMAL_RESULT_RANGE COLOR_NORMAL_RESULT_WHITE_LEVEL - COLOR_NORMAL_RESULT_BLACK_LEVEL
+#define COLOR_NORMAL_RESULT_RANGE (COLOR_NORMAL_RESULT_WHITE_LEVEL - COLOR_NORMAL_RESULT_BLACK_LEVEL)
 
 static RgbColor16_t _blackLevel;
 static RgbColor16_t _whiteLevel;
+// white - black reference levels and COLOR_NORMAL_RESULT_RANGE / range in Q16.16,
+// precalculated when references are set, so normalization doesn't need division
+static RgbColor16_t _rangeLevel;
+static uint32_t _scaleR;
+static uint32_t _scaleG;
+static uint32_t _scaleB;
 static const RgbColor8_t *_colorModels;
 static uint8_t _colorModelsSizeOf = 0;
+static const ColorPrototype_t *_colorPrototypes;
+static uint8_t _colorPrototypesSizeOf = 0;
+static bool _colorPrototypesInFlash = false;
 
 // "private" functions
-int32_t colorPow2(int32_t value);
-uint8_t colorNormalizeSingle(uint16_t source, uint16_t sourceBlackLevel, uint16_t sourceWhiteLevel);
+uint8_t colorAbsDifference(uint8_t a, uint8_t b);
+uint8_t colorNormalizeSingle(uint16_t source, uint16_t sourceBlackLevel, uint16_t sourceRange, uint32_t sourceScale);
+uint16_t colorNormalizeRange(uint16_t sourceBlackLevel, uint16_t sourceWhiteLevel);
+uint32_t colorNormalizeScale(uint16_t sourceRange);
+void colorUpdateScale(void);
+int8_t colorHueOffset(uint8_t first, uint8_t second, uint8_t delta);
+ColorPrototype_t colorGetPrototype(uint8_t prototypeNumber);
 
 // Implementation
 void colorSetBlackReference(RgbColor16_t blackLevel) {
 	_blackLevel = blackLevel;
+	colorUpdateScale();
 }
 
 void colorSetWhiteReference(RgbColor16_t whiteLevel) {
 	_whiteLevel = whiteLevel;
+	colorUpdateScale();
+}
+
+uint16_t colorNormalizeRange(uint16_t sourceBlackLevel, uint16_t sourceWhiteLevel) {
+	// white reference not above black one means missing calibration, avoid division by zero
+	return sourceWhiteLevel > sourceBlackLevel ? sourceWhiteLevel - sourceBlackLevel : 1;
+}
+
+uint32_t colorNormalizeScale(uint16_t sourceRange) {
+	// COLOR_NORMAL_RESULT_RANGE * 2^16 / range = COLOR_NORMAL_RESULT_RANGE * (2^32 / range) / 2^16
+	uint32_t recip = fxRecipU16(sourceRange);
+	return fxMulU16(COLOR_NORMAL_RESULT_RANGE, (uint16_t)(recip >> 16))
+		+ (fxMulU16(COLOR_NORMAL_RESULT_RANGE, (uint16_t)recip) >> 16);
+}
+
+void colorUpdateScale(void) {
+	_rangeLevel.r = colorNormalizeRange(_blackLevel.r, _whiteLevel.r);
+	_rangeLevel.g = colorNormalizeRange(_blackLevel.g, _whiteLevel.g);
+	_rangeLevel.b = colorNormalizeRange(_blackLevel.b, _whiteLevel.b);
+	_scaleR = colorNormalizeScale(_rangeLevel.r);
+	_scaleG = colorNormalizeScale(_rangeLevel.g);
+	_scaleB = colorNormalizeScale(_rangeLevel.b);
 }
 
 void colorSetModels(const RgbColor8_t *colorModels, uint8_t colorModelsAvailable) {
@@ -54,61 +94,116 @@ void colorSetModels(const RgbColor8_t *colorModels, uint8_t colorModelsAvailable
 	_colorModelsSizeOf = colorModelsAvailable;
 }
 
-uint8_t colorNormalizeSingle(uint16_t source, uint16_t sourceBlackLevel, uint16_t sourceWhiteLevel) {
+void colorSetPrototypes(const ColorPrototype_t *prototypes, uint8_t prototypesAvailable) {
+	_colorPrototypes = prototypes;
+	_colorPrototypesSizeOf = prototypesAvailable;
+	_colorPrototypesInFlash = false;
+}
+
+void colorSetPrototypes_P(const ColorPrototype_t *prototypes, uint8_t prototypesAvailable) {
+	_colorPrototypes = prototypes;
+	_colorPrototypesSizeOf = prototypesAvailable;
+	_colorPrototypesInFlash = true;
+}
+
+ColorPrototype_t colorGetPrototype(uint8_t prototypeNumber) {
+	ColorPrototype_t result;
+	if (true == _colorPrototypesInFlash) {
+		memcpy_P(&result, &_colorPrototypes[prototypeNumber], sizeof(result));
+	} else {
+		result = _colorPrototypes[prototypeNumber];
+	}
+	return result;
+}
+
+uint8_t colorNormalizeSingle(uint16_t source, uint16_t sourceBlackLevel, uint16_t sourceRange, uint32_t sourceScale) {
 	// result = 
 	// (source - sourceBlackLevel) * COLOR_NORMAL_RESULT_RANGE
 	// ------------------------------------------------------- + COLOR_NORMAL_RESULT_BLACK_LEVEL
 	//          (sourceWhiteLevel - sourceBlackLevel);
 	// where COLOR_NORMAL_RESULT_RANGE = COLOR_NORMAL_RESULT_WHITE_LEVEL - COLOR_NORMAL_RESULT_BLACK_LEVEL
+	// Division is replaced by multiplication with sourceScale = COLOR_NORMAL_RESULT_RANGE / range in Q16.16
+	// and the quotient is corrected with the remainder, so the result is exact.
+
+	bool belowBlack = source < sourceBlackLevel;
+	uint16_t difference = belowBlack ? sourceBlackLevel - source : source - sourceBlackLevel;
+	if ((difference >> 1) >= sourceRange) {
+		// far beyond the reference range, result is saturated anyway
+		return belowBlack ? 0x00 : 0xFF;
+	}
+	int16_t quotient = (int16_t)(fxMulU16U32(difference, sourceScale) >> 16);
+	int32_t remainder = (int32_t)fxMulU16(difference, COLOR_NORMAL_RESULT_RANGE) - (int32_t)fxMulU16(quotient, sourceRange);
+	while (remainder < 0) {
+		quotient--;
+		remainder += sourceRange;
+	}
+	while (remainder >= sourceRange) {
+		quotient++;
+		remainder -= sourceRange;
+	}
 
-	int32_t tmp = source;
-	tmp -= sourceBlackLevel;
-	tmp *= COLOR_NORMAL_RESULT_RANGE;
-	tmp /= (sourceWhiteLevel - sourceBlackLevel);
-	tmp += COLOR_NORMAL_RESULT_BLACK_LEVEL;
+	int16_t tmp = belowBlack ? COLOR_NORMAL_RESULT_BLACK_LEVEL - quotient : COLOR_NORMAL_RESULT_BLACK_LEVEL + quotient;
 	tmp = tmp < 0x00 ? 0 : tmp;
 	tmp = tmp > 0xFF ? 0xFF : tmp;
 	return (uint8_t)tmp;
 }
 
-int32_t colorPow2(int32_t value) {
-	return value * value;
+uint8_t colorAbsDifference(uint8_t a, uint8_t b) {
+	return a > b ? a - b : b - a;
 }
 
 uint32_t colorDifferenceErrorRGB(RgbColor8_t sourceColor, RgbColor8_t modelColor) {
-	uint32_t result = 0;
-	result += (uint32_t)(colorPow2(abs((int16_t)sourceColor.r - (int16_t)modelColor.r)));
-	result += (uint32_t)(colorPow2(abs((int32_t)sourceColor.g - (int32_t)modelColor.g)));
-	result += (uint32_t)(colorPow2(abs((int32_t)sourceColor.b - (int32_t)modelColor.b)));
+	// differences fit into 8 bits, so each square takes single 8x8 multiplication instead of 32 bit one
+	uint32_t result = fxSqrU8(colorAbsDifference(sourceColor.r, modelColor.r));
+	result += fxSqrU8(colorAbsDifference(sourceColor.g, modelColor.g));
+	result += fxSqrU8(colorAbsDifference(sourceColor.b, modelColor.b));
 	return result;
 }
 
 uint8_t colorFindNearest(RgbColor8_t sourceColor) {
+	uint32_t error;
+	return colorFindNearestWithError(sourceColor, &error);
+}
+
+uint8_t colorFindNearestWithError(RgbColor8_t sourceColor, uint32_t *error) {
 	uint32_t minDifference = UINT32_MAX;
 	uint32_t colorDifference = 0;
 	uint8_t result = 0;
-	for (uint8_t i = 0; i < _colorModelsSizeOf; i++) {
-		colorDifference = colorDifferenceErrorRGB(sourceColor, _colorModels[i]);
-		if (colorDifference < minDifference) {
-			minDifference = colorDifference;
-			result = i;
+	if (_colorPrototypesSizeOf > 0) {
+		// several prototypes can belong to the same class, so class of the nearest one is returned
+		for (uint8_t i = 0; i < _colorPrototypesSizeOf; i++) {
+			ColorPrototype_t prototype = colorGetPrototype(i);
+			colorDifference = colorDifferenceErrorRGB(sourceColor, prototype.color);
+			if (colorDifference < minDifference) {
+				minDifference = colorDifference;
+				result = prototype.classId;
+			}
+		}
+	} else {
+		for (uint8_t i = 0; i < _colorModelsSizeOf; i++) {
+			colorDifference = colorDifferenceErrorRGB(sourceColor, _colorModels[i]);
+			if (colorDifference < minDifference) {
+				minDifference = colorDifference;
+				result = i;
+			}
 		}
 	}
+	*error = minDifference;
 	return result;
 }
 
 RgbColor8_t colorNormalize(RgbColor16_t sourceColor) {
 	RgbColor8_t result;
-	result.r = colorNormalizeSingle(sourceColor.r, _blackLevel.r, _whiteLevel.r);
-	result.g = colorNormalizeSingle(sourceColor.g, _blackLevel.g, _whiteLevel.g);
-	result.b = colorNormalizeSingle(sourceColor.b, _blackLevel.b, _whiteLevel.b);
+	result.r = colorNormalizeSingle(sourceColor.r, _blackLevel.r, _rangeLevel.r, _scaleR);
+	result.g = colorNormalizeSingle(sourceColor.g, _blackLevel.g, _rangeLevel.g, _scaleG);
+	result.b = colorNormalizeSingle(sourceColor.b, _blackLevel.b, _rangeLevel.b, _scaleB);
 	return result;
 }
 
 RgbColor8_t colorHsvToRgb(HsvColor8_t hsv) {
 	RgbColor8_t rgb;
-	uint8_t region, p, q, t;
-	uint16_t h, s, v, remainder;
+	uint8_t region, remainder, p, q, t;
+	uint8_t h, s, v;
 
 	if (hsv.s == 0) {
 		rgb.r = hsv.v;
@@ -117,7 +212,6 @@ RgbColor8_t colorHsvToRgb(HsvColor8_t hsv) {
 		return rgb;
 	}
 
-	// converting to 16 bit to prevent overflow
 	h = hsv.h;
 	s = hsv.s;
 	v = hsv.v;
@@ -125,9 +219,10 @@ RgbColor8_t colorHsvToRgb(HsvColor8_t hsv) {
 	region = h / 43;
 	remainder = (h - (region * 43)) * 6;
 
-	p = (v * (255 - s)) >> 8;
-	q = (v * (255 - ((s * remainder) >> 8))) >> 8;
-	t = (v * (255 - ((s * (255 - remainder)) >> 8))) >> 8;
+	// 8 bit fractions, (a * b) >> 8
+	p = fxMulU8(v, 255 - s);
+	q = fxMulU8(v, 255 - fxMulU8(s, remainder));
+	t = fxMulU8(v, 255 - fxMulU8(s, 255 - remainder));
 
 	switch (region) {
 		case 0: {
@@ -170,6 +265,14 @@ RgbColor8_t colorHsvToRgb(HsvColor8_t hsv) {
 	return rgb;
 }
 
+int8_t colorHueOffset(uint8_t first, uint8_t second, uint8_t delta) {
+	// 43 * (first - second) / delta rounded towards zero, within one sixth of the hue circle
+	if (first >= second) {
+		return (int8_t)fxDivU16(fxMulU16(43, first - second), delta);
+	}
+	return -(int8_t)fxDivU16(fxMulU16(43, second - first), delta);
+}
+
 HsvColor8_t colorRgbToHsv(RgbColor8_t rgb) {
 	HsvColor8_t hsv;
 	uint8_t rgbMin, rgbMax;
@@ -184,18 +287,19 @@ HsvColor8_t colorRgbToHsv(RgbColor8_t rgb) {
 		return hsv;
 	}
 
-	hsv.s = 255 * ((long)(rgbMax - rgbMin)) / hsv.v;
+	uint8_t rgbDelta = rgbMax - rgbMin;
+	hsv.s = fxDivU16(fxMulU16(255, rgbDelta), hsv.v);
 	if (hsv.s == 0) {
 		hsv.h = 0;
 		return hsv;
 	}
 
 	if (rgbMax == rgb.r) {
-		hsv.h = 0 + 43 * (rgb.g - rgb.b) / (rgbMax - rgbMin);
-		} else if (rgbMax == rgb.g) {
-		hsv.h = 85 + 43 * (rgb.b - rgb.r) / (rgbMax - rgbMin);
-		} else {
-		hsv.h = 171 + 43 * (rgb.r - rgb.g) / (rgbMax - rgbMin);
+		hsv.h = 0 + colorHueOffset(rgb.g, rgb.b, rgbDelta);
+	} else if (rgbMax == rgb.g) {
+		hsv.h = 85 + colorHueOffset(rgb.b, rgb.r, rgbDelta);
+	} else {
+		hsv.h = 171 + colorHueOffset(rgb.r, rgb.g, rgbDelta);
 	}
 
 	return hsv;
@@ -75,6 +75,18 @@ typedef struct {
 	uint8_t v;
 } HsvColor8_t;
 
+/**
+Definition of structure for storing single prototype (reference point) of the color class.
+Several prototypes may belong to the same class, e.g. glossy and matte surface of the same color.
+With 4 bytes per prototype 64 prototypes take 256 bytes of RAM or flash.
+*/
+typedef struct {
+	/// Normalized color of the prototype.
+	RgbColor8_t color;
+	/// Number of the color class the prototype belongs to.
+	uint8_t classId;
+} ColorPrototype_t;
+
 /**
 Setts the black reference level for calculation of the normalized color value with #colorNormalize function.
 @param blackLevel Black reference level defined as 16 bit integer.
@@ -111,13 +123,52 @@ for saving memory, so these values should not be altered after setting it here.
 void colorSetModels(const RgbColor8_t *colorModels, uint8_t colorModelsAvailable);
 
 /**
-Finds nearest color from the color array defined by #colorSetModels functions.
+Defines array of color prototypes stored in RAM to be used in #colorFindNearest function.
+Once prototypes are defined, they take precedence over models defined with #colorSetModels.
+Setting prototypesAvailable to 0 restores search over color models. @n
+\b NOTE!!! Only the reference of the array is stored in the internal structures,
+so the array needs to be available as long as it's used.
+@param prototypes Array of color prototypes with number of elements at least equal prototypesAvailable.
+@param prototypesAvailable Number of prototypes in the prototypes array.
+*/
+void colorSetPrototypes(const ColorPrototype_t *prototypes, uint8_t prototypesAvailable);
+
+/**
+Defines array of color prototypes stored in program memory to be used in #colorFindNearest function.
+Works the same way as #colorSetPrototypes, but the array is read with pgm_read functions.
+@param prototypes Array of color prototypes in program memory.
+@param prototypesAvailable Number of prototypes in the prototypes array.
+*/
+void colorSetPrototypes_P(const ColorPrototype_t *prototypes, uint8_t prototypesAvailable);
+
+/**
+Calculates sum of squared differences of the color components of two colors.
+@param sourceColor First normalized color.
+@param modelColor Second normalized color.
+@result Sum of squared differences of the red, green and blue components.
+*/
+uint32_t colorDifferenceErrorRGB(RgbColor8_t sourceColor, RgbColor8_t modelColor);
+
+/**
+Finds nearest color from the color prototypes defined by #colorSetPrototypes (or #colorSetPrototypes_P)
+function or, if no prototypes are defined, from the color array defined by #colorSetModels function.
 Function uses mean square error for finding nearest color.
 @param sourceColor normalized source color.
-@result number of color in the color models table that is nearest to provided sourceColor.
+@result class number of the nearest prototype or number of color in the color models table 
+that is nearest to provided sourceColor.
 */
 uint8_t colorFindNearest(RgbColor8_t sourceColor);
 
+/**
+Works the same way as #colorFindNearest, but additionally returns the mean square error
+between sourceColor and the nearest prototype or model. Large error means that the color
+doesn't match any of the known colors.
+@param sourceColor normalized source color.
+@param error Result sum of squared differences of the color components to the nearest color.
+@result class number of the nearest prototype or number of the nearest color model.
+*/
+uint8_t colorFindNearestWithError(RgbColor8_t sourceColor, uint32_t *error);
+
 /**
 Converts color from 8-bit HSV color model to 8-bit RGB color model 
 @param hsv source color in 8-bit HSV color model
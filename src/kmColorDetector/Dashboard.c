@@ -0,0 +1,261 @@
+/*
+ * Dashboard.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "common.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/pgmspace.h>
+
+#include "Dashboard.h"
+#include "Clustering.h"
+#include "SoftwareTimer.h"
+#include "version.h"
+
+// Internal definition of types.
+// Position of the field on the screen (1-based as in escape sequences) and in the shadow copy
+typedef struct {
+	uint8_t row;
+	uint8_t col;
+	uint8_t width;
+	uint8_t offset;
+} DshFieldLayout_t;
+
+#define DSH_SHADOW_SIZE_OF 66
+#define DSH_FIELD_MAX_WIDTH 6
+// Escape sequences start with ESC [ (CSI)
+#define DSH_ESC 0x1B
+
+// "Private" global variables.
+// Labels drawn once from the top left corner, fields are blank (see the layout in Dashboard.h)
+static const char _dshLabels[] PROGMEM =
+		APP_NAME " dashboard\r\n"
+		"Raw    R:      G:      B:\r\n"
+		"Norm   R:      G:      B:\r\n"
+		"Class      Error          Confidence    %\r\n"
+		"Period       ms   Rate       /min\r\n"
+		"Measures         Unknown         Clusters      Update     B";
+
+// Indexed by DshField
+static const DshFieldLayout_t _dshLayout[DSH_FIELD_SIZE_OF] PROGMEM = {
+	{2, 10, 5, 0},
+	{2, 18, 5, 5},
+	{2, 26, 5, 10},
+	{3, 10, 5, 15},
+	{3, 18, 5, 20},
+	{3, 26, 5, 25},
+	{4, 7, 2, 30},
+	{4, 18, 6, 32},
+	{4, 38, 3, 38},
+	{5, 8, 5, 41},
+	{5, 24, 5, 46},
+	{6, 10, 5, 51},
+	{6, 26, 5, 56},
+	{6, 43, 2, 61},
+	{6, 55, 3, 63},
+};
+
+static FmtSink _dshSink = FMT_SINK_SERIAL;
+static bool _dshActive = false;
+// Characters of all fields currently shown on the screen
+static char _dshShadow[DSH_SHADOW_SIZE_OF];
+// Position of the cursor, row 0 if it's unknown
+static uint8_t _dshRow = 0;
+static uint8_t _dshCol = 0;
+// Number of bytes sent by the current and the previous update
+static uint8_t _dshBytes = 0;
+static uint8_t _dshLastBytes = 0;
+static uint32_t _dshMeasures = 0;
+static uint32_t _dshUnknown = 0;
+// Time between the last two counted measures in ms
+static uint32_t _dshPeriod = 0;
+#ifdef SWT_CLOCK
+static uint32_t _dshLastMillis = 0;
+#endif
+
+// "Private" functions.
+void dshChar(char c);
+void dshDec(uint32_t value);
+void dshMoveTo(uint8_t row, uint8_t col);
+
+// Implementation
+void dshInit(FmtSink sink) {
+	_dshSink = sink;
+	_dshActive = false;
+}
+
+void dshStart(void) {
+	// clear screen and draw labels from the home position
+	fmtString_P(_dshSink, PSTR("\x1B[2J\x1B[H"));
+	fmtString_P(_dshSink, _dshLabels);
+	// rows below the dashboard scroll, DECSTBM moves cursor home, so it's moved into the region
+	fmtString_P(_dshSink, PSTR("\x1B["));
+	fmtDec(_dshSink, DSH_ROWS + 1);
+	fmtString_P(_dshSink, PSTR("r\x1B["));
+	fmtDec(_dshSink, DSH_ROWS + 1);
+	fmtChar(_dshSink, 'H');
+	for (uint8_t i = 0; i < DSH_SHADOW_SIZE_OF; i++) {
+		_dshShadow[i] = ' ';
+	}
+	_dshMeasures = 0;
+	_dshUnknown = 0;
+	_dshPeriod = 0;
+	_dshLastBytes = 0;
+#ifdef SWT_CLOCK
+	_dshLastMillis = swtMillis();
+#endif
+	_dshActive = true;
+}
+
+void dshStop(void) {
+	// whole screen scrolls again, text continues below the dashboard
+	fmtString_P(_dshSink, PSTR("\x1B[r\x1B["));
+	fmtDec(_dshSink, DSH_ROWS + 1);
+	fmtString_P(_dshSink, PSTR("H\x1B[J"));
+	_dshActive = false;
+}
+
+bool dshActive(void) {
+	return _dshActive;
+}
+
+void dshBeginUpdate(void) {
+	_dshBytes = 0;
+	// DECSC, cursor stays in the scrolling region for the shell
+	dshChar(DSH_ESC);
+	dshChar('7');
+	_dshRow = 0;
+}
+
+void dshEndUpdate(void) {
+	// DECRC
+	dshChar(DSH_ESC);
+	dshChar('8');
+	_dshLastBytes = _dshBytes;
+}
+
+void dshSetField(DshField field, uint32_t value) {
+	DshFieldLayout_t layout;
+	memcpy_P(&layout, &_dshLayout[field], sizeof(layout));
+	// right aligned text of the value, '*' if it doesn't fit
+	char buf[FMT_BUFFER_SIZE_OF];
+	char text[DSH_FIELD_MAX_WIDTH];
+	char *digits = fmtDecToBuffer(buf, value);
+	uint8_t length = &buf[FMT_BUFFER_SIZE_OF - 1] - digits;
+	for (uint8_t i = 0; i < layout.width; i++) {
+		if (length > layout.width) {
+			text[i] = '*';
+		} else if (i < layout.width - length) {
+			text[i] = ' ';
+		} else {
+			text[i] = *digits++;
+		}
+	}
+	// only the range between the first and the last changed character is sent
+	char *shadow = &_dshShadow[layout.offset];
+	uint8_t first = 0;
+	while (first < layout.width && text[first] == shadow[first]) {
+		first++;
+	}
+	if (first == layout.width) {
+		return;
+	}
+	uint8_t last = layout.width - 1;
+	while (text[last] == shadow[last]) {
+		last--;
+	}
+	dshMoveTo(layout.row, layout.col + first);
+	for (uint8_t i = first; i <= last; i++) {
+		dshChar(text[i]);
+		shadow[i] = text[i];
+	}
+	_dshCol += last - first + 1;
+}
+
+void dshCountMeasure(uint32_t colorError) {
+	_dshMeasures++;
+	if (colorError > KMCD_UNKNOWN_COLOR_ERROR) {
+		_dshUnknown++;
+	}
+#ifdef SWT_CLOCK
+	uint32_t now = swtMillis();
+	_dshPeriod = now - _dshLastMillis;
+	_dshLastMillis = now;
+#endif
+}
+
+void dshUpdateMeasure(RgbColor16_t raw, RgbColor8_t norm, uint8_t colorClass, uint32_t colorError) {
+	uint32_t period = _dshPeriod;
+	dshBeginUpdate();
+	dshSetField(DSH_FIELD_RAW_R, raw.r);
+	dshSetField(DSH_FIELD_RAW_G, raw.g);
+	dshSetField(DSH_FIELD_RAW_B, raw.b);
+	dshSetField(DSH_FIELD_NORM_R, norm.r);
+	dshSetField(DSH_FIELD_NORM_G, norm.g);
+	dshSetField(DSH_FIELD_NORM_B, norm.b);
+	dshSetField(DSH_FIELD_CLASS, colorClass);
+	dshSetField(DSH_FIELD_ERROR, colorError);
+	// confidence falls linearly from 100% for exact match to 0% at the limit of unknown color
+	dshSetField(DSH_FIELD_CONFIDENCE, colorError >= KMCD_UNKNOWN_COLOR_ERROR ? 0 :
+			100 - colorError * 100 / KMCD_UNKNOWN_COLOR_ERROR);
+	dshSetField(DSH_FIELD_PERIOD, period);
+	dshSetField(DSH_FIELD_RATE, 0 == period ? 0 : 60000 / period);
+	dshSetField(DSH_FIELD_MEASURES, _dshMeasures);
+	dshSetField(DSH_FIELD_UNKNOWN, _dshUnknown);
+	dshSetField(DSH_FIELD_CLUSTERS, cluGetClustersCount());
+	dshSetField(DSH_FIELD_UPDATE, _dshLastBytes);
+	dshEndUpdate();
+}
+
+void dshChar(char c) {
+	fmtChar(_dshSink, c);
+	_dshBytes++;
+}
+
+void dshDec(uint32_t value) {
+	char buf[FMT_BUFFER_SIZE_OF];
+	for (char *str = fmtDecToBuffer(buf, value); '\0' != *str; str++) {
+		dshChar(*str);
+	}
+}
+
+void dshMoveTo(uint8_t row, uint8_t col) {
+	if (row == _dshRow && col == _dshCol) {
+		return;
+	}
+	dshChar(DSH_ESC);
+	dshChar('[');
+	if (row == _dshRow && col > _dshCol) {
+		// CUF is always shorter than CUP on the same row
+		dshDec(col - _dshCol);
+		dshChar('C');
+	} else {
+		dshDec(row);
+		dshChar(';');
+		dshDec(col);
+		dshChar('H');
+	}
+	_dshRow = row;
+	_dshCol = col;
+}
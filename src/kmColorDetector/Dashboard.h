@@ -0,0 +1,139 @@
+/** @file
+ * @brief Live terminal dashboard of measures updated with cursor addressing escape sequences.
+ * Dashboard.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Labels are drawn once by #dshStart, every measure then only rewrites the characters of the fields
+ *  which differ from the shadow copy of the screen kept in RAM. Cursor is moved with CUP (ESC[row;colH)
+ *  or with shorter CUF (ESC[nC) when the next change is on the same row, so typical update takes
+ *  20-40 bytes instead of ~90 bytes of the measure line and dashboard stays live at 9600 baud.
+ *  Rows below the dashboard are the scrolling region (DECSTBM) for replies of the shell,
+ *  cursor position in this region is saved (DECSC) and restored (DECRC) around every update.
+ *
+ *  Layout (fields are right aligned, '*' is shown when the value doesn't fit):
+ *  @verbatim
+    kmColDecDR dashboard
+    Raw    R:      G:      B:
+    Norm   R:      G:      B:
+    Class      Error          Confidence    %
+    Period       ms   Rate       /min
+    Measures         Unknown         Clusters      Update     B
+    @endverbatim
+ *
+ *  References:
+ * -# https://vt100.net/docs/vt100-ug/chapter3.html
+ * -# https://en.wikipedia.org/wiki/ANSI_escape_code
+ */
+
+#ifndef DASHBOARD_H_
+#define DASHBOARD_H_
+
+#include "common.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ColorTools.h"
+#include "Format.h"
+
+/// Number of rows used by the dashboard, shell replies scroll below them
+#define DSH_ROWS 7
+
+/// Fields of the dashboard.
+typedef enum {
+	DSH_FIELD_RAW_R = 0,
+	DSH_FIELD_RAW_G,
+	DSH_FIELD_RAW_B,
+	DSH_FIELD_NORM_R,
+	DSH_FIELD_NORM_G,
+	DSH_FIELD_NORM_B,
+	DSH_FIELD_CLASS,
+	DSH_FIELD_ERROR,
+	DSH_FIELD_CONFIDENCE,
+	DSH_FIELD_PERIOD,
+	DSH_FIELD_RATE,
+	DSH_FIELD_MEASURES,
+	DSH_FIELD_UNKNOWN,
+	DSH_FIELD_CLUSTERS,
+	/// Number of bytes sent by the previous update
+	DSH_FIELD_UPDATE,
+	DSH_FIELD_SIZE_OF
+} DshField;
+
+/**
+Initializes dashboard, it's inactive until #dshStart is called.
+@param sink Destination of the dashboard, it has to be a terminal interpreting ANSI escape sequences.
+*/
+void dshInit(FmtSink sink);
+
+/**
+Clears the screen, draws labels of the fields and resets counters.
+All fields are sent with the next update.
+*/
+void dshStart(void);
+
+/**
+Releases the scrolling region and moves cursor below the dashboard, so text lines can follow.
+*/
+void dshStop(void);
+
+/**
+Returns if the dashboard is shown.
+@result true between #dshStart and #dshStop.
+*/
+bool dshActive(void);
+
+/**
+Sets the value of the field, only characters different from the shown ones are sent.
+Has to be called between #dshBeginUpdate and #dshEndUpdate.
+@param field Field to be set.
+@param value New value of the field.
+*/
+void dshSetField(DshField field, uint32_t value);
+
+/**
+Saves position of the cursor in the scrolling region before fields are set.
+*/
+void dshBeginUpdate(void);
+
+/**
+Restores position of the cursor in the scrolling region after fields are set.
+*/
+void dshEndUpdate(void);
+
+/**
+Counts the finished measure in counters and rates shown by #dshUpdateMeasure,
+so measures not shown while serial is busy are counted as well.
+@param colorError Error of the color to the nearest prototype, see #KMCD_UNKNOWN_COLOR_ERROR.
+*/
+void dshCountMeasure(uint32_t colorError);
+
+/**
+Updates all fields with the measure, counters and rates are taken from #dshCountMeasure.
+@param raw Raw color from the sensor.
+@param norm Normalized (and smoothed) color.
+@param colorClass Class of the color.
+@param colorError Error of the color to the nearest prototype, see #KMCD_UNKNOWN_COLOR_ERROR.
+*/
+void dshUpdateMeasure(RgbColor16_t raw, RgbColor8_t norm, uint8_t colorClass, uint32_t colorError);
+
+#endif /* DASHBOARD_H_ */
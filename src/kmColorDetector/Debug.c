@@ -23,17 +23,32 @@
  *
  */
 
+#include <stdbool.h>
 #include <avr/io.h>
+#include <avr/pgmspace.h>
 
 #include "Debug.h"
+#include "Format.h"
 #include "ColorTools.h"
 #include "Serial.h"
 #include "Sensor.h"
+#include "Training.h"
+#include "Clustering.h"
+#include "Events.h"
+#include "SoftwareTimer.h"
 
 #ifndef KMCD_NO_LCD
 #include "LiquidCrystal.h"
 #endif
 
+// "Private" functions.
+void dbMeasureToSink(FmtSink sink);
+void dbMeasurePartToSink(FmtSink sink, RgbColor16_t colorOrg, uint8_t part);
+void dbTripletToSink(FmtSink sink, const char *names, uint16_t first, uint16_t second, uint16_t third,
+        bool hex, const char *separator);
+
+// Implementation
+
 void dbPullUpAllPorts(void) {
     // PULL UP all ports
 #ifdef PORTA
@@ -136,52 +151,89 @@ void dbToggle(uint8_t pin) {
 
 void dbMeasureToSerial(void)  {
 #ifndef KMCD_NO_SERIAL_DEBUG
+    dbMeasureToSink(FMT_SINK_SERIAL);
+#endif
+}
+
+void dbMeasureToSoftSerial(void) {
+#ifdef KMCD_SOFT_SERIAL_DEBUG
+    dbMeasureToSink(FMT_SINK_SOFT_SERIAL);
+#endif
+}
+
+void dbMeasurePartToSerial(RgbColor16_t colorOrg, uint8_t part) {
+#ifndef KMCD_NO_SERIAL_DEBUG
+    dbMeasurePartToSink(FMT_SINK_SERIAL, colorOrg, part);
+#endif
+}
+
+void dbMeasureToSink(FmtSink sink) {
+#if !defined(KMCD_NO_SERIAL_DEBUG) || defined(KMCD_SOFT_SERIAL_DEBUG)
     RgbColor16_t colorOrg = tscGetColor();
+    for (uint8_t part = 0; part < DB_MEASURE_PARTS_SIZE_OF; part++) {
+        dbMeasurePartToSink(sink, colorOrg, part);
+    }
+#endif
+}
+
+void dbMeasurePartToSink(FmtSink sink, RgbColor16_t colorOrg, uint8_t part) {
+#if !defined(KMCD_NO_SERIAL_DEBUG) || defined(KMCD_SOFT_SERIAL_DEBUG)
+    // normalized values are computed again for each part, it's cheaper than keeping them for the whole line
     RgbColor8_t colorNorm = colorNormalize(colorOrg);
-    HsvColor8_t colorHsv = colorRgbToHsv(colorNorm);
+    if (0 == part) {
+        fmtString_P(sink, PSTR("colorOrg "));
+        dbTripletToSink(sink, PSTR("RGB"), colorOrg.r, colorOrg.g, colorOrg.b, true, PSTR(", "));
+        return;
+    }
+    if (1 == part) {
+        fmtString_P(sink, PSTR("; colorNorm "));
+        dbTripletToSink(sink, PSTR("RGB"), colorNorm.r, colorNorm.g, colorNorm.b, true, PSTR(", "));
+        return;
+    }
+    if (2 == part) {
+        HsvColor8_t colorHsv = colorRgbToHsv(colorNorm);
+        fmtString_P(sink, PSTR("; colorHSV "));
+        dbTripletToSink(sink, PSTR("HSV"), colorHsv.h, colorHsv.s, colorHsv.v, true, PSTR(", "));
+        return;
+    }
     uint8_t colorNumber = colorFindNearest(colorNorm);
-    char tmpBuffer[40];
-    sprintf(tmpBuffer, "colorOrg R:%X, G:%X, B:%X; ", colorOrg.r, colorOrg.g, colorOrg.b);
-    serPrintString(tmpBuffer);
-    sprintf(tmpBuffer, "colorNorm R:%X, G:%X, B:%X; ", colorNorm.r, colorNorm.g, colorNorm.b);
-    serPrintString(tmpBuffer);
-    sprintf(tmpBuffer, "colorHSV H:%X, S:%X, V:%X; ", colorHsv.s, colorHsv.h, colorHsv.v);
-    serPrintString(tmpBuffer);
+    fmtString_P(sink, PSTR("; "));
 
     switch (colorNumber) {
         case 0 : {
-            serPrintLnString_P(KMCD_COLOR_WHITE);
+            fmtString_P(sink, KMCD_COLOR_WHITE);
             break;
         }
         case 1 : {
-            serPrintLnString_P(KMCD_COLOR_BLACK);
+            fmtString_P(sink, KMCD_COLOR_BLACK);
             break;
         }
         case 2 : {
-            serPrintLnString_P(KMCD_COLOR_BLUE);
+            fmtString_P(sink, KMCD_COLOR_BLUE);
             break;
         }
         case 3 : {
-            serPrintLnString_P(KMCD_COLOR_GREEN);
+            fmtString_P(sink, KMCD_COLOR_GREEN);
             break;
         }
         case 4 : {
-            serPrintLnString_P(KMCD_COLOR_RED);
+            fmtString_P(sink, KMCD_COLOR_RED);
             break;
         }
         case 5 : {
-            serPrintLnString_P(KMCD_COLOR_YELLOW);
+            fmtString_P(sink, KMCD_COLOR_YELLOW);
             break;
         }
         case 6 : {
-            serPrintLnString_P(KMCD_COLOR_BROWN);
+            fmtString_P(sink, KMCD_COLOR_BROWN);
             break;
         }
         case 7 : {
-            serPrintLnString_P(KMCD_COLOR_ORANGE);
+            fmtString_P(sink, KMCD_COLOR_ORANGE);
             break;
         }
     }
+    fmtString_P(sink, PSTR("\r\n"));
 #endif
 }
 
@@ -190,11 +242,9 @@ void dbMeasureToLCD(void)  {
     RgbColor16_t colorOrg = tscGetColor();
     RgbColor8_t colorNorm = colorNormalize(colorOrg);
     uint8_t colorNumber = colorFindNearest(colorNorm);
-    char tmpBuffer[40];
-    sprintf(tmpBuffer, "R:%X,G:%X,B:%X", colorNorm.r, colorNorm.g, colorNorm.b);
 
     lcdSetCursor(0, 0);
-    lcdPrint(tmpBuffer);
+    dbTripletToSink(FMT_SINK_LCD, PSTR("RGB"), colorNorm.r, colorNorm.g, colorNorm.b, true, PSTR(","));
     lcdFillSpacesToEndOfTheLine();
 
     lcdSetCursor(0, 1);
@@ -237,4 +287,124 @@ void dbMeasureToLCD(void)  {
     }
     lcdFillSpacesToEndOfTheLine();
 #endif
-}
\ No newline at end of file
+}
+
+void dbTrainingToSerial(void) {
+#ifndef KMCD_NO_SERIAL_DEBUG
+    for (uint8_t part = 0; part < DB_TRAINING_PARTS_SIZE_OF; part++) {
+        dbTrainingPartToSerial(part);
+    }
+#endif
+}
+
+void dbTrainingPartToSerial(uint8_t part) {
+#ifndef KMCD_NO_SERIAL_DEBUG
+    if (0 == part) {
+        RgbColor8_t mean = trnGetMean();
+        serPrintString_P(KMCD_TRAINING_CLASS);
+        serWriteChar('0' + trnGetClass());
+        serPrintString_P(PSTR("; "));
+        serPrintString_P(KMCD_TRAINING_SAMPLES);
+        fmtDec(FMT_SINK_SERIAL, trnGetSamplesCount());
+        serPrintString_P(PSTR("; mean "));
+        dbTripletToSink(FMT_SINK_SERIAL, PSTR("RGB"), mean.r, mean.g, mean.b, true, PSTR(", "));
+        return;
+    }
+    RgbColor16_t variance = trnGetVariance();
+    serPrintString_P(PSTR("; var "));
+    dbTripletToSink(FMT_SINK_SERIAL, PSTR("RGB"), variance.r, variance.g, variance.b, false, PSTR(", "));
+    serPrintLn();
+#endif
+}
+
+void dbTrainingToLCD(void) {
+#ifndef KMCD_NO_LCD
+    RgbColor8_t mean = trnGetMean();
+
+    lcdSetCursor(0, 0);
+    dbTripletToSink(FMT_SINK_LCD, PSTR("RGB"), mean.r, mean.g, mean.b, true, PSTR(","));
+    lcdFillSpacesToEndOfTheLine();
+
+    lcdSetCursor(0, 1);
+    lcdPrint_P(PSTR("T"));
+    lcdWrite('0' + trnGetClass());
+    lcdPrint_P(PSTR(": "));
+    fmtDec(FMT_SINK_LCD, trnGetSamplesCount());
+    lcdFillSpacesToEndOfTheLine();
+#endif
+}
+
+void dbClustersToSerial(void) {
+#ifndef KMCD_NO_SERIAL_DEBUG
+    serPrintString_P(KMCD_CLUSTERS);
+    fmtDec(FMT_SINK_SERIAL, cluGetClustersCount());
+    serPrintLn();
+    for (uint8_t i = 0; i < cluGetClustersCount(); i++) {
+        CluCandidate_t candidate = cluGetCandidate(i);
+        serWriteChar('K');
+        fmtDec(FMT_SINK_SERIAL, i);
+        serWriteChar(' ');
+        dbTripletToSink(FMT_SINK_SERIAL, PSTR("RGB"), candidate.color.r, candidate.color.g, candidate.color.b,
+                true, PSTR(", "));
+        serPrintString_P(PSTR("; "));
+        serPrintString_P(KMCD_TRAINING_SAMPLES);
+        fmtDec(FMT_SINK_SERIAL, candidate.count);
+        serPrintLn();
+    }
+#endif
+}
+
+void dbEventsToSerial(void) {
+#if !defined(KMCD_NO_SERIAL_DEBUG) && defined(EVT_LATENCY_STATS)
+    serPrintLnString_P(KMCD_EVENTS_LATENCY);
+    for (uint8_t i = 0; i < EVT_SIZE_OF; i++) {
+        serWriteChar('E');
+        fmtDec(FMT_SINK_SERIAL, i);
+        serPrintString_P(PSTR(": "));
+        fmtDec(FMT_SINK_SERIAL, evtGetMaxLatency((EvtType)i));
+        serPrintLnString_P(PSTR(" us"));
+    }
+#endif
+}
+
+void dbTimersToSerial(void) {
+#if !defined(KMCD_NO_SERIAL_DEBUG) && defined(SWT_STATS)
+    serPrintLnString_P(KMCD_TIMERS_STATS);
+    for (uint8_t i = 0; i < SWT_SIZE_OF; i++) {
+        SwtStats_t stats = swtGetStats(i);
+        serWriteChar('T');
+        fmtDec(FMT_SINK_SERIAL, i);
+        serPrintString_P(PSTR(": "));
+        fmtDec(FMT_SINK_SERIAL, stats.latenessMin);
+        serWriteChar('/');
+        fmtDec(FMT_SINK_SERIAL, stats.latenessMax);
+        serWriteChar('/');
+        fmtDec(FMT_SINK_SERIAL, stats.latenessMean);
+        serPrintString_P(PSTR(", "));
+        fmtDec(FMT_SINK_SERIAL, stats.durationMax);
+        serWriteChar('/');
+        fmtDec(FMT_SINK_SERIAL, stats.durationMean);
+        serPrintString_P(PSTR("; n="));
+        fmtDec(FMT_SINK_SERIAL, stats.dispatches);
+        serPrintLn();
+    }
+#endif
+}
+
+void dbTripletToSink(FmtSink sink, const char *names, uint16_t first, uint16_t second, uint16_t third,
+        bool hex, const char *separator) {
+    // names in program memory, one character per value, e.g. "RGB"
+    uint16_t values[3] = {first, second, third};
+    for (uint8_t i = 0; i < 3; i++) {
+        if (i > 0) {
+            fmtString_P(sink, separator);
+        }
+        fmtChar(sink, pgm_read_byte(&names[i]));
+        fmtChar(sink, ':');
+        if (true == hex) {
+            fmtHex(sink, values[i]);
+        } else {
+            fmtDec(sink, values[i]);
+        }
+    }
+}
@@ -32,6 +32,23 @@
 
 #include "common.h"
 
+#include <stdint.h>
+
+#include "ColorTools.h"
+
+/// Parts of the line printed by #dbMeasurePartToSerial.
+#define DB_MEASURE_PARTS_SIZE_OF 4
+/// The most bytes copied to serial transmission buffer by single part of the measure line, see #serWritable.
+#define DB_MEASURE_PART_BYTES 18
+/// The most serial transfers queued by single part of the measure line.
+#define DB_MEASURE_PART_TRANSFERS 6
+/// Parts of the line printed by #dbTrainingPartToSerial.
+#define DB_TRAINING_PARTS_SIZE_OF 2
+/// The most bytes copied to serial transmission buffer by single part of the training line.
+#define DB_TRAINING_PART_BYTES 21
+/// The most serial transfers queued by single part of the training line.
+#define DB_TRAINING_PART_TRANSFERS 11
+
 /**
 Initializes all ports to pull-up state.
 \b NOTE: This method should be issued first in the main routine
@@ -61,10 +78,61 @@ This function uses Serial.h functions.
 */
 void dbMeasureToSerial(void);
 
+/**
+Send part of the line printed by #dbMeasureToSerial, so event handlers can print it without waiting
+for serial transmission, see #serWritable.
+@param colorOrg Raw color measure, the same one for all parts of the line.
+@param part Part of the line, from 0 to DB_MEASURE_PARTS_SIZE_OF - 1.
+*/
+void dbMeasurePartToSerial(RgbColor16_t colorOrg, uint8_t part);
+
+/**
+Send measure information in the same format as #dbMeasureToSerial to software UART if available.
+This function uses SoftSerial.h functions and requires KMCD_SOFT_SERIAL_DEBUG.
+*/
+void dbMeasureToSoftSerial(void);
+
 /**
 Send current color measure to LCD if available.
 This function uses LiquidCrystal.h functions
 */
 void dbMeasureToLCD(void);
 
+/**
+Send current state of the color model training to serial interface if available.
+This function uses Serial.h and Training.h functions.
+*/
+void dbTrainingToSerial(void);
+
+/**
+Send part of the line printed by #dbTrainingToSerial, see #dbMeasurePartToSerial.
+Statistics of the training are read when the part is printed.
+@param part Part of the line, from 0 to DB_TRAINING_PARTS_SIZE_OF - 1.
+*/
+void dbTrainingPartToSerial(uint8_t part);
+
+/**
+Send current state of the color model training to LCD if available.
+This function uses LiquidCrystal.h and Training.h functions.
+*/
+void dbTrainingToLCD(void);
+
+/**
+Send candidate clusters of unknown colors with their counts to serial interface if available.
+This function uses Serial.h and Clustering.h functions.
+*/
+void dbClustersToSerial(void);
+
+/**
+Send maximum latencies of events in microseconds to serial interface if available.
+This function uses Serial.h and Events.h functions and requires EVT_LATENCY_STATS.
+*/
+void dbEventsToSerial(void);
+
+/**
+Send dispatch lateness and callback duration of software timers in Timer2 counts to serial interface if available.
+This function uses Serial.h and SoftwareTimer.h functions and requires SWT_STATS.
+*/
+void dbTimersToSerial(void);
+
 #endif /* DEBUG_H_ */
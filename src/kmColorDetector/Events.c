@@ -0,0 +1,120 @@
+/*
+ * Events.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#include "config.h"
+#include "Events.h"
+#ifdef EVT_LATENCY_STATS
+#include "SoftwareTimer.h"
+
+#ifndef SWT_CLOCK
+#error "EVT_LATENCY_STATS requires swtMicros clock, define SWT_CLOCK"
+#endif
+#endif
+
+// "Private" global variables.
+// Each bit is one pending event, bit 0 has the highest priority
+static volatile uint8_t _evtPending = 0;
+static EvtHandler *_evtHandlers[EVT_SIZE_OF];
+#ifdef EVT_LATENCY_STATS
+static volatile uint32_t _evtPostedAt[EVT_SIZE_OF];
+static uint32_t _evtMaxLatency[EVT_SIZE_OF];
+#endif
+
+// Implementation
+void evtInit(void) {
+	_evtPending = 0;
+	for (uint8_t i = 0; i < EVT_SIZE_OF; i++) {
+		_evtHandlers[i] = NULL;
+	}
+#ifdef EVT_LATENCY_STATS
+	evtResetLatency();
+#endif
+}
+
+void evtRegisterHandler(EvtType event, EvtHandler *handler) {
+	_evtHandlers[event] = handler;
+}
+
+void evtPost(EvtType event) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+#ifdef EVT_LATENCY_STATS
+		if (0 == (_evtPending & _BV(event))) {
+			// merged events are measured from the first post
+			_evtPostedAt[event] = swtMicros();
+		}
+#endif
+		_evtPending |= _BV(event);
+	}
+}
+
+bool evtPending(void) {
+	return 0 != _evtPending;
+}
+
+void evtLoop(void) {
+	while (0 != _evtPending) {
+		// find the pending event of the highest priority
+		uint8_t event = 0;
+		while (0 == (_evtPending & _BV(event))) {
+			event++;
+		}
+#ifdef EVT_LATENCY_STATS
+		uint32_t postedAt;
+#endif
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			// cleared before the handler is run, so event posted meanwhile is not lost
+			_evtPending &= ~_BV(event);
+#ifdef EVT_LATENCY_STATS
+			postedAt = _evtPostedAt[event];
+#endif
+		}
+#ifdef EVT_LATENCY_STATS
+		uint32_t latency = swtMicros() - postedAt;
+		if (latency > _evtMaxLatency[event]) {
+			_evtMaxLatency[event] = latency;
+		}
+#endif
+		if (NULL != _evtHandlers[event]) {
+			_evtHandlers[event]();
+		}
+	}
+}
+
+#ifdef EVT_LATENCY_STATS
+uint32_t evtGetMaxLatency(EvtType event) {
+	return _evtMaxLatency[event];
+}
+
+void evtResetLatency(void) {
+	for (uint8_t i = 0; i < EVT_SIZE_OF; i++) {
+		_evtMaxLatency[i] = 0;
+	}
+}
+#endif
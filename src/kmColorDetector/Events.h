@@ -0,0 +1,109 @@
+/** @file
+ * @brief Event queue with priorities running handlers to completion.
+ * Events.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+#include "common.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+Events known to the application. Lower value means higher priority,
+e.g. finished measure is always handled before bytes received from serial.
+*/
+typedef enum {
+	/// Color sensor finished the measure, posted from Timer1 interrupt.
+	EVT_MEASURE_DONE = 0,
+	/// Software timer expired, posted from Timer2 interrupt.
+	EVT_TIMER_EXPIRED = 1,
+	/// Measure is requested with button or serial command.
+	EVT_BUTTON = 2,
+	/// Byte received from serial, posted from USART interrupt.
+	EVT_SERIAL_RX = 3,
+	/// Trace message stored, its frame waits to be queued for serial transmission.
+	EVT_TRACE = 4,
+	/// Transmit queue of serial is empty, posted from USART interrupt.
+	EVT_SERIAL_TX = 5
+} EvtType;
+
+/// Maximum number of events, each one is represented by single bit.
+#define EVT_SIZE_OF 8
+
+/**
+Definition of the event handler. Handler should consume all data related to
+the event, since events posted several times before handling are merged into one.
+*/
+typedef void EvtHandler(void);
+
+/**
+Initialization of the event queue, clears all pending events and handlers.
+Following definitions to be set in config.h file @n
+#define \b EVT_LATENCY_STATS \\ Enables measurement of maximum time between post and handling of each event.@n
+*/
+void evtInit(void);
+
+/**
+Registers handler of specific event.
+@param event Event to be handled.
+@param handler Function run by #evtLoop when the event is pending.
+*/
+void evtRegisterHandler(EvtType event, EvtHandler *handler);
+
+/**
+Marks event as pending. Safe to be called from interrupts and from the main loop.
+@param event Event to be posted.
+*/
+void evtPost(EvtType event);
+
+/**
+Checks if any event is waiting for handling.
+@result true if at least one event is pending.
+*/
+bool evtPending(void);
+
+/**
+To be issued in the main loop. Runs handlers of pending events one by one,
+always starting from the event of the highest priority, until none is pending.
+*/
+void evtLoop(void);
+
+#ifdef EVT_LATENCY_STATS
+/**
+Returns the longest time between post of the event and start of its handler since the last reset.
+Resolution is single Timer2 count of #swtMicros clock (~93us).
+@param event Event to be checked.
+@result Maximum latency in microseconds.
+*/
+uint32_t evtGetMaxLatency(EvtType event);
+
+/**
+Resets the latency statistics of all events.
+*/
+void evtResetLatency(void);
+#endif
+
+#endif /* EVENTS_H_ */
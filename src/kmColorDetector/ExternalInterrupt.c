@@ -34,11 +34,14 @@ ExtIntCallback *_extIntCallback0 = NULL;
 ExtIntCallback *_extIntCallback1 = NULL;
 void *_extIntUserData0 = NULL;
 void *_extIntUserData1 = NULL;
+ExtIntCallback *_extIntCallback2 = NULL;
+void *_extIntUserData2 = NULL;
 
 void extIntRegisterCallback(ExtIntType type, ExtIntSense sense, bool pullup, ExtIntCallback *callback, void *userData) {
 	switch (type) {
 		case EXT_INT_0 : {
 			_extIntCallback0 = callback;
+			_extIntUserData0 = userData;
 			// Set pin as input (Using for interrupt INT0)
 			EXT_INT_DDR &= ~_BV(EXT_INT_PIN_0);
 			// Enable PD2 pull-up resistor
@@ -71,9 +74,10 @@ void extIntRegisterCallback(ExtIntType type, ExtIntSense sense, bool pullup, Ext
 		}
 		case EXT_INT_1 : {
 			_extIntCallback1 = callback;
-			// Set pin as input (Using for interrupt INT0)
+			_extIntUserData1 = userData;
+			// Set pin as input (Using for interrupt INT1)
 			EXT_INT_DDR &= ~_BV(EXT_INT_PIN_1);
-			// Enable PD2 pull-up resistor
+			// Enable PD3 pull-up resistor
 			if (pullup == true) {
 				EXT_INT_PORT |= _BV(EXT_INT_PIN_1);
 				} else {
@@ -98,10 +102,33 @@ void extIntRegisterCallback(ExtIntType type, ExtIntSense sense, bool pullup, Ext
 					MCUCR |= EXT_INT_CONF_1_LOW_LEVEL;
 				}
 			}
-			GICR |= _BV(INT0);
+			GICR |= _BV(INT1);
 			break;
 
 		}
+		case EXT_INT_2 : {
+			// Interrupt has to be disabled while its sense is changed
+			GICR &= ~_BV(INT2);
+			_extIntCallback2 = callback;
+			_extIntUserData2 = userData;
+			// Set pin as input (Using for interrupt INT2)
+			EXT_INT_2_DDR &= ~_BV(EXT_INT_PIN_2);
+			// Enable PB2 pull-up resistor
+			if (pullup == true) {
+				EXT_INT_2_PORT |= _BV(EXT_INT_PIN_2);
+				} else {
+				EXT_INT_2_PORT &= ~_BV(EXT_INT_PIN_2);
+			}
+			if (EXT_INT_RISING_EDGE == sense) {
+				MCUCSR |= _BV(ISC2);
+			} else {
+				MCUCSR &= ~_BV(ISC2);
+			}
+			// Changing the sense can set the flag, so clear it before enabling
+			GIFR = _BV(INTF2);
+			GICR |= _BV(INT2);
+			break;
+		}
 		// no default
 	}
 }
@@ -116,6 +143,10 @@ void extIntDisable(ExtIntType type) {
 			GICR &= ~_BV(INT1);
 			break;
 		}
+		case EXT_INT_2 : {
+			GICR &= ~_BV(INT2);
+			break;
+		}
 		// no default
 	}
 }
@@ -131,3 +162,9 @@ ISR(INT1_vect) {
 		_extIntCallback1(_extIntUserData1);
 	}
 }
+
+ISR(INT2_vect) {
+	if (_extIntCallback2 != NULL) {
+		_extIntCallback2(_extIntUserData2);
+	}
+}
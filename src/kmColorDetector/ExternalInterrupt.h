@@ -56,7 +56,10 @@ typedef enum {
 	/// External interrupt 0 (available on PIN PD2 for ATmega32)
 	EXT_INT_0,
 	/// External interrupt 1 (available on PIN PD3 for ATmega32)
-	EXT_INT_1
+	EXT_INT_1,
+	/// External interrupt 2 (available on PIN PB2 for ATmega32), edge sense only,
+	/// but contrary to #EXT_INT_0 and #EXT_INT_1 the edge wakes up uC from power-down
+	EXT_INT_2
 } ExtIntType;
 
 /**
@@ -68,8 +71,9 @@ typedef void ExtIntCallback(void *);
 
 /**
 Register and enable External Interrupt.
-@param type Type of the interrupt, either #EXT_INT_0 or #EXT_INT_1.
-@param sense Sense of the signal issuing interrupt.
+@param type Type of the interrupt, one of #EXT_INT_0, #EXT_INT_1 or #EXT_INT_2.
+@param sense Sense of the signal issuing interrupt. For #EXT_INT_2 only #EXT_INT_RISING_EDGE
+and #EXT_INT_FALLING_EDGE are available, any other sense is treated as falling edge.
 @param pullup If true, the specific pin is going to be set to pull-up input.
 @param callback Pointer to the callback function to be issued on the specific interrupt.
 @param userData User data void pointer to structure to be delivered to callback "as-is".
@@ -78,7 +82,7 @@ void extIntRegisterCallback(ExtIntType type, ExtIntSense sense, bool pullup, Ext
 
 /**
 Disable specific external interrupt, so it's not called anymore.
-@param type Type of the interrupt, either #EXT_INT_0 or #EXT_INT_1.
+@param type Type of the interrupt, one of #EXT_INT_0, #EXT_INT_1 or #EXT_INT_2.
 */
 void extIntDisable(ExtIntType type);
 
@@ -34,6 +34,12 @@
 #define EXT_INT_PIN_0 PD2
 /// Port pin for External Interrupt 1
 #define EXT_INT_PIN_1 PD3
+/// Direction register for External Interrupt 2 Pin
+#define EXT_INT_2_DDR DDRB
+/// Port register for External Interrupt 2 Pin
+#define EXT_INT_2_PORT PORTB
+/// Port pin for External Interrupt 2
+#define EXT_INT_PIN_2 PB2
 
 /// Definition of the configuration bits for External Interrupt 0 - Low Level Sense
 #define EXT_INT_CONF_0_LOW_LEVEL		0x00
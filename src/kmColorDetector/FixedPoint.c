@@ -0,0 +1,213 @@
+/*
+ * FixedPoint.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "FixedPoint.h"
+
+// Internal definition of types.
+// Number of entries in the reciprocal seed table, indexed by 7 bits below MSB of normalized divisor
+#define FX_RECIP_TABLE_SIZE_OF 128
+
+// "Private" global variables.
+// round(2^31 / n) for n in the middle of each of 128 intervals of [0x8000, 0xFFFF]
+static const uint16_t _fxRecipTable[FX_RECIP_TABLE_SIZE_OF] PROGMEM = {
+	0xFF01, 0xFD09, 0xFB19, 0xF930, 0xF74E, 0xF574, 0xF3A1, 0xF1D5,
+	0xF00F, 0xEE50, 0xEC98, 0xEAE5, 0xE939, 0xE793, 0xE5F3, 0xE459,
+	0xE2C5, 0xE136, 0xDFAC, 0xDE28, 0xDCA9, 0xDB2F, 0xD9BA, 0xD84A,
+	0xD6DF, 0xD579, 0xD417, 0xD2BA, 0xD161, 0xD00D, 0xCEBD, 0xCD71,
+	0xCC29, 0xCAE6, 0xC9A6, 0xC86A, 0xC733, 0xC5FE, 0xC4CE, 0xC3A1,
+	0xC278, 0xC152, 0xC030, 0xBF11, 0xBDF6, 0xBCDD, 0xBBC8, 0xBAB6,
+	0xB9A8, 0xB89C, 0xB793, 0xB68D, 0xB58A, 0xB48A, 0xB38D, 0xB292,
+	0xB19B, 0xB0A6, 0xAFB3, 0xAEC3, 0xADD6, 0xACEB, 0xAC03, 0xAB1D,
+	0xAA39, 0xA958, 0xA879, 0xA79C, 0xA6C2, 0xA5EA, 0xA514, 0xA440,
+	0xA36E, 0xA29F, 0xA1D1, 0xA106, 0xA03C, 0x9F74, 0x9EAF, 0x9DEB,
+	0x9D29, 0x9C69, 0x9BAB, 0x9AEE, 0x9A34, 0x997B, 0x98C4, 0x980E,
+	0x975A, 0x96A8, 0x95F8, 0x9549, 0x949C, 0x93F0, 0x9346, 0x929D,
+	0x91F6, 0x9150, 0x90AC, 0x9009, 0x8F68, 0x8EC8, 0x8E29, 0x8D8C,
+	0x8CF0, 0x8C56, 0x8BBC, 0x8B24, 0x8A8E, 0x89F8, 0x8964, 0x88D2,
+	0x8840, 0x87AF, 0x8720, 0x8692, 0x8605, 0x8579, 0x84EF, 0x8465,
+	0x83DD, 0x8356, 0x82CF, 0x824A, 0x81C6, 0x8143, 0x80C1, 0x8040
+};
+
+// Implementation
+uint8_t fxMulU8(uint8_t a, uint8_t b) {
+	return (uint8_t)(((uint16_t)a * b) >> 8);
+}
+
+uint16_t fxSqrU8(uint8_t a) {
+	return (uint16_t)a * a;
+}
+
+uint32_t fxMulU16(uint16_t a, uint16_t b) {
+#ifdef __AVR_HAVE_MUL__
+	uint32_t result;
+	__asm__ (
+		"mul  %A1, %A2"			"\n\t"
+		"movw %A0, r0"			"\n\t"
+		"mul  %B1, %B2"			"\n\t"
+		"movw %C0, r0"			"\n\t"
+		"mul  %B1, %A2"			"\n\t"
+		"add  %B0, r0"			"\n\t"
+		"adc  %C0, r1"			"\n\t"
+		"clr  __zero_reg__"		"\n\t"
+		"adc  %D0, __zero_reg__"	"\n\t"
+		"mul  %A1, %B2"			"\n\t"
+		"add  %B0, r0"			"\n\t"
+		"adc  %C0, r1"			"\n\t"
+		"clr  __zero_reg__"		"\n\t"
+		"adc  %D0, __zero_reg__"
+		: "=&r" (result)
+		: "r" (a), "r" (b)
+	);
+	return result;
+#else
+	return (uint32_t)a * b;
+#endif
+}
+
+int32_t fxMulS16(int16_t a, int16_t b) {
+	// two's complement product from unsigned one: a * b = ua * ub - (a < 0 ? ub << 16) - (b < 0 ? ua << 16)
+	uint32_t result = fxMulU16((uint16_t)a, (uint16_t)b);
+	if (a < 0) {
+		result -= (uint32_t)(uint16_t)b << 16;
+	}
+	if (b < 0) {
+		result -= (uint32_t)(uint16_t)a << 16;
+	}
+	return (int32_t)result;
+}
+
+uint32_t fxMulU16U32(uint16_t a, uint32_t b) {
+	return fxMulU16(a, (uint16_t)b) + (fxMulU16(a, (uint16_t)(b >> 16)) << 16);
+}
+
+uint32_t fxMulU32Q16_16(uint32_t a, uint32_t b) {
+	// (aH * 2^16 + aL) * (bH * 2^16 + bL) / 2^16 = aH * bH * 2^16 + aH * bL + aL * bH + aL * bL / 2^16
+	uint16_t aH = (uint16_t)(a >> 16);
+	uint16_t bH = (uint16_t)(b >> 16);
+	uint16_t aL = (uint16_t)a;
+	uint16_t bL = (uint16_t)b;
+	uint32_t result = fxMulU16(aL, bL) >> 16;
+	result += fxMulU16(aH, bL);
+	result += fxMulU16(aL, bH);
+	result += fxMulU16(aH, bH) << 16;
+	return result;
+}
+
+FxQ8_8_t fxMulQ8_8(FxQ8_8_t a, FxQ8_8_t b) {
+	int32_t result = (fxMulS16(a, b) + 0x80) >> 8;
+	if (result > INT16_MAX) {
+		result = INT16_MAX;
+	} else if (result < INT16_MIN) {
+		result = INT16_MIN;
+	}
+	return (FxQ8_8_t)result;
+}
+
+FxQ1_15_t fxMulQ1_15(FxQ1_15_t a, FxQ1_15_t b) {
+	int32_t result = (fxMulS16(a, b) + 0x4000) >> 15;
+	if (result > INT16_MAX) {
+		result = INT16_MAX;
+	}
+	return (FxQ1_15_t)result;
+}
+
+FxQ16_16_t fxMulQ16_16(FxQ16_16_t a, FxQ16_16_t b) {
+	// (aH * 2^16 + aL) * (bH * 2^16 + bL) / 2^16 = aH * bH * 2^16 + aH * bL + aL * bH + aL * bL / 2^16
+	int16_t aH = (int16_t)(a >> 16);
+	int16_t bH = (int16_t)(b >> 16);
+	uint16_t aL = (uint16_t)a;
+	uint16_t bL = (uint16_t)b;
+	uint32_t result = fxMulU16(aL, bL) >> 16;
+	result += (uint32_t)fxMulS16(aH, bH) << 16;
+	// signed by unsigned products
+	result += fxMulU16((uint16_t)aH, bL);
+	if (aH < 0) {
+		result -= (uint32_t)bL << 16;
+	}
+	result += fxMulU16(aL, (uint16_t)bH);
+	if (bH < 0) {
+		result -= (uint32_t)aL << 16;
+	}
+	return (FxQ16_16_t)result;
+}
+
+int16_t fxAddSat16(int16_t a, int16_t b) {
+	int16_t result = (int16_t)((uint16_t)a + (uint16_t)b);
+	// overflow only when both components have the same sign different than the result sign
+	if ((a >= 0) == (b >= 0) && (result >= 0) != (a >= 0)) {
+		result = a >= 0 ? INT16_MAX : INT16_MIN;
+	}
+	return result;
+}
+
+int32_t fxAddSat32(int32_t a, int32_t b) {
+	int32_t result = (int32_t)((uint32_t)a + (uint32_t)b);
+	if ((a >= 0) == (b >= 0) && (result >= 0) != (a >= 0)) {
+		result = a >= 0 ? INT32_MAX : INT32_MIN;
+	}
+	return result;
+}
+
+uint32_t fxRecipU16(uint16_t d) {
+	if (d <= 1) {
+		return UINT32_MAX;
+	}
+	// normalize divisor into [0x8000, 0xFFFF], so the table covers whole range
+	uint8_t shift = 0;
+	while (0 == (d & 0x8000)) {
+		d <<= 1;
+		shift++;
+	}
+	// x0 ~ 2^31 / d with relative error below 2^-8
+	uint16_t x0 = pgm_read_word(&_fxRecipTable[(d >> 8) & (FX_RECIP_TABLE_SIZE_OF - 1)]);
+	// Newton-Raphson step: x1 = x0 * (2 - d * x0 / 2^31) = x0 + x0 * (2^31 - d * x0) / 2^31
+	int32_t error = (int32_t)(0x80000000UL - fxMulU16(d, x0));
+	int32_t x1 = (int32_t)x0 + ((error >> 9) * (int32_t)x0 >> 22);
+	// 2^32 / (d >> shift) = (2^31 / d) << (shift + 1)
+	return (uint32_t)x1 << (shift + 1);
+}
+
+uint16_t fxDivU16(uint16_t n, uint16_t d) {
+	if (0 == d) {
+		return UINT16_MAX;
+	}
+	uint32_t recip = fxRecipU16(d);
+	// upper 32 bits of 48 bit product n * recip
+	uint32_t quotient = fxMulU16(n, (uint16_t)(recip >> 16)) + (fxMulU16(n, (uint16_t)recip) >> 16);
+	quotient >>= 16;
+	// reciprocal is approximated, so remainder is used to correct the result by one if needed
+	int32_t remainder = (int32_t)n - (int32_t)fxMulU16((uint16_t)quotient, d);
+	while (remainder < 0) {
+		quotient--;
+		remainder += d;
+	}
+	while (remainder >= d) {
+		quotient++;
+		remainder -= d;
+	}
+	return (uint16_t)quotient;
+}
@@ -0,0 +1,154 @@
+/** @file
+ * @brief Fixed-point arithmetic used by color processing kernels.
+ * FixedPoint.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FIXEDPOINT_H_
+#define FIXEDPOINT_H_
+
+#include "common.h"
+
+#include <stdint.h>
+
+/// Signed fixed-point number with 8 integer bits (including sign) and 8 fractional bits.
+typedef int16_t FxQ8_8_t;
+/// Signed fixed-point number in range [-1, 1) with 15 fractional bits.
+typedef int16_t FxQ1_15_t;
+/// Signed fixed-point number with 16 integer bits (including sign) and 16 fractional bits.
+typedef int32_t FxQ16_16_t;
+
+/// Converts constant (e.g. floating point literal) into Q8.8 number at compile time.
+#define FX_Q8_8(x) ((FxQ8_8_t)((x) * 256.0 + ((x) >= 0 ? 0.5 : -0.5)))
+/// Converts constant (e.g. floating point literal) into Q1.15 number at compile time.
+#define FX_Q1_15(x) ((FxQ1_15_t)((x) * 32768.0 + ((x) >= 0 ? 0.5 : -0.5)))
+/// Converts constant (e.g. floating point literal) into Q16.16 number at compile time.
+#define FX_Q16_16(x) ((FxQ16_16_t)((x) * 65536.0 + ((x) >= 0 ? 0.5 : -0.5)))
+
+/**
+Multiplies two 8 bit fractions, where 0xFF is treated as almost 1.
+@param a First factor.
+@param b Second factor.
+@result (a * b) >> 8
+*/
+uint8_t fxMulU8(uint8_t a, uint8_t b);
+
+/**
+Squares 8 bit integer, compiles into single \b mul instruction on AVR with hardware multiplier.
+@param a Factor.
+@result a * a
+*/
+uint16_t fxSqrU8(uint8_t a);
+
+/**
+Multiplies two unsigned 16 bit integers into 32 bit result.
+On AVR with hardware multiplier it uses four \b mul instructions.
+@param a First factor.
+@param b Second factor.
+@result a * b
+*/
+uint32_t fxMulU16(uint16_t a, uint16_t b);
+
+/**
+Multiplies two signed 16 bit integers into 32 bit result.
+@param a First factor.
+@param b Second factor.
+@result a * b
+*/
+int32_t fxMulS16(int16_t a, int16_t b);
+
+/**
+Multiplies unsigned 16 bit integer by unsigned 32 bit integer.
+@param a First factor.
+@param b Second factor.
+@result Lower 32 bits of a * b
+*/
+uint32_t fxMulU16U32(uint16_t a, uint32_t b);
+
+/**
+Multiplies unsigned 32 bit integer by unsigned Q16.16 factor using only 16 bit multiplications,
+e.g. to convert time to timer counts without 64 bit arithmetic.
+@param a Integer factor.
+@param b Factor in Q16.16 format.
+@result Lower 32 bits of (a * b) >> 16, fractional part is truncated
+*/
+uint32_t fxMulU32Q16_16(uint32_t a, uint32_t b);
+
+/**
+Multiplies two Q8.8 numbers with rounding. Result saturates on overflow.
+@param a First factor.
+@param b Second factor.
+@result a * b in Q8.8 format
+*/
+FxQ8_8_t fxMulQ8_8(FxQ8_8_t a, FxQ8_8_t b);
+
+/**
+Multiplies two Q1.15 numbers with rounding. Result saturates on overflow (-1 * -1 only).
+@param a First factor.
+@param b Second factor.
+@result a * b in Q1.15 format
+*/
+FxQ1_15_t fxMulQ1_15(FxQ1_15_t a, FxQ1_15_t b);
+
+/**
+Multiplies two Q16.16 numbers. Fractional part of the result is truncated
+and the result wraps on overflow like plain integer multiplication.
+@param a First factor.
+@param b Second factor.
+@result a * b in Q16.16 format
+*/
+FxQ16_16_t fxMulQ16_16(FxQ16_16_t a, FxQ16_16_t b);
+
+/**
+Adds two signed 16 bit numbers (e.g. Q8.8 or Q1.15) with saturation.
+@param a First component.
+@param b Second component.
+@result a + b limited to range [INT16_MIN, INT16_MAX]
+*/
+int16_t fxAddSat16(int16_t a, int16_t b);
+
+/**
+Adds two signed 32 bit numbers (e.g. Q16.16) with saturation.
+@param a First component.
+@param b Second component.
+@result a + b limited to range [INT32_MIN, INT32_MAX]
+*/
+int32_t fxAddSat32(int32_t a, int32_t b);
+
+/**
+Calculates reciprocal of 16 bit integer using table in flash memory
+and single Newton-Raphson iteration. Relative error is below 2^-14.
+@param d Divisor.
+@result 2^32 / d, UINT32_MAX for d equal 0 or 1
+*/
+uint32_t fxRecipU16(uint16_t d);
+
+/**
+Divides two unsigned 16 bit integers using #fxRecipU16 and multiplication
+with correction of the result, so the result is exact.
+@param n Dividend.
+@param d Divisor.
+@result n / d rounded down, UINT16_MAX for d equal 0
+*/
+uint16_t fxDivU16(uint16_t n, uint16_t d);
+
+#endif /* FIXEDPOINT_H_ */
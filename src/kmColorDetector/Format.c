@@ -0,0 +1,179 @@
+/*
+ * Format.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "common.h"
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "Format.h"
+#include "FixedPoint.h"
+#include "Serial.h"
+#ifdef KMCD_SOFT_SERIAL_DEBUG
+#include "SoftSerial.h"
+#endif
+#ifndef KMCD_NO_LCD
+#include "LiquidCrystal.h"
+#endif
+
+// "Private" global variables.
+// Two characters for each of the numbers 00..99
+static const char _fmtDecimalPairs[200] PROGMEM = {
+	'0', '0', '0', '1', '0', '2', '0', '3', '0', '4', '0', '5', '0', '6', '0', '7', '0', '8', '0', '9',
+	'1', '0', '1', '1', '1', '2', '1', '3', '1', '4', '1', '5', '1', '6', '1', '7', '1', '8', '1', '9',
+	'2', '0', '2', '1', '2', '2', '2', '3', '2', '4', '2', '5', '2', '6', '2', '7', '2', '8', '2', '9',
+	'3', '0', '3', '1', '3', '2', '3', '3', '3', '4', '3', '5', '3', '6', '3', '7', '3', '8', '3', '9',
+	'4', '0', '4', '1', '4', '2', '4', '3', '4', '4', '4', '5', '4', '6', '4', '7', '4', '8', '4', '9',
+	'5', '0', '5', '1', '5', '2', '5', '3', '5', '4', '5', '5', '5', '6', '5', '7', '5', '8', '5', '9',
+	'6', '0', '6', '1', '6', '2', '6', '3', '6', '4', '6', '5', '6', '6', '6', '7', '6', '8', '6', '9',
+	'7', '0', '7', '1', '7', '2', '7', '3', '7', '4', '7', '5', '7', '6', '7', '7', '7', '8', '7', '9',
+	'8', '0', '8', '1', '8', '2', '8', '3', '8', '4', '8', '5', '8', '6', '8', '7', '8', '8', '8', '9',
+	'9', '0', '9', '1', '9', '2', '9', '3', '9', '4', '9', '5', '9', '6', '9', '7', '9', '8', '9', '9'
+};
+
+static const char _fmtHexDigits[16] PROGMEM = {
+	'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+};
+
+// "Private" functions.
+uint16_t fmtDiv100(uint16_t value);
+char *fmtPair(char *str, uint8_t value);
+
+// Implementation
+void fmtChar(FmtSink sink, char c) {
+	if (FMT_SINK_SERIAL == sink) {
+		serWriteChar(c);
+	}
+#ifdef KMCD_SOFT_SERIAL_DEBUG
+	else if (FMT_SINK_SOFT_SERIAL == sink) {
+		swsWriteChar(c);
+	}
+#endif
+#ifndef KMCD_NO_LCD
+	else if (FMT_SINK_LCD == sink) {
+		lcdWrite(c);
+	}
+#endif
+}
+
+void fmtString(FmtSink sink, const char *str) {
+	if (FMT_SINK_SERIAL == sink) {
+		serPrintString(str);
+	}
+#ifdef KMCD_SOFT_SERIAL_DEBUG
+	else if (FMT_SINK_SOFT_SERIAL == sink) {
+		swsPrintString(str);
+	}
+#endif
+#ifndef KMCD_NO_LCD
+	else if (FMT_SINK_LCD == sink) {
+		lcdPrint(str);
+	}
+#endif
+}
+
+void fmtString_P(FmtSink sink, const char *str) {
+	if (FMT_SINK_SERIAL == sink) {
+		serPrintString_P(str);
+	}
+#ifdef KMCD_SOFT_SERIAL_DEBUG
+	else if (FMT_SINK_SOFT_SERIAL == sink) {
+		swsPrintString_P(str);
+	}
+#endif
+#ifndef KMCD_NO_LCD
+	else if (FMT_SINK_LCD == sink) {
+		lcdPrint_P(str);
+	}
+#endif
+}
+
+void fmtBinary(FmtSink sink, const uint8_t *buf, uint8_t len) {
+	if (FMT_SINK_SERIAL == sink) {
+		serSendBinary(buf, len);
+	}
+#ifdef KMCD_SOFT_SERIAL_DEBUG
+	else if (FMT_SINK_SOFT_SERIAL == sink) {
+		swsSendBinary(buf, len);
+	}
+#endif
+}
+
+void fmtHex(FmtSink sink, uint32_t value) {
+	char buf[FMT_BUFFER_SIZE_OF];
+	fmtString(sink, fmtHexToBuffer(buf, value));
+}
+
+void fmtDec(FmtSink sink, uint32_t value) {
+	char buf[FMT_BUFFER_SIZE_OF];
+	fmtString(sink, fmtDecToBuffer(buf, value));
+}
+
+char *fmtDecToBuffer(char *buf, uint32_t value) {
+	char *str = &buf[FMT_BUFFER_SIZE_OF - 1];
+	*str = '\0';
+	while (value > 0xFFFF) {
+		// only numbers above 16 bits need 32 bit division, four digits at once
+		uint32_t quotient = value / 10000;
+		uint16_t remainder = (uint16_t)(value - quotient * 10000);
+		uint16_t hundreds = fmtDiv100(remainder);
+		str = fmtPair(str, (uint8_t)(remainder - hundreds * 100));
+		str = fmtPair(str, (uint8_t)hundreds);
+		value = quotient;
+	}
+	uint16_t value16 = (uint16_t)value;
+	while (value16 >= 100) {
+		uint16_t quotient = fmtDiv100(value16);
+		str = fmtPair(str, (uint8_t)(value16 - quotient * 100));
+		value16 = quotient;
+	}
+	if (value16 >= 10) {
+		str = fmtPair(str, (uint8_t)value16);
+	} else {
+		*--str = '0' + value16;
+	}
+	return str;
+}
+
+char *fmtHexToBuffer(char *buf, uint32_t value) {
+	char *str = &buf[FMT_BUFFER_SIZE_OF - 1];
+	*str = '\0';
+	do {
+		*--str = pgm_read_byte(&_fmtHexDigits[value & 0x0F]);
+		value >>= 4;
+	} while (0 != value);
+	return str;
+}
+
+uint16_t fmtDiv100(uint16_t value) {
+	// value / 100 = (value / 4) / 25, reciprocal of 25 in Q19 is exact for all 16 bit values
+	return (uint16_t)(fxMulU16(value >> 2, 0x51EC) >> 19);
+}
+
+char *fmtPair(char *str, uint8_t value) {
+	const char *pair = &_fmtDecimalPairs[value * 2];
+	*--str = pgm_read_byte(pair + 1);
+	*--str = pgm_read_byte(pair);
+	return str;
+}
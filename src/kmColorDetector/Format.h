@@ -0,0 +1,110 @@
+/** @file
+ * @brief Formatting of numbers for debug output without printf.
+ * Format.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Numbers are converted into a small buffer on the stack and written straight to the
+ *  selected sink. Decimal digits are produced in pairs from a 200 byte table, so each pair
+ *  costs one multiplication by the reciprocal of 100 instead of two divisions by 10.
+ */
+
+#ifndef FORMAT_H_
+#define FORMAT_H_
+
+#include "common.h"
+
+#include <stdint.h>
+
+/// Maximum number of characters of the formatted uint32_t number, including terminating '\0'
+#define FMT_BUFFER_SIZE_OF 11
+
+/// Destination of the formatted text.
+typedef enum {
+	/// Serial interface, see Serial.h
+	FMT_SINK_SERIAL = 0,
+	/// LCD at the current cursor position, see LiquidCrystal.h
+	FMT_SINK_LCD = 1,
+	/// Software UART transmitter, see SoftSerial.h (requires KMCD_SOFT_SERIAL_DEBUG)
+	FMT_SINK_SOFT_SERIAL = 2
+} FmtSink;
+
+/**
+Writes single character to the sink.
+@param sink Destination of the character.
+@param c Character to be written.
+*/
+void fmtChar(FmtSink sink, char c);
+
+/**
+Writes string terminated by '\0' to the sink.
+@param sink Destination of the string.
+@param str String to be written.
+*/
+void fmtString(FmtSink sink, const char *str);
+
+/**
+Writes string from program memory terminated by '\0' to the sink.
+@param sink Destination of the string.
+@param str String in program memory to be written.
+*/
+void fmtString_P(FmtSink sink, const char *str);
+
+/**
+Writes binary buffer to the serial sink, LCD ignores it.
+@param sink Destination of the data.
+@param buf Buffer of the binary data.
+@param len Number of bytes to be written.
+*/
+void fmtBinary(FmtSink sink, const uint8_t *buf, uint8_t len);
+
+/**
+Writes number as upper case hexadecimal value without prefix and leading zeros, the same as "%lX".
+@param sink Destination of the number.
+@param value Number to be written.
+*/
+void fmtHex(FmtSink sink, uint32_t value);
+
+/**
+Writes number as decimal value without leading zeros, the same as "%lu".
+Numbers up to 0xFFFF use only 16 bit multiplications.
+@param sink Destination of the number.
+@param value Number to be written.
+*/
+void fmtDec(FmtSink sink, uint32_t value);
+
+/**
+Converts number into decimal digits at the end of the buffer.
+@param buf Buffer of at least #FMT_BUFFER_SIZE_OF characters.
+@param value Number to be converted.
+@result Pointer to the first digit in the buffer, digits are terminated by '\0'.
+*/
+char *fmtDecToBuffer(char *buf, uint32_t value);
+
+/**
+Converts number into upper case hexadecimal digits at the end of the buffer.
+@param buf Buffer of at least #FMT_BUFFER_SIZE_OF characters.
+@param value Number to be converted.
+@result Pointer to the first digit in the buffer, digits are terminated by '\0'.
+*/
+char *fmtHexToBuffer(char *buf, uint32_t value);
+
+#endif /* FORMAT_H_ */
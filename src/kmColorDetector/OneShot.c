@@ -0,0 +1,256 @@
+/*
+ * OneShot.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "config.h"
+#include "OneShot.h"
+#include "TimerOne.h"
+#include "TimerManager.h"
+#include "FixedPoint.h"
+#include "Power.h"
+
+/// Period of Timer1 time base in microseconds, used if it's not initialized by other module
+#define OST_DEFAULT_PERIOD 100000 // 100ms
+/// Timer1 counts without prescaler per microsecond in Q16.16 format
+#define OST_CYCLES_PER_MICROSECOND ((uint32_t)((uint64_t)(F_CPU) * 65536ULL / 1000000ULL))
+/// The longest delay whose count of Timer1 cycles fits in 32 bits, about 388s at 11.0592MHz
+#define OST_MAX_MICROSECONDS ((uint32_t)(((1ULL << 48) - 1) / OST_CYCLES_PER_MICROSECOND))
+/// Deadlines are compared as signed difference of periods, so they can't be farther than that
+#define OST_MAX_PERIODS (INT16_MAX - 1)
+
+// Internal definition of types.
+typedef struct {
+	// Period and count of Timer1 time base at the deadline
+	uint16_t period;
+	uint16_t count;
+	uint8_t action;
+	uint8_t pinMask;
+	volatile uint8_t *port;
+	OstCallback *callback;
+	void *userData;
+} ostItem;
+
+// "Private" global variables.
+// Deadlines sorted by time, the nearest one at index 0. Shared with compare interrupts,
+// so they are changed only with interrupts disabled.
+static ostItem _ostQueue[OST_CHANNELS_SIZE_OF][OST_QUEUE_SIZE_OF];
+static volatile uint8_t _ostLength[OST_CHANNELS_SIZE_OF];
+// Prescaler of the time base as power of two
+static uint8_t _ostPrescalerShift = 0;
+
+// "Private" functions.
+bool ostSchedule(OstChannel channel, uint32_t microseconds, ostItem *item);
+bool ostIsBefore(ostItem *item, ostItem *other);
+bool ostIsDue(ostItem *item, Timer1Time_t now);
+void ostProgram(uint8_t channel);
+void ostExpire(uint8_t channel);
+void ostIssue(ostItem *item);
+
+// Implementation
+bool ostInit(void) {
+	tmrDisableInterrupts(_BV(OCIE1A) | _BV(OCIE1B));
+	for (uint8_t i = 0; i < OST_CHANNELS_SIZE_OF; i++) {
+		_ostLength[i] = 0;
+	}
+	if (false == tmrReserve(TMR_TIMER_1, TMR_USER_ONE_SHOT, TMR_MODE_SHARED)) {
+		return false;
+	}
+	if (false == timer1IsTimebase()) {
+		if (true == tmrIsShared(TMR_TIMER_1)) {
+			// other module runs Timer1 in PWM mode, where compare registers are buffered
+			tmrRelease(TMR_TIMER_1, TMR_USER_ONE_SHOT);
+			return false;
+		}
+		TIMER1_INIT_TIMEBASE(OST_DEFAULT_PERIOD);
+	}
+	_ostPrescalerShift = 0;
+	while ((1U << _ostPrescalerShift) < timer1GetPrescaler()) {
+		_ostPrescalerShift++;
+	}
+	// Time base runs all the time, also between measures of the sensor
+	timer1Start();
+	return true;
+}
+
+bool ostSchedulePin(OstChannel channel, uint32_t microseconds, volatile uint8_t *port, uint8_t pinMask, OstAction action) {
+	ostItem item;
+	item.action = action;
+	item.port = port;
+	item.pinMask = pinMask;
+	item.callback = NULL;
+	item.userData = NULL;
+	return ostSchedule(channel, microseconds, &item);
+}
+
+bool ostScheduleCallback(OstChannel channel, uint32_t microseconds, OstCallback *callback, void *userData) {
+	ostItem item;
+	item.action = OST_ACTION_CALLBACK;
+	item.port = NULL;
+	item.pinMask = 0;
+	item.callback = callback;
+	item.userData = userData;
+	return ostSchedule(channel, microseconds, &item);
+}
+
+void ostCancel(OstChannel channel) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		_ostLength[channel] = 0;
+		ostProgram(channel);
+	}
+}
+
+uint8_t ostPending(OstChannel channel) {
+	return _ostLength[channel];
+}
+
+bool ostSchedule(OstChannel channel, uint32_t microseconds, ostItem *item) {
+	if (microseconds > OST_MAX_MICROSECONDS) {
+		return false;
+	}
+	// delay is split into periods and counts before interrupts are disabled, since it takes a division
+	uint32_t counts = fxMulU32Q16_16(microseconds, OST_CYCLES_PER_MICROSECOND) >> _ostPrescalerShift;
+	uint32_t periodLength = (uint32_t)timer1GetTop() + 1;
+	if (counts / periodLength > OST_MAX_PERIODS) {
+		// one period more can be added by the current count
+		return false;
+	}
+	uint16_t periods = counts / periodLength;
+	uint32_t remainder = counts - periods * periodLength;
+	bool result = false;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		uint8_t length = _ostLength[channel];
+		if (length < OST_QUEUE_SIZE_OF) {
+			Timer1Time_t now = timer1GetTime();
+			remainder += now.count;
+			if (remainder >= periodLength) {
+				remainder -= periodLength;
+				periods++;
+			}
+			item->period = now.period + periods;
+			item->count = (uint16_t)remainder;
+			// deadlines at the same time are kept in order of scheduling
+			uint8_t i = length;
+			while (i > 0 && true == ostIsBefore(item, &_ostQueue[channel][i - 1])) {
+				_ostQueue[channel][i] = _ostQueue[channel][i - 1];
+				i--;
+			}
+			_ostQueue[channel][i] = *item;
+			_ostLength[channel] = length + 1;
+			// Timer1 has to count until the deadline
+			pwrAllowPowerDown(PWR_ONE_SHOT, false);
+			if (0 == i) {
+				ostProgram(channel);
+			}
+			result = true;
+		}
+	}
+	return result;
+}
+
+bool ostIsBefore(ostItem *item, ostItem *other) {
+	int16_t periods = (int16_t)(item->period - other->period);
+	return periods < 0 || (0 == periods && item->count < other->count);
+}
+
+bool ostIsDue(ostItem *item, Timer1Time_t now) {
+	int16_t periods = (int16_t)(now.period - item->period);
+	return periods > 0 || (0 == periods && now.count >= item->count);
+}
+
+void ostProgram(uint8_t channel) {
+	// called from interrupt or with interrupts disabled
+	uint8_t interrupt = OST_CHANNEL_A == channel ? _BV(OCIE1A) : _BV(OCIE1B);
+	if (0 == _ostLength[channel]) {
+		tmrDisableInterrupts(interrupt);
+		if (0 == _ostLength[OST_CHANNEL_A] && 0 == _ostLength[OST_CHANNEL_B]) {
+			pwrAllowPowerDown(PWR_ONE_SHOT, true);
+		}
+		return;
+	}
+	// compare matches once per period, the interrupt checks if it's the period of the deadline
+	if (OST_CHANNEL_A == channel) {
+		OCR1A = _ostQueue[channel][0].count;
+		tmrClearFlags(_BV(OCF1A));
+	} else {
+		OCR1B = _ostQueue[channel][0].count;
+		tmrClearFlags(_BV(OCF1B));
+	}
+	tmrEnableInterrupts(interrupt);
+	if (true == ostIsDue(&_ostQueue[channel][0], timer1GetTime())) {
+		// counter passed the deadline before compare register was written,
+		// so the match would come only in the next period
+		ostExpire(channel);
+	}
+}
+
+void ostExpire(uint8_t channel) {
+	Timer1Time_t now = timer1GetTime();
+	while (_ostLength[channel] > 0 && true == ostIsDue(&_ostQueue[channel][0], now)) {
+		// deadline is removed before the action, so the callback can schedule the next one
+		ostItem item = _ostQueue[channel][0];
+		uint8_t length = _ostLength[channel] - 1;
+		for (uint8_t i = 0; i < length; i++) {
+			_ostQueue[channel][i] = _ostQueue[channel][i + 1];
+		}
+		_ostLength[channel] = length;
+		ostIssue(&item);
+	}
+	ostProgram(channel);
+}
+
+void ostIssue(ostItem *item) {
+	switch (item->action) {
+		case OST_ACTION_PIN_SET : {
+			*item->port |= item->pinMask;
+			break;
+		}
+		case OST_ACTION_PIN_CLEAR : {
+			*item->port &= ~item->pinMask;
+			break;
+		}
+		case OST_ACTION_PIN_TOGGLE : {
+			*item->port ^= item->pinMask;
+			break;
+		}
+		default : {
+			if (NULL != item->callback) {
+				item->callback(item->userData);
+			}
+		}
+	}
+}
+
+ISR(TIMER1_COMPA_vect) {
+	ostExpire(OST_CHANNEL_A);
+}
+
+ISR(TIMER1_COMPB_vect) {
+	ostExpire(OST_CHANNEL_B);
+}
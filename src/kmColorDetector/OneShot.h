@@ -0,0 +1,119 @@
+/** @file
+ * @brief One-shot timers with microsecond deadlines on Timer1 compare channels OCR1A and OCR1B.
+ * OneShot.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Each compare channel keeps its own queue of deadlines sorted by time, only the nearest
+ *  one is programmed in the compare register. Timer1 has to run as a time base (CTC mode,
+ *  see #timer1InitTimebaseCycles), since compare registers are buffered in PWM modes.
+ *  The time base is shared with the color sensor gate, so resolution is a single Timer1 count
+ *  of the sensor prescaler (~5.8us with /64 for 11.0592MHz), and the pin is changed
+ *  in the compare interrupt a few microseconds after the match.
+ */
+
+#ifndef ONESHOT_H_
+#define ONESHOT_H_
+
+#include "common.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// User data remapping macro for callback registration
+#define OST_USER_DATA(X) (void *)(X)
+
+/// Timer1 compare channels used by one-shot timers.
+typedef enum {
+	/// Compare channel A, OCR1A.
+	OST_CHANNEL_A = 0,
+	/// Compare channel B, OCR1B.
+	OST_CHANNEL_B = 1
+} OstChannel;
+
+/// Number of compare channels.
+#define OST_CHANNELS_SIZE_OF 2
+
+/// Action issued at the deadline.
+typedef enum {
+	/// Callback is issued.
+	OST_ACTION_CALLBACK,
+	/// Pins are set to high state.
+	OST_ACTION_PIN_SET,
+	/// Pins are set to low state.
+	OST_ACTION_PIN_CLEAR,
+	/// Pins are toggled.
+	OST_ACTION_PIN_TOGGLE
+} OstAction;
+
+/**
+Definition of the One-Shot Timer Callback
+@param Pointer for void content that is registered in #ostScheduleCallback function
+and will be delivered to callback.
+*/
+typedef void OstCallback(void *);
+
+/**
+Initialization of the one-shot timers. Timer1 is reserved in shared mode, if it's not used yet,
+it's initialized as a time base with period OST_DEFAULT_PERIOD, otherwise its current period is kept.
+Following definitions to be set in config.h file @n
+#define \b OST_QUEUE_SIZE_OF 4 \\ Number of pending deadlines per compare channel.@n
+@result false if Timer1 is used in PWM mode or reserved exclusively by other module.
+*/
+bool ostInit(void);
+
+/**
+Schedules change of the pins at the deadline.
+\b NOTE: Pins need to be configured as outputs by the caller.
+@param channel Compare channel serving the deadline.
+@param microseconds Time from now to the deadline, up to about 388s and 32766 periods of Timer1.
+@param port Port register of the pins, e.g. &PORTB.
+@param pinMask Mask of the pins, e.g. _BV(PB0).
+@param action One of OST_ACTION_PIN_* actions.
+@result false if the queue of the channel is full or the delay is too long and the deadline is dropped.
+*/
+bool ostSchedulePin(OstChannel channel, uint32_t microseconds, volatile uint8_t *port, uint8_t pinMask, OstAction action);
+
+/**
+Schedules callback at the deadline.
+\b NOTE: The callback is issued within interrupt routine, so it should be as short as possible.
+@param channel Compare channel serving the deadline.
+@param microseconds Time from now to the deadline, up to about 388s and 32766 periods of Timer1.
+@param callback Pointer to the callback function to be issued at the deadline.
+@param userData User data void pointer to structure to be delivered to callback "as-is".
+@result false if the queue of the channel is full or the delay is too long and the deadline is dropped.
+*/
+bool ostScheduleCallback(OstChannel channel, uint32_t microseconds, OstCallback *callback, void *userData);
+
+/**
+Drops all pending deadlines of the channel.
+@param channel Compare channel to be cleared.
+*/
+void ostCancel(OstChannel channel);
+
+/**
+Returns number of pending deadlines of the channel.
+@param channel Compare channel to be checked.
+@result Number of deadlines waiting in the queue.
+*/
+uint8_t ostPending(OstChannel channel);
+
+#endif /* ONESHOT_H_ */
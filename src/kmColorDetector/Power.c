@@ -0,0 +1,116 @@
+/*
+ * Power.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+
+#include "config.h"
+#include "Power.h"
+#include "Events.h"
+#ifndef KMCD_NO_POWER_DOWN
+#include "SoftwareTimer.h"
+#include "ExternalInterrupt.h"
+
+#ifndef SWT_CLOCK
+#error "Power-down timeout requires swtMillis clock, define SWT_CLOCK or KMCD_NO_POWER_DOWN"
+#endif
+#endif
+
+// "Private" global variables.
+// Each bit is one module which doesn't tolerate power-down at the moment
+static volatile uint8_t _pwrPowerDownVeto = 0;
+#ifndef KMCD_NO_POWER_DOWN
+static uint32_t _pwrLastActivity = 0;
+#endif
+
+// "Private" functions.
+void pwrEnterSleep(uint8_t mode);
+#ifndef KMCD_NO_POWER_DOWN
+void pwrWakeCallback(void *userData);
+#endif
+
+// Implementation
+void pwrInit(void) {
+	_pwrPowerDownVeto = 0;
+#ifndef KMCD_NO_POWER_DOWN
+	extIntRegisterCallback(EXT_INT_2, EXT_INT_FALLING_EDGE, true, pwrWakeCallback, NULL);
+	pwrActivity();
+#endif
+}
+
+void pwrAllowPowerDown(PwrModule module, bool allow) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if (true == allow) {
+			_pwrPowerDownVeto &= ~_BV(module);
+		} else {
+			_pwrPowerDownVeto |= _BV(module);
+		}
+	}
+}
+
+void pwrActivity(void) {
+#ifndef KMCD_NO_POWER_DOWN
+	_pwrLastActivity = swtMillis();
+#endif
+}
+
+void pwrSleep(void) {
+#ifndef KMCD_NO_POWER_DOWN
+	if (0 == _pwrPowerDownVeto && swtMillis() - _pwrLastActivity >= KMCD_POWER_DOWN_TIMEOUT) {
+		pwrEnterSleep(SLEEP_MODE_PWR_DOWN);
+		// Time spent in power-down is not counted by swtMillis, so timeout starts from now
+		pwrActivity();
+		return;
+	}
+#endif
+	pwrEnterSleep(SLEEP_MODE_IDLE);
+}
+
+void pwrEnterSleep(uint8_t mode) {
+	set_sleep_mode(mode);
+	// Interrupts are disabled while checking the conditions, otherwise event posted
+	// just after the check would be handled only after next wake up
+	cli();
+	if (false == evtPending() && (SLEEP_MODE_IDLE == mode || 0 == _pwrPowerDownVeto)) {
+		sleep_enable();
+		// Instruction following sei is always executed before any interrupt,
+		// so uC goes to sleep before interrupt handler is issued
+		sei();
+		sleep_cpu();
+		sleep_disable();
+	}
+	sei();
+}
+
+#ifndef KMCD_NO_POWER_DOWN
+void pwrWakeCallback(void *userData) {
+	// Wake up pin works as a trigger of the measure
+	evtPost(EVT_BUTTON);
+}
+#endif
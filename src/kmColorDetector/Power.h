@@ -0,0 +1,96 @@
+/** @file
+ * @brief Sleep manager putting uC into idle or power-down mode when there is nothing to do.
+ * Power.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  References:
+ * -# http://ww1.microchip.com/downloads/en/DeviceDoc/doc2503.pdf (chapter Power Management and Sleep Modes)
+ * -# https://www.nongnu.org/avr-libc/user-manual/group__avr__sleep.html
+ */
+
+#ifndef POWER_H_
+#define POWER_H_
+
+#include "common.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+Modules which may not tolerate power-down at the moment, since they need
+clocks of uC peripherals. Each module is represented by single bit.
+*/
+typedef enum {
+	/// Color sensor measure in progress, Timer1 and INT0 have to count.
+	PWR_SENSOR = 0,
+	/// Characters are waiting in serial transmit buffer.
+	PWR_SERIAL = 1,
+	/// Application itself, e.g. serial console which can't wake up uC from power-down.
+	PWR_APPLICATION = 2,
+	/// One-shot timers are waiting for their deadlines on Timer1.
+	PWR_ONE_SHOT = 3,
+	/// Characters are shifted out by software UART on Timer0.
+	PWR_SOFT_SERIAL = 4,
+	/// Commands are waiting in the queue of DF Player, software timer paces them.
+	PWR_SOUND_PLAYER = 5
+} PwrModule;
+
+/**
+Initialization of the sleep manager. All modules tolerate power-down after initialization.
+If power-down is enabled, external interrupt INT2 (PB2 for ATmega32) is registered
+as wake up source posting #EVT_BUTTON, so falling edge on the pin starts measure
+also when uC is awake. Only INT2 is used since it's the only edge sensitive interrupt
+waking up from power-down, and INT1 pin (PD3) is used by LED of the color sensor.
+Following definitions to be set in config.h file @n
+#define \b KMCD_NO_POWER_DOWN \\ Disables power-down, only idle mode is used.@n
+#define \b KMCD_WAKE_PIN_INT2 \\ Declares a switch wired to INT2, power-down is disabled without it.@n
+#define \b KMCD_POWER_DOWN_TIMEOUT 30000 \\ Time in ms without activity after which uC enters power-down.@n
+*/
+void pwrInit(void);
+
+/**
+Declares if the module tolerates power-down right now. Can be called from interrupts.
+@param module Module declaring its state.
+@param allow false if the module needs peripheral clocks, so only idle mode can be used.
+*/
+void pwrAllowPowerDown(PwrModule module, bool allow);
+
+/**
+Marks activity of the user, so power-down timeout starts counting again.
+*/
+void pwrActivity(void);
+
+/**
+Puts uC to sleep until next interrupt, to be called in main loop once all events are handled.
+Returns immediately if any event is pending. Idle mode is used by default,
+so USART receiver, Timer1, Timer2 and external interrupts wake up uC.
+Power-down is used if no module objects and there was no activity for
+KMCD_POWER_DOWN_TIMEOUT, then only INT2 wakes up uC, software timers and
+swtMillis clock are stopped for the time of power-down. Wake up from power-down
+takes the oscillator start-up time selected with CKSEL and SUT fuses, at most 16K CK
+for crystal oscillator (additional delay applies only after reset), i.e. about 1.5 ms
+for 11.0592 MHz crystal before the measure is started. It's calculated from the datasheet,
+not measured on hardware.
+*/
+void pwrSleep(void);
+
+#endif /* POWER_H_ */
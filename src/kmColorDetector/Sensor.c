@@ -29,29 +29,29 @@
 #include "Sensor.h"
 #include "ExternalInterrupt.h"
 #include "TimerOne.h"
+#include "TimerManager.h"
 #include "ColorTools.h"
+#include "Events.h"
+#include "Power.h"
 
 #define TSC_USER_DATA(X) (void *)(X)
 typedef void TscCallback(void *);
 
 #define TSC_DEFULT_FREQUENCY_SCALING TSC_PERCENT_20
-#define SINGLE_MEASURE_TIME 200000 // 10ms
+#define SINGLE_MEASURE_TIME 200000 // 200ms
 
 static RgbColor16_t _tscRGB;
 
 static uint16_t _tscCount = 0;
-static bool _tscMeasureReady = false;
+static volatile bool _tscMeasureReady = false;
+
+static bool _tscMeasureActive = false;
+static uint32_t _tscIntegrationTime = SINGLE_MEASURE_TIME;
+static TscOutputFrequencyScaling _tscFrequencyScaling = TSC_DEFULT_FREQUENCY_SCALING;
 
 static TscCallback *_tscCallback = NULL;
 static void *_tscCallbackUserData = NULL;
 
-typedef enum {
-	TSC_POWER_DOWN,
-	TSC_PERCENT_2,
-	TSC_PERCENT_20,
-	TSC_PERCENT_100
-} TscOutputFrequencyScaling;
-
 typedef enum {
 	TSC_PDT_STOP = 0,
 	TSC_PDT_RED = 1,
@@ -146,6 +146,7 @@ void tscTimerCallback(void *userData) {
 		case TSC_PDT_CLEAR : {
 			_tscRGB.b = _tscCount;
 			_tscMeasureReady = true;
+			evtPost(EVT_MEASURE_DONE);
 			TSC_PORT &= ~_BV(TSC_PIN_LED);
 			timer1SetCallbackUserData(TSC_PDT_STOP);
 			break;
@@ -164,13 +165,20 @@ void tscLoop(void) {
 	if (NULL != _tscCallback && true == _tscMeasureReady) {
 		_tscMeasureReady = false;
 		_tscCallback(_tscCallbackUserData);
-		timer1Stop();
-		timer1Restart();
+		timer1DisableInterrupt();
+		if (false == tmrIsShared(TMR_TIMER_1)) {
+			// PWM outputs sharing Timer1 keep running
+			timer1Stop();
+			timer1Restart();
+		}
 		tscSetOutputFrequencyScaling(TSC_POWER_DOWN);
+		_tscMeasureActive = false;
+		// Sensor is powered down, so Timer1 and INT0 are not needed anymore
+		pwrAllowPowerDown(PWR_SENSOR, true);
 	}
 }
 
-void tscInit(void) {
+bool tscInit(void) {
 	// Pins S0 to S4 as outputs
 	TSC_DDR |= _BV(TSC_PIN_S0) | _BV(TSC_PIN_S1) | _BV(TSC_PIN_S2) | _BV(TSC_PIN_S3);
 	// Led pin as output
@@ -183,19 +191,80 @@ void tscInit(void) {
 	// No pull-up for Sensor out pin
 	TSC_PORT &= ~_BV(TSC_PIN_OUT);
 
-	timer1Init(SINGLE_MEASURE_TIME);
+	// Timer1 period is the gate time of the sensor, PWM outputs can share it with the same period
+	if (false == tmrReserve(TMR_TIMER_1, TMR_USER_SENSOR, TMR_MODE_SHARED)) {
+		return false;
+	}
+#ifndef KMCD_ONE_SHOT_TIMERS
+	TIMER1_INIT(SINGLE_MEASURE_TIME);
+#else
+	// One-shot timers need compare registers without buffering, so gate runs on Timer1 time base
+	TIMER1_INIT_TIMEBASE(SINGLE_MEASURE_TIME);
+#endif
 	extIntRegisterCallback(EXT_INT_0, EXT_INT_RISING_EDGE, false, tscCountCallback, NULL);
 	timer1RegisterCallback(tscTimerCallback, TIMER1_USER_DATA(TSC_PDT_STOP));
 	tscSetOutputFrequencyScaling(TSC_POWER_DOWN);
+	return true;
 }
 
-void tscStartMeasure(void) {
+bool tscStartMeasure(void) {
+	if (true == _tscMeasureActive) {
+		// restart would mix counts of two measures
+		return false;
+	}
+	// Timer1 and INT0 have to count until the measure is finished
+	pwrAllowPowerDown(PWR_SENSOR, false);
+	_tscMeasureActive = true;
 	timer1SetCallbackUserData(TIMER1_USER_DATA(TSC_PDT_RED));
-	tscSetOutputFrequencyScaling(TSC_DEFULT_FREQUENCY_SCALING);
+	tscSetOutputFrequencyScaling(_tscFrequencyScaling);
 	timer1EnableInterrupt();
-	timer1Restart();
+	if (false == tmrIsShared(TMR_TIMER_1)) {
+		// counter shared with other modules keeps running, the first gate period is partial then,
+		// but it's used only to switch on the LED and the red filter
+		timer1Restart();
+	}
 	timer1Start();
 	_tscCount  = 0;
+	return true;
+}
+
+bool tscMeasureActive(void) {
+	return _tscMeasureActive;
+}
+
+bool tscSetIntegrationTime(uint32_t microseconds) {
+	if (microseconds < TSC_MIN_INTEGRATION_TIME || microseconds > TSC_MAX_INTEGRATION_TIME) {
+		return false;
+	}
+#ifdef KMCD_ONE_SHOT_TIMERS
+	// gate period is the time base of pending one-shot deadlines
+	return false;
+#else
+	if (true == _tscMeasureActive || true == tmrIsShared(TMR_TIMER_1)) {
+		// running gate or PWM outputs sharing Timer1 period can't be changed
+		return false;
+	}
+	timer1SetPeriod(microseconds);
+	_tscIntegrationTime = microseconds;
+	return true;
+#endif
+}
+
+uint32_t tscGetIntegrationTime(void) {
+	return _tscIntegrationTime;
+}
+
+bool tscSetFrequencyScaling(TscOutputFrequencyScaling frequencyScaling) {
+	if (TSC_POWER_DOWN == frequencyScaling || frequencyScaling > TSC_PERCENT_100) {
+		return false;
+	}
+	// used from the next measure
+	_tscFrequencyScaling = frequencyScaling;
+	return true;
+}
+
+TscOutputFrequencyScaling tscGetFrequencyScaling(void) {
+	return _tscFrequencyScaling;
 }
 
 RgbColor16_t tscGetColor(void) {
@@ -38,10 +38,31 @@
 
 #include "common.h"
 #include "ColorTools.h"
+#include <stdint.h>
+#include <stdbool.h>
 
 /// User data remapping macro for callback registration
 #define TSC_USER_DATA(X) (void *)(X)
 
+/// The shortest gate time of single color filter in microseconds, see #tscSetIntegrationTime
+#define TSC_MIN_INTEGRATION_TIME 1000
+/// The longest gate time of single color filter in microseconds, see #tscSetIntegrationTime
+#define TSC_MAX_INTEGRATION_TIME 1000000
+
+/**
+Output frequency scaling of TCS3200, selected with S0 and S1 pins.
+*/
+typedef enum {
+	/// Sensor is powered down, used between measures
+	TSC_POWER_DOWN,
+	/// 2% of the full output frequency
+	TSC_PERCENT_2,
+	/// 20% of the full output frequency
+	TSC_PERCENT_20,
+	/// Full output frequency
+	TSC_PERCENT_100
+} TscOutputFrequencyScaling;
+
 /**
 Definition of the Color Sensor Callback
 @param Pointer for void content that is registered in #tscRegisterCallbackMeasureFinished function
@@ -59,8 +80,9 @@ Following definitions to be set in config.h file @n
 #define \b TSC_PIN_S1 Port pin for S1 wire TCS3200@n
 #define \b TSC_PIN_S2 Port pin for S2 wire TCS3200@n
 #define \b TSC_PIN_S3 Port pin for S3 wire TCS3200@n
+@result false if Timer1 is reserved exclusively by other module, sensor can't measure then.
 */
-void tscInit(void);
+bool tscInit(void);
 
 /**
 To be periodically issued in the main loop.
@@ -70,8 +92,46 @@ void tscLoop(void);
 /**
 Starts measure process. When measure is finished callback registered in #tscRegisterCallbackMeasureFinished.
 Use #tscGetColor to get raw color measure result from sensor.
+@result false if previous measure is not finished yet, it's not restarted then.
+*/
+bool tscStartMeasure(void);
+
+/**
+Checks if measure started with #tscStartMeasure is running.
+@result true until the callback registered in #tscRegisterCallbackMeasureFinished is issued.
+*/
+bool tscMeasureActive(void);
+
+/**
+Changes gate time of each color filter, the whole measure takes four gate times.
+Counts of the sensor are 16 bit, so long gate with high frequency scaling can overflow them.
+Black and white references are measured with specific gate time and scaling, so they need
+to be updated after the change.
+Request is rejected during the measure, when Timer1 period is shared with PWM outputs
+or when one-shot timers use Timer1 time base (KMCD_ONE_SHOT_TIMERS).
+@param microseconds Gate time from #TSC_MIN_INTEGRATION_TIME to #TSC_MAX_INTEGRATION_TIME.
+@result true if gate time has been changed.
+*/
+bool tscSetIntegrationTime(uint32_t microseconds);
+
+/**
+Returns gate time of each color filter.
+@result Gate time in microseconds.
+*/
+uint32_t tscGetIntegrationTime(void);
+
+/**
+Selects output frequency scaling used by the following measures.
+@param frequencyScaling Scaling from #TSC_PERCENT_2 to #TSC_PERCENT_100.
+@result true if scaling is valid, #TSC_POWER_DOWN is rejected.
+*/
+bool tscSetFrequencyScaling(TscOutputFrequencyScaling frequencyScaling);
+
+/**
+Returns output frequency scaling used by measures.
+@result Frequency scaling.
 */
-void tscStartMeasure(void);
+TscOutputFrequencyScaling tscGetFrequencyScaling(void);
 
 /**
 When measure is finished, this function returns measured value in the RAW RGB format.
@@ -41,11 +41,48 @@
 #include <util/setbaud.h>
 
 #include "SerialDefs.h"
+#include "Events.h"
+#include "Power.h"
 #include "Serial.h"
 #include "Debug.h"
 
-#define SERIAL_RX_BUFFER_SIZE 20
-#define SERIAL_TX_BUFFER_SIZE SERIAL_RX_BUFFER_SIZE
+#if (SERIAL_RX_BUFFER_SIZE & (SERIAL_RX_BUFFER_SIZE - 1)) != 0 || SERIAL_RX_BUFFER_SIZE > 128
+#error "SERIAL_RX_BUFFER_SIZE has to be power of two up to 128"
+#endif
+#if (SERIAL_TX_BUFFER_SIZE & (SERIAL_TX_BUFFER_SIZE - 1)) != 0 || SERIAL_TX_BUFFER_SIZE > 128
+#error "SERIAL_TX_BUFFER_SIZE has to be power of two up to 128"
+#endif
+#if (SERIAL_TX_QUEUE_SIZE_OF & (SERIAL_TX_QUEUE_SIZE_OF - 1)) != 0 || SERIAL_TX_QUEUE_SIZE_OF > 128
+#error "SERIAL_TX_QUEUE_SIZE_OF has to be power of two up to 128"
+#endif
+#define SERIAL_RX_BUFFER_MASK (SERIAL_RX_BUFFER_SIZE - 1)
+#define SERIAL_TX_BUFFER_MASK (SERIAL_TX_BUFFER_SIZE - 1)
+#define SERIAL_TX_QUEUE_MASK (SERIAL_TX_QUEUE_SIZE_OF - 1)
+
+// Internal definition of types.
+/// Source of the bytes streamed by the data register empty interrupt
+typedef enum {
+    /// Next bytes of the transmit ring
+    SER_TX_RING = 0,
+    /// Buffer in RAM
+    SER_TX_RAM = 1,
+    /// Buffer in program memory
+    SER_TX_FLASH = 2,
+    /// String in program memory terminated by '\0'
+    SER_TX_FLASH_STRING = 3,
+    /// Bytes returned by the function of other module
+    SER_TX_FUNCTION = 4
+} serTxSource;
+
+typedef struct {
+    union {
+        const uint8_t *data;
+        SerTxSource *source;
+    } from;
+    /// Bytes left to be sent, for strings it's 1 until terminator is reached
+    uint8_t length;
+    uint8_t source;
+} serTxDescriptor;
 
 static volatile uint8_t *_ubrrh = 0;
 static volatile uint8_t *_ubrrl = 0;
@@ -63,16 +100,27 @@ static const char _strPrefixHex[] PROGMEM = "0x";
 static const char _strPrefixOct[] PROGMEM = "0";
 static unsigned char _rxTerminationChar = '\r';
 
+// Single producer, single consumer rings. Indices are free running and masked on access,
+// so their difference is the number of stored bytes. Put index is written only by the producer,
+// get index only by the consumer, so none of them needs atomic read-modify-write.
+// RX ring is filled by the receive interrupt and read by the main program.
 static uint8_t _rxBuffer[SERIAL_RX_BUFFER_SIZE];
-static volatile int _rxBufferGetIndex = 0;
-static volatile int _rxBufferPutIndex = 0;
-static volatile int _rxBufferLength = 0;
-static volatile int _rxBufferLines = 0;
-
-static uint8_t _txBuffer[SERIAL_RX_BUFFER_SIZE];
-static volatile int _txBufferGetIndex = 0;
-static volatile int _txBufferPutIndex = 0;
-static volatile int _txBufferLength = 0;
+static volatile uint8_t _rxBufferGetIndex = 0;
+static volatile uint8_t _rxBufferPutIndex = 0;
+// Line terminators stored by the interrupt and read by the main program
+static volatile uint8_t _rxBufferLinesStored = 0;
+static volatile uint8_t _rxBufferLinesRead = 0;
+
+// TX ring is filled by the main program and read by the data register empty interrupt.
+static uint8_t _txBuffer[SERIAL_TX_BUFFER_SIZE];
+static volatile uint8_t _txBufferGetIndex = 0;
+static volatile uint8_t _txBufferPutIndex = 0;
+
+// Queue of descriptors, the interrupt streams bytes straight from the data of the first one.
+// Filled by the main program, which also extends the last descriptor of the ring with interrupts disabled.
+static serTxDescriptor _txQueue[SERIAL_TX_QUEUE_SIZE_OF];
+static volatile uint8_t _txQueueGetIndex = 0;
+static volatile uint8_t _txQueuePutIndex = 0;
 
 // Terminal commands
 #define SER_TERM_CLEAR_SCREEN PSTR("\e[2J")
@@ -91,6 +139,13 @@ int txAvailable(void);
 int txPeek(void);
 int txRead(void);
 void txFlush(void);
+uint8_t txQueued(void);
+serTxDescriptor *txReserve(void);
+void txPublish(void);
+bool txQueue(const uint8_t *data, uint8_t length, serTxSource source);
+bool txQueueRing(void);
+void txWait(void);
+void txStart(void);
 
 void serSetup(
 volatile uint8_t *ubrrh, volatile uint8_t *ubrrl,
@@ -102,89 +157,216 @@ void irqTx(void);
 void irqRx(void);
 
 // Internal RX/TX buffer operations
+// Called only by the receive interrupt, the caller checks available room
 void rxStore(uint8_t c) {
+    uint8_t putIndex = _rxBufferPutIndex;
+    _rxBuffer[putIndex & SERIAL_RX_BUFFER_MASK] = c;
+    // index is published after the byte is stored
+    _rxBufferPutIndex = putIndex + 1;
     if (_rxTerminationChar == c) {
-        _rxBufferLines++;
+        _rxBufferLinesStored++;
     }
-    _rxBuffer[_rxBufferPutIndex] = c;
-    _rxBufferPutIndex = (_rxBufferPutIndex + 1) % SERIAL_RX_BUFFER_SIZE;
-    _rxBufferLength++;
 }
 
 int rxAvailable(void) {
-    return _rxBufferLength;
+    return (uint8_t)(_rxBufferPutIndex - _rxBufferGetIndex);
 }
 
 int rxAvailableForWrite(void) {
-    return SERIAL_RX_BUFFER_SIZE - _rxBufferLength;
+    return SERIAL_RX_BUFFER_SIZE - rxAvailable();
 }
 
 int rxPeek(void) {
-    if (0 == _rxBufferLength) {
+    uint8_t getIndex = _rxBufferGetIndex;
+    if (getIndex == _rxBufferPutIndex) {
         return -1;
     } else {
-        return _rxBuffer[_rxBufferGetIndex];
+        return _rxBuffer[getIndex & SERIAL_RX_BUFFER_MASK];
     }
 }
 
 int rxRead(void) {
-    if (0 == _rxBufferLength) {
+    uint8_t getIndex = _rxBufferGetIndex;
+    if (getIndex == _rxBufferPutIndex) {
         return -1;
     } else {
-        uint8_t c = _rxBuffer[_rxBufferGetIndex++];
-        _rxBufferGetIndex %= SERIAL_RX_BUFFER_SIZE;
-        _rxBufferLength--;
+        uint8_t c = _rxBuffer[getIndex & SERIAL_RX_BUFFER_MASK];
+        // index is published after the byte is read, so the interrupt doesn't overwrite it
+        _rxBufferGetIndex = getIndex + 1;
         if (_rxTerminationChar == c) {
-            _rxBufferLines--;
+            _rxBufferLinesRead++;
         }
         return c;
     }
 }
 
 void rxFlush(void) {
-    _rxBufferLength = 0;
+    // consumer drops everything stored so far, interrupt can't store anything in between
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        _rxBufferGetIndex = _rxBufferPutIndex;
+        _rxBufferLinesRead = _rxBufferLinesStored;
+        _rxBufferOverflow = false;
+    }
 }
 
+// Called only by the main program, the caller checks available room
 void txStore(uint8_t c) {
-    _txBuffer[_txBufferPutIndex] = c;
-    _txBufferPutIndex = (_txBufferPutIndex + 1) % SERIAL_TX_BUFFER_SIZE;
-    _txBufferLength++;
+    uint8_t putIndex = _txBufferPutIndex;
+    _txBuffer[putIndex & SERIAL_TX_BUFFER_MASK] = c;
+    // index is published after the byte is stored
+    _txBufferPutIndex = putIndex + 1;
 }
 
 int txAvailable(void) {
-    return _txBufferLength;
+    return (uint8_t)(_txBufferPutIndex - _txBufferGetIndex);
 }
 
 int txPeek(void) {
-    if (0 == _txBufferLength) {
+    uint8_t getIndex = _txBufferGetIndex;
+    if (getIndex == _txBufferPutIndex) {
         return -1;
     } else {
-        return _txBuffer[_txBufferGetIndex];
+        return _txBuffer[getIndex & SERIAL_TX_BUFFER_MASK];
     }
 }
 
+// Called only by the data register empty interrupt
 int txRead(void) {
-    if (0 == _txBufferLength) {
+    uint8_t getIndex = _txBufferGetIndex;
+    if (getIndex == _txBufferPutIndex) {
         return -1;
     } else {
-        uint8_t c = _txBuffer[_txBufferGetIndex++];
-        _txBufferGetIndex %= SERIAL_TX_BUFFER_SIZE;
-        _txBufferLength--;
+        uint8_t c = _txBuffer[getIndex & SERIAL_TX_BUFFER_MASK];
+        _txBufferGetIndex = getIndex + 1;
         return c;
     }
 }
 
 void txFlush(void) {
-    _txBufferLength = 0;
+    // drops pending bytes and descriptors, the interrupt is the consumer, so it can't run in between
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        _txBufferGetIndex = _txBufferPutIndex;
+        _txQueueGetIndex = _txQueuePutIndex;
+    }
+}
+
+uint8_t txQueued(void) {
+    return (uint8_t)(_txQueuePutIndex - _txQueueGetIndex);
+}
+
+// Returns next free descriptor or NULL if queue is full, called only by the main program
+serTxDescriptor *txReserve(void) {
+    uint8_t putIndex = _txQueuePutIndex;
+    if (SERIAL_TX_QUEUE_SIZE_OF == (uint8_t)(putIndex - _txQueueGetIndex)) {
+        return NULL;
+    }
+    return &_txQueue[putIndex & SERIAL_TX_QUEUE_MASK];
+}
+
+// Makes reserved descriptor visible to the interrupt, after it's complete
+void txPublish(void) {
+    _txQueuePutIndex++;
+}
+
+bool txQueue(const uint8_t *data, uint8_t length, serTxSource source) {
+    serTxDescriptor *descriptor = txReserve();
+    if (NULL == descriptor) {
+        return false;
+    }
+    descriptor->from.data = data;
+    descriptor->length = length;
+    descriptor->source = source;
+    txPublish();
+    return true;
+}
+
+// Describes the byte just stored in the transmit ring, called only by the main program
+bool txQueueRing(void) {
+    bool result = false;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        uint8_t putIndex = _txQueuePutIndex;
+        if (putIndex != _txQueueGetIndex) {
+            // the interrupt removes descriptors only when they are finished,
+            // so the last one still has bytes to be sent and can be extended
+            serTxDescriptor *descriptor = &_txQueue[(uint8_t)(putIndex - 1) & SERIAL_TX_QUEUE_MASK];
+            if (SER_TX_RING == descriptor->source) {
+                descriptor->length++;
+                result = true;
+            }
+        }
+        if (false == result) {
+            result = txQueue(NULL, 1, SER_TX_RING);
+        }
+    }
+    return result;
+}
+
+void txWait(void) {
+    if (bit_is_clear(SREG, SREG_I)) {
+        // Interrupts are disabled, so we'll have to poll the data
+        // register empty flag ourselves. If it is set, pretend an
+        // interrupt has happened and call the handler to free up
+        // space for us.
+        if(bit_is_set(*_ucsra, UDRE)) {
+            irqTx();
+        } else {
+            // nop, the interrupt handler will free up space for us
+        }
+    }
+}
+
+void txStart(void) {
+    _written = true;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        // make atomic, since the interrupt clears UDRIE in the same register
+        // USART clock is needed until the queue is empty
+        pwrAllowPowerDown(PWR_SERIAL, false);
+        // enable interrupts
+        *_ucsrb |= _BV(UDRIE);
+    }
 }
 
 // Interrupt handler
 void irqTx(void) {
     // If interrupts are enabled, there must be more data in the output
-    // buffer. Send the next byte
-    if (txAvailable() > 0) {
-        unsigned char c = (unsigned char )txRead();
+    // queue. Send the next byte straight from the source of the first descriptor
+    uint8_t getIndex = _txQueueGetIndex;
+    if (getIndex != _txQueuePutIndex) {
+        serTxDescriptor *descriptor = &_txQueue[getIndex & SERIAL_TX_QUEUE_MASK];
+        uint8_t c = 0;
+        switch (descriptor->source) {
+            case SER_TX_RING : {
+                c = (uint8_t)txRead();
+                descriptor->length--;
+                break;
+            }
+            case SER_TX_RAM : {
+                c = *descriptor->from.data++;
+                descriptor->length--;
+                break;
+            }
+            case SER_TX_FUNCTION : {
+                c = descriptor->from.source();
+                descriptor->length--;
+                break;
+            }
+            case SER_TX_FLASH : {
+                c = pgm_read_byte(descriptor->from.data++);
+                descriptor->length--;
+                break;
+            }
+            default : {
+                // string is never queued empty, so the terminator is checked after each byte
+                c = pgm_read_byte(descriptor->from.data++);
+                if (0 == pgm_read_byte(descriptor->from.data)) {
+                    descriptor->length = 0;
+                }
+            }
+        }
         *_udr = c;
+        if (0 == descriptor->length) {
+            _txQueueGetIndex = getIndex + 1;
+        }
     }
 
     // clear the TXC bit -- "can be cleared by writing a one to its bit
@@ -192,9 +374,13 @@ void irqTx(void) {
     // actually got written. Other r/w bits are preserved, and zeros
     // written to the rest.
     *_ucsra = ((*_ucsra) & (_BV(U2X) | _BV(MPCM))) | _BV(TXC);
-    if (txAvailable() == 0) {
-        // if buffer empty - disable interrupts
+    if (0 == txQueued()) {
+        // if queue empty - disable interrupts
         UCSRB &= ~(1<<UDRIE);
+        // last characters are shifted out long before power-down timeout elapses
+        pwrAllowPowerDown(PWR_SERIAL, true);
+        // output deferred by event handlers can be written now
+        evtPost(EVT_SERIAL_TX);
     }
 }
 
@@ -208,6 +394,7 @@ void irqRx(void) {
         // and so we don't write the character or advance the head.
         if (rxAvailableForWrite() > 0) {
             rxStore(c);
+            evtPost(EVT_SERIAL_RX);
         } else {
             // Parity error, read byte but discard it
             // *_udr;
@@ -237,24 +424,30 @@ void serInitComplete(unsigned long baud, uint8_t config) {
     serSetup(&UBRRH, &UBRRL, &UCSRA, &UCSRB, &UCSRC, &UDR);
     _written = false;
 
-	#define __UBRR F_CPU/16/UART_BAUD-1 
+    serSetBaudRate(baud);
+
+#if defined(__AVR_ATmega8__) || defined(__AVR_ATmega16__) || defined(__AVR_ATmega32__)
+    config |= _BV(URSEL); // select UCSRC register (shared with UBRRH)
+#endif
+    *_ucsrc = config;
+
+    *_ucsrb |= (_BV(RXEN) | _BV(TXEN) | _BV(RXCIE));
+}
+
+void serSetBaudRate(unsigned long baud) {
+	// U2X divisor rounded to the nearest value, exact for all rates dividing F_CPU / 8
 	uint16_t baud_setting = (F_CPU / 4 / baud - 1) / 2;
+	// TXC is written as zero, so it's not cleared and serFlush still sees completed transmission
 	if (baud_setting > 0xFFF) {
 		baud_setting /= 2;
-	    *_ucsra &= ~_BV(U2X);
+	    *_ucsra = (*_ucsra) & _BV(MPCM);
 	} else {
-	    *_ucsra |= _BV(U2X);
+	    *_ucsra = ((*_ucsra) & _BV(MPCM)) | _BV(U2X);
 	}
 
+    // UBRRL is written last, it updates the baud rate prescaler
     *_ubrrh =  baud_setting >> 8;
     *_ubrrl =  baud_setting & 0xFF;
-
-#if defined(__AVR_ATmega8__) || defined(__AVR_ATmega16__) || defined(__AVR_ATmega32__)
-    config |= _BV(URSEL); // select UCSRC register (shared with UBRRH)
-#endif
-    *_ucsrc = config;
-
-    *_ucsrb |= (_BV(RXEN) | _BV(TXEN) | _BV(RXCIE));
 }
 
 void serInit(unsigned long baud) {
@@ -304,44 +497,48 @@ int serRead(void) {
 }
 
 int serAvailableLines(void) {
-    return _rxBufferLines;
+    return (uint8_t)(_rxBufferLinesStored - _rxBufferLinesRead);
 }
 
-void serReadLine(char *buf, uint8_t maxLen) {
+int serReadLine(char *buf, uint8_t maxLen) {
     if (serAvailableLines() > 0) {
-        char c = 0;
-        while (maxLen-- > 0) {
-            c = rxRead();
-            if ('\n' == c) {
-                *buf++ = 0;
-            } else if ('\r' == c) {
-                *buf++ = 0;
-                break;
-            } else if (0 == c) {
+        uint8_t length = 0;
+        int c;
+        // whole line is already stored, so reading stops at the terminator at the latest
+        while ((c = rxRead()) >= 0 && _rxTerminationChar != c) {
+            if ('\n' == c || '\r' == c || 0 == c) {
+                // remaining line end characters of the other convention
                 continue;
-            } else {
-                *buf++ = c;
             }
+            if (length + 1 < maxLen) {
+                buf[length++] = c;
+            }
+            // characters beyond maxLen are dropped up to the terminator
+        }
+        if (maxLen > 0) {
+            buf[length] = 0;
         }
+        return length;
     } else if (true == _rxBufferOverflow) {
         // protect situation when buffer overflow happened
         // in this case data is corrupted anyway
         rxFlush();
     }
+    return -1;
 }
 
 
 int serAvailableForWrite(void) {
-    return SERIAL_TX_BUFFER_SIZE - _txBufferLength;
+    return SERIAL_TX_BUFFER_SIZE - txAvailable();
 }
 
 size_t serWriteChar(uint8_t c) {
     _written = true;
-    // If the buffer and the data register is empty, just write the byte
+    // If the queue and the data register is empty, just write the byte
     // to the data register and be done. This shortcut helps
     // significantly improve the effective data-rate at high (> 500kbit/s)
     // bit-rates, where interrupt overhead becomes a slowdown.
-    if (0 == txAvailable() && bit_is_set(*_ucsra, UDRE)) {
+    if (0 == txQueued() && bit_is_set(*_ucsra, UDRE)) {
         // If TXC is cleared before writing UDR and the previous byte
         // completes before writing to UDR, TXC will be set but a byte
         // is still being transmitted causing flush() to return too soon.
@@ -359,29 +556,65 @@ size_t serWriteChar(uint8_t c) {
     // If the output buffer is full, there's nothing for it other than to
     // wait for the interrupt handler to empty it a bit
     while (serAvailableForWrite() == 0) {
-        if (bit_is_clear(SREG, SREG_I)) {
-            // Interrupts are disabled, so we'll have to poll the data
-            // register empty flag ourselves. If it is set, pretend an
-            // interrupt has happened and call the handler to free up
-            // space for us.
-            if(bit_is_set(*_ucsra, UDRE)) {
-                irqTx();
-            } else {
-                // nop, the interrupt handler will free up space for us
-            }
-        }
+        txWait();
     }
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-        // make atomic to prevent execution of ISR between adding
-        // new character to the buffer and setting the interrupt flag
-        // resulting in buffer retransmission
-        txStore(c);
-        // enable interrupts
-        *_ucsrb |= _BV(UDRIE);
+    // ring is owned by the main program on this side, so the byte is stored without disabling interrupts,
+    // the interrupt doesn't read it until it's described in the queue
+    txStore(c);
+    while (false == txQueueRing()) {
+        txWait();
     }
+    txStart();
     return 1;
 }
 
+bool serSendBuffer(const uint8_t *buf, uint8_t len) {
+    if (0 == len) {
+        return true;
+    }
+    if (false == txQueue(buf, len, SER_TX_RAM)) {
+        return false;
+    }
+    txStart();
+    return true;
+}
+
+bool serSendBuffer_P(const uint8_t *buf, uint8_t len) {
+    if (0 == len) {
+        return true;
+    }
+    if (false == txQueue(buf, len, SER_TX_FLASH)) {
+        return false;
+    }
+    txStart();
+    return true;
+}
+
+bool serSendFromSource(SerTxSource *source, uint8_t len) {
+    if (0 == len) {
+        return true;
+    }
+    serTxDescriptor *descriptor = txReserve();
+    if (NULL == descriptor) {
+        return false;
+    }
+    descriptor->from.source = source;
+    descriptor->length = len;
+    descriptor->source = SER_TX_FUNCTION;
+    txPublish();
+    txStart();
+    return true;
+}
+
+int serPendingTransfers(void) {
+    return txQueued();
+}
+
+bool serWritable(uint8_t bytes, uint8_t transfers) {
+    // if it's false, the queue isn't empty, so EVT_SERIAL_TX is posted later
+    return serAvailableForWrite() >= bytes && SERIAL_TX_QUEUE_SIZE_OF - txQueued() >= transfers;
+}
+
 void serPrintString(const char *str) {
     const unsigned char *strTmp = (const unsigned char *) str;
     while (0 != *strTmp) {
@@ -390,11 +623,15 @@ void serPrintString(const char *str) {
 }
 
 void serPrintString_P(const char *str) {
-    register char c = 0;
-    const unsigned char *strTmp = (const unsigned char *) str;
-    while (0 != (c = pgm_read_byte(strTmp++))) {
-        serWriteChar(c);
+    const uint8_t *strTmp = (const uint8_t *) str;
+    if (0 == pgm_read_byte(strTmp)) {
+        return;
+    }
+    // string is streamed from flash by the interrupt, caller waits only if the queue is full
+    while (false == txQueue(strTmp, 1, SER_TX_FLASH_STRING)) {
+        txWait();
     }
+    txStart();
 }
 
 void serPrintLn(void) {
@@ -428,10 +665,11 @@ void serPrintNumber(unsigned long n, uint8_t base) {
         char c = m - base * n;
         *--str = (c < 10 ? c + '0' : c + 'A' - 10);
     } while (0 != n);
+    serPrintString(str);
 }
 
 void serPrintHex(unsigned long n) {
-    serPrintLnString_P(_strPrefixHex);
+    serPrintString_P(_strPrefixHex);
     serPrintNumber(n, SERIAL_STR_HEX);
 }
 
@@ -440,8 +678,8 @@ void serPrintDec(unsigned long n) {
 }
 
 void serPrintOct(unsigned long n) {
-    serPrintLnString_P(_strPrefixHex);
-    serPrintNumber(n, SERIAL_STR_HEX);
+    serPrintString_P(_strPrefixOct);
+    serPrintNumber(n, SERIAL_STR_OCT);
 }
 
 void serSendBinary(const uint8_t *buf, uint8_t len) {
@@ -42,6 +42,9 @@
 
 #include "SerialDefs.h"
 
+/// Function returning next byte to be sent, called from the transmit interrupt.
+typedef uint8_t SerTxSource(void);
+
 /// Terminal color definitions.
 typedef enum {
 /// Black
@@ -92,6 +95,13 @@ Initialization of the Hardware Serial interface with specific baud rate and conf
 */
 void serInitComplete(unsigned long baud, uint8_t config);
 
+/**
+Changes baud rate of already initialized serial interface, U2X is used whenever divisor fits.
+Pending transmission should be finished with #serFlush before, since bytes being shifted out are corrupted.
+@param baud New speed of transmission.
+*/
+void serSetBaudRate(unsigned long baud);
+
 /**
 Makes sure that all data in transmission serial buffer are transmitted.
 Waits until transmission buffer is empty and data are transferred. 
@@ -138,12 +148,17 @@ by character defined in #serSetTerminationCharacter function.
 int serAvailableLines(void);
 
 /**
-Copies the next line from serial receive buffer to buf variable.
-The length of copy is limited to maxLen value to avoid buffer overflows.
+Copies the next complete line from serial receive buffer to buf variable without the terminator.
+It never waits, nothing is read until the terminator defined in #serSetTerminationCharacter
+is received. The line is always terminated by '\0' and characters not fitting in maxLen - 1
+are dropped, so the next call starts at the next line. Other line end characters ('\r', '\n')
+are skipped, so both conventions are accepted.
+If the receive buffer overflowed without complete line, it's flushed.
 @result buf Target buffer to which content of the next line from Serial receive buffer will be copied.
-@param maxLen Maximum length of the copied buffer. To be set to the available buffer length.
+@param maxLen Size of the target buffer including terminating '\0'.
+@result Number of characters copied to buf or -1 if there is no complete line yet.
 */
-void serReadLine(char *buf, uint8_t maxLen);
+int serReadLine(char *buf, uint8_t maxLen);
 
 /**
 Returns number of available bytes in the serial transmission buffer.
@@ -168,10 +183,56 @@ void serPrintString(const char *str);
 
 /**
 Sends string from program memory terminated by '\0' to serial interface.
+String is not copied, transmit interrupt streams it directly from program memory,
+so the function returns immediately unless the queue of transfers is full.
 @param str String in program memory to be sent to serial interface.
 */
 void serPrintString_P(const char *str);
 
+/**
+Queues buffer in RAM to be sent to serial interface without copying it.
+Buffer can't be changed until it's sent, see #serPendingTransfers and #serFlush.
+@param buf Buffer to be sent.
+@param len Number of bytes to be sent.
+@result true if buffer has been queued, false if the queue of transfers is full.
+*/
+bool serSendBuffer(const uint8_t *buf, uint8_t len);
+
+/**
+Queues buffer in program memory to be sent to serial interface without copying it.
+@param buf Buffer in program memory to be sent.
+@param len Number of bytes to be sent.
+@result true if buffer has been queued, false if the queue of transfers is full.
+*/
+bool serSendBuffer_P(const uint8_t *buf, uint8_t len);
+
+/**
+Queues len bytes to be sent, which are taken one by one from the source function
+in the transmit interrupt. It allows other modules to stream their own buffers without copying them.
+@param source Function returning next byte, called from the interrupt exactly len times.
+@param len Number of bytes to be sent.
+@result true if transfer has been queued, false if the queue of transfers is full.
+*/
+bool serSendFromSource(SerTxSource *source, uint8_t len);
+
+/**
+Returns number of transfers waiting in the transmit queue, including the one being sent.
+Single characters and strings from RAM written one after another share one transfer.
+@result Number of pending transfers.
+*/
+int serPendingTransfers(void);
+
+/**
+Checks if output fits in the transmission buffer and the queue of transfers, so it's written without waiting.
+Event handlers print only what fits and continue in the handler of #EVT_SERIAL_TX,
+which is posted whenever the queue becomes empty.
+@param bytes Number of bytes copied to transmission buffer, e.g. by #serWriteChar or #serPrintString.
+@param transfers Number of transfers, each string from program memory or buffer is one,
+as well as each run of bytes copied to transmission buffer.
+@result true if the output doesn't wait.
+*/
+bool serWritable(uint8_t bytes, uint8_t transfers);
+
 /**
 Sends line termination characters to serial interface.
 */
@@ -192,7 +253,7 @@ void serPrintLnString_P(const char *str);
 
 /**
 Sends specific number converted to base value to the serial interface.
-The conversion is done by itoa() function.
+Digits are computed by division, Format.h provides faster decimal and hexadecimal output.
 @param n Numeric value.
 @param base Base of the numeric value to be converted to.
 */
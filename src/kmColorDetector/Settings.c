@@ -40,6 +40,8 @@ typedef struct {
     RgbColor16_t whiteReference;
     uint8_t availableColors;
     RgbColor8_t colorModels[KMCD_MAX_COLOR_MODELS];
+    uint8_t availablePrototypes;
+    ColorPrototype_t colorPrototypes[KMCD_MAX_COLOR_PROTOTYPES];
 } SettingsStruct;
 
 typedef struct {
@@ -48,6 +50,8 @@ typedef struct {
     const RgbColor16_t whiteReference;
     const uint8_t availableColors;
     const RgbColor8_t colorModels[KMCD_MAX_COLOR_MODELS];
+    const uint8_t availablePrototypes;
+    const ColorPrototype_t colorPrototypes[KMCD_MAX_COLOR_PROTOTYPES];
 } SettingsStruct_C;
 
 static SettingsStruct _RAMsettings;
@@ -56,7 +60,7 @@ static SettingsStruct _EEPROMsettings EEMEM;
 #endif
 
 #ifndef KMCD_NO_EEPROM
-static const SettingsStruct _PROGMEMsettings PROGMEM =  = {
+static const SettingsStruct _PROGMEMsettings PROGMEM = {
       .availableColors = 6
     , .magic = KMCD_MAGIC
     , .blackReference = (RgbColor16_t){.r = 0x00D4, .g = 0x00B8, .b = 0x00D2}
@@ -75,10 +79,23 @@ static const SettingsStruct _PROGMEMsettings PROGMEM =  = {
     , (RgbColor8_t){.r = 0xFF, .g = 0x00, .b = 0x00}
     // yellow
     , (RgbColor8_t){.r = 0xFF, .g = 0xFF, .b = 0x00}
-    //};
+    }
+    , .availablePrototypes = 6
+    , .colorPrototypes =
+    {
+      (ColorPrototype_t){.color = {.r = 0xFF, .g = 0xFF, .b = 0xFF}, .classId = 0} // white
+    , (ColorPrototype_t){.color = {.r = 0x00, .g = 0x00, .b = 0x00}, .classId = 1} // black
+    , (ColorPrototype_t){.color = {.r = 0x40, .g = 0x60, .b = 0xA0}, .classId = 2} // blue
+    , (ColorPrototype_t){.color = {.r = 0x20, .g = 0x60, .b = 0x50}, .classId = 3} // green
+    , (ColorPrototype_t){.color = {.r = 0xFF, .g = 0x00, .b = 0x00}, .classId = 4} // red
+    , (ColorPrototype_t){.color = {.r = 0xFF, .g = 0xFF, .b = 0x00}, .classId = 5} // yellow
+    }
 };
 #endif
 
+// "private" functions
+void settingsValidate(void);
+
 void settingsInit(void) {
 #ifndef KMCD_NO_EEPROM
     eeprom_read_block(&_RAMsettings, &_EEPROMsettings, sizeof(_EEPROMsettings));
@@ -86,6 +103,7 @@ void settingsInit(void) {
         memcpy_P(&_RAMsettings, &_PROGMEMsettings, sizeof(_RAMsettings));
         eeprom_write_block(&_RAMsettings, &_EEPROMsettings, sizeof(_EEPROMsettings));
     }
+    settingsValidate();
 #else
     _RAMsettings.availableColors = KMCD_MAX_COLOR_MODELS;
     _RAMsettings.blackReference = (RgbColor16_t){.r = 0x00D4, .g = 0x00B8, .b = 0x00D2};
@@ -96,11 +114,35 @@ void settingsInit(void) {
     _RAMsettings.colorModels[3] = (RgbColor8_t){.r = 0x40, .g = 0x90, .b = 0x50}; // green
     _RAMsettings.colorModels[4] = (RgbColor8_t){.r = 0xA0, .g = 0x30, .b = 0x30}; // red
     _RAMsettings.colorModels[5] = (RgbColor8_t){.r = 0xFF, .g = 0xFF, .b = 0x50}; // yellow
+    // single prototype for each of the models above
+    _RAMsettings.availablePrototypes = 6;
+    for (uint8_t i = 0; i < _RAMsettings.availablePrototypes; i++) {
+        _RAMsettings.colorPrototypes[i].color = _RAMsettings.colorModels[i];
+        _RAMsettings.colorPrototypes[i].classId = i;
+    }
 
     //memcpy_P(&_RAMsettings, &_PROGMEMsettings, sizeof(_RAMsettings));
 #endif
 }
 
+void settingsValidate(void) {
+    // corrupted EEPROM with valid magic can't make color tools read beyond the tables
+    if (_RAMsettings.availableColors > KMCD_MAX_COLOR_MODELS) {
+        _RAMsettings.availableColors = KMCD_MAX_COLOR_MODELS;
+    }
+    if (_RAMsettings.availablePrototypes > KMCD_MAX_COLOR_PROTOTYPES) {
+        _RAMsettings.availablePrototypes = KMCD_MAX_COLOR_PROTOTYPES;
+    }
+    if (0 == _RAMsettings.availableColors) {
+        _RAMsettings.availablePrototypes = 0;
+    }
+    for (uint8_t i = 0; i < _RAMsettings.availablePrototypes; i++) {
+        if (_RAMsettings.colorPrototypes[i].classId >= _RAMsettings.availableColors) {
+            _RAMsettings.colorPrototypes[i].classId = _RAMsettings.availableColors - 1;
+        }
+    }
+}
+
 RgbColor8_t *settingsGetColorModels(void) {
     return _RAMsettings.colorModels;
 }
@@ -109,6 +151,26 @@ RgbColor8_t settingsGetColorModel(uint8_t colorNumber) {
     return _RAMsettings.colorModels[colorNumber];
 }
 
+void settingsSetColorModel(uint8_t colorNumber, RgbColor8_t colorModel) {
+    _RAMsettings.colorModels[colorNumber] = colorModel;
+}
+
+ColorPrototype_t *settingsGetColorPrototypes(void) {
+    return _RAMsettings.colorPrototypes;
+}
+
+void settingsSetColorPrototype(uint8_t prototypeNumber, ColorPrototype_t prototype) {
+    _RAMsettings.colorPrototypes[prototypeNumber] = prototype;
+}
+
+uint8_t settingsGetAvailableColorPrototypes(void) {
+    return _RAMsettings.availablePrototypes;
+}
+
+void settingsSetAvailableColorPrototypes(uint8_t prototypesAvailable) {
+    _RAMsettings.availablePrototypes = prototypesAvailable;
+}
+
 RgbColor16_t settingsGetBlackReference(void) {
     return _RAMsettings.blackReference;
 }
@@ -129,6 +191,10 @@ uint8_t settingsGetAvailableColorModels(void) {
     return _RAMsettings.availableColors;
 }
 
+void settingsSetAvailableColorModels(uint8_t colorModelsAvailable) {
+    _RAMsettings.availableColors = colorModelsAvailable;
+}
+
 void settingsStore(void) {
 #ifndef KMCD_NO_EEPROM
     eeprom_write_block(&_RAMsettings, &_EEPROMsettings, sizeof(_EEPROMsettings));
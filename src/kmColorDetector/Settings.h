@@ -58,26 +58,67 @@ RgbColor8_t settingsGetColorModel(uint8_t colorNumber);
 RgbColor8_t *settingsGetColorModels(void);
 
 /**
-@param colorNumber
-@param colorModel
+Sets RGB color model of specific number.
+@param colorNumber Number of color model (0 to KMCD_MAX_COLOR_MODELS - 1).
+@param colorModel Normalized RGB color model.
 */
-void settingsSetColorModel(uint8_t colorNumber, HsvColor8_t colorModel);
+void settingsSetColorModel(uint8_t colorNumber, RgbColor8_t colorModel);
+
+/**
+Returns array of color prototypes used for finding nearest color class.
+@result Array of color prototypes with #settingsGetAvailableColorPrototypes valid elements.
+*/
+ColorPrototype_t *settingsGetColorPrototypes(void);
+
+/**
+Sets color prototype of specific number.
+@param prototypeNumber Number of the prototype (0 to KMCD_MAX_COLOR_PROTOTYPES - 1).
+@param prototype Color prototype with assigned class number.
+*/
+void settingsSetColorPrototype(uint8_t prototypeNumber, ColorPrototype_t prototype);
+
+/**
+@result Number of valid color prototypes.
+*/
+uint8_t settingsGetAvailableColorPrototypes(void);
+
+/**
+@param prototypesAvailable Number of valid color prototypes (up to KMCD_MAX_COLOR_PROTOTYPES).
+*/
+void settingsSetAvailableColorPrototypes(uint8_t prototypesAvailable);
 
 /**
 @result
 */
 RgbColor16_t settingsGetBlackReference(void);
 
+/**
+Sets raw sensor measure of black used for normalization, see #colorSetBlackReference.
+@param blackReference Raw RGB measure of black.
+*/
+void settingsSetBlackReference(RgbColor16_t blackReference);
+
 /**
 @result
 */
 RgbColor16_t settingsGetWhiteReference(void);
 
+/**
+Sets raw sensor measure of white used for normalization, see #colorSetWhiteReference.
+@param whiteReference Raw RGB measure of white.
+*/
+void settingsSetWhiteReference(RgbColor16_t whiteReference);
+
 /**
 @result
 */
 uint8_t settingsGetAvailableColorModels(void);
 
+/**
+@param colorModelsAvailable Number of valid color models (up to KMCD_MAX_COLOR_MODELS).
+*/
+void settingsSetAvailableColorModels(uint8_t colorModelsAvailable);
+
 /**
 */
 void settingsStore(void);
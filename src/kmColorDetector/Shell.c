@@ -0,0 +1,128 @@
+/*
+ * Shell.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <avr/pgmspace.h>
+
+#include "Shell.h"
+
+// "Private" functions.
+bool shlIsSeparator(char c);
+int8_t shlDigit(char c, uint8_t base);
+
+// Implementation
+bool shlIsSeparator(char c) {
+	return ' ' == c || '\t' == c;
+}
+
+int8_t shlDigit(char c, uint8_t base) {
+	int8_t digit = -1;
+	if (c >= '0' && c <= '9') {
+		digit = c - '0';
+	} else if (c >= 'a' && c <= 'f') {
+		digit = c - 'a' + 10;
+	} else if (c >= 'A' && c <= 'F') {
+		digit = c - 'A' + 10;
+	}
+	return digit < base ? digit : -1;
+}
+
+uint8_t shlTokenize(char *line, char **argv, uint8_t maxArgs) {
+	uint8_t argc = 0;
+	while (argc < maxArgs) {
+		while (true == shlIsSeparator(*line)) {
+			line++;
+		}
+		if (0 == *line) {
+			break;
+		}
+		argv[argc++] = line;
+		if (argc == maxArgs) {
+			// last word keeps the rest of the line, so extra words aren't silently dropped
+			break;
+		}
+		while (0 != *line && false == shlIsSeparator(*line)) {
+			line++;
+		}
+		if (0 != *line) {
+			*line++ = 0;
+		}
+	}
+	argv[argc] = NULL;
+	return argc;
+}
+
+int8_t shlFind(const ShlCommand_t *commands, uint8_t count, const char *name) {
+	for (uint8_t i = 0; i < count; i++) {
+		const char *commandName = (const char *)pgm_read_ptr(&commands[i].name);
+		if (0 == strcmp_P(name, commandName)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool shlDispatch(const ShlCommand_t *commands, uint8_t count, uint8_t argc, char **argv) {
+	if (0 == argc) {
+		return true;
+	}
+	int8_t i = shlFind(commands, count, argv[0]);
+	if (i < 0) {
+		return false;
+	}
+	ShlHandler *handler = (ShlHandler *)pgm_read_ptr(&commands[i].handler);
+	return handler(argc - 1, argv + 1);
+}
+
+bool shlExecute(const ShlCommand_t *commands, uint8_t count, char *line) {
+	char *argv[SHL_MAX_ARGS + 1];
+	uint8_t argc = shlTokenize(line, argv, SHL_MAX_ARGS);
+	return shlDispatch(commands, count, argc, argv);
+}
+
+bool shlParseUint(const char *str, uint32_t max, uint32_t *value) {
+	uint8_t base = 10;
+	if ('0' == str[0] && ('x' == str[1] || 'X' == str[1])) {
+		base = 16;
+		str += 2;
+	}
+	if (0 == *str) {
+		return false;
+	}
+	uint32_t result = 0;
+	uint32_t limit = max / base;
+	for (; 0 != *str; str++) {
+		int8_t digit = shlDigit(*str, base);
+		if (digit < 0 || result > limit) {
+			return false;
+		}
+		result *= base;
+		if ((uint8_t)digit > max - result) {
+			return false;
+		}
+		result += digit;
+	}
+	*value = result;
+	return true;
+}
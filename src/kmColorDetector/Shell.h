@@ -0,0 +1,115 @@
+/** @file
+ * @brief Command shell parsing lines received over serial debug interface.
+ * Shell.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Line is split into words in place, separators are replaced with '\0' and the words
+ *  are pointed by argv, so neither copies nor heap are used. The first word selects the command
+ *  from the table in program memory, e.g.
+ *  @code
+ *  static const char _cmdMeasure[] PROGMEM = "measure";
+ *  static const ShlCommand_t _commands[] PROGMEM = {
+ *  	{_cmdMeasure, cmdMeasure}
+ *  };
+ *  shlExecute(_commands, SHL_COMMANDS_SIZE_OF(_commands), line);
+ *  @endcode
+ *  Tables can be nested, handler can dispatch its remaining words with #shlDispatch.
+ */
+
+#ifndef SHELL_H_
+#define SHELL_H_
+
+#include "common.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// Number of commands in the table
+#define SHL_COMMANDS_SIZE_OF(T) ((uint8_t)(sizeof(T) / sizeof((T)[0])))
+
+/**
+Definition of the command handler.
+@param argc Number of words following the command name.
+@param argv Words following the command name, argv[argc] is NULL.
+@result false if arguments are invalid.
+*/
+typedef bool ShlHandler(uint8_t argc, char **argv);
+
+/**
+Entry of the command table, the table and the names are stored in program memory.
+*/
+typedef struct {
+	/// Name of the command in program memory
+	const char *name;
+	/// Handler of the command
+	ShlHandler *handler;
+} ShlCommand_t;
+
+/**
+Splits line into words separated by spaces or tabs in place.
+@param line Line terminated by '\0', separators are replaced by '\0'.
+@param argv Array of at least maxArgs + 1 pointers to the words, terminated by NULL.
+@param maxArgs Maximum number of words, the rest of the line is kept in the last word.
+@result Number of words.
+*/
+uint8_t shlTokenize(char *line, char **argv, uint8_t maxArgs);
+
+/**
+Finds the command by its name.
+@param commands Table of the commands in program memory.
+@param count Number of the commands in the table.
+@param name Name of the command.
+@result Index of the command in the table or -1 if not found.
+*/
+int8_t shlFind(const ShlCommand_t *commands, uint8_t count, const char *name);
+
+/**
+Runs handler of the command named by the first word with the remaining words as arguments.
+@param commands Table of the commands in program memory.
+@param count Number of the commands in the table.
+@param argc Number of words including command name.
+@param argv Words including command name.
+@result false if command is unknown or rejected its arguments, true also for no words.
+*/
+bool shlDispatch(const ShlCommand_t *commands, uint8_t count, uint8_t argc, char **argv);
+
+/**
+Splits line into words and runs the command, see #shlTokenize and #shlDispatch.
+Following definitions to be set in config.h file @n
+#define \b SHL_MAX_ARGS maximum number of words in the line including command name@n
+@param commands Table of the commands in program memory.
+@param count Number of the commands in the table.
+@param line Line terminated by '\0', it's modified.
+@result false if command is unknown or rejected its arguments, true also for empty line.
+*/
+bool shlExecute(const ShlCommand_t *commands, uint8_t count, char *line);
+
+/**
+Parses unsigned decimal or hexadecimal (prefixed with "0x") number.
+@param str Word to be parsed.
+@param max The highest accepted value.
+@param value Parsed value, not changed if word is invalid.
+@result false if word isn't a number or it's above max.
+*/
+bool shlParseUint(const char *str, uint32_t max, uint32_t *value);
+
+#endif /* SHELL_H_ */
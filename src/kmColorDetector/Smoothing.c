@@ -0,0 +1,175 @@
+/*
+ * Smoothing.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Smoothing.h"
+
+// "Private" global variables.
+static uint8_t _smtPolicy = SMT_POLICY_NONE;
+
+// exponential moving average in Q8.8 format
+static bool _smtEmaValid = false;
+static uint16_t _smtEmaR;
+static uint16_t _smtEmaG;
+static uint16_t _smtEmaB;
+
+// ring of last votes with histogram of classes in the ring
+static uint8_t _smtVotes[KMCD_SMOOTHING_VOTES];
+static uint8_t _smtVotesHistogram[KMCD_MAX_COLOR_MODELS];
+static uint8_t _smtVotesCount = 0;
+static uint8_t _smtVotesPos = 0;
+static uint8_t _smtMajorityClass = 0;
+
+// hysteresis state
+static bool _smtOutputValid = false;
+static uint8_t _smtOutputClass = 0;
+static uint8_t _smtCandidateClass = 0;
+static uint8_t _smtCandidateCount = 0;
+
+// "Private" functions.
+uint16_t smtEmaUpdate(uint16_t ema, uint8_t value);
+uint8_t smtMajorityVote(uint8_t classId);
+uint8_t smtHysteresis(uint8_t classId);
+
+// Implementation
+void smtInit(uint8_t policy) {
+	smtSetPolicy(policy);
+}
+
+void smtSetPolicy(uint8_t policy) {
+	_smtPolicy = policy;
+	smtReset();
+}
+
+uint8_t smtGetPolicy(void) {
+	return _smtPolicy;
+}
+
+void smtReset(void) {
+	_smtEmaValid = false;
+	for (uint8_t i = 0; i < KMCD_MAX_COLOR_MODELS; i++) {
+		_smtVotesHistogram[i] = 0;
+	}
+	_smtVotesCount = 0;
+	_smtVotesPos = 0;
+	_smtOutputValid = false;
+	_smtCandidateCount = 0;
+}
+
+uint16_t smtEmaUpdate(uint16_t ema, uint8_t value) {
+	// ema += (x - ema) * 2^-KMCD_SMOOTHING_EMA_SHIFT
+	int32_t delta = ((int32_t)value << 8) - ema;
+	return (uint16_t)(ema + (delta >> KMCD_SMOOTHING_EMA_SHIFT));
+}
+
+RgbColor8_t smtFilterColor(RgbColor8_t color) {
+	if (0 == (_smtPolicy & SMT_POLICY_EMA)) {
+		return color;
+	}
+	if (false == _smtEmaValid) {
+		_smtEmaR = (uint16_t)color.r << 8;
+		_smtEmaG = (uint16_t)color.g << 8;
+		_smtEmaB = (uint16_t)color.b << 8;
+		_smtEmaValid = true;
+	} else {
+		_smtEmaR = smtEmaUpdate(_smtEmaR, color.r);
+		_smtEmaG = smtEmaUpdate(_smtEmaG, color.g);
+		_smtEmaB = smtEmaUpdate(_smtEmaB, color.b);
+	}
+	RgbColor8_t result;
+	result.r = (_smtEmaR + 0x80) >> 8;
+	result.g = (_smtEmaG + 0x80) >> 8;
+	result.b = (_smtEmaB + 0x80) >> 8;
+	return result;
+}
+
+uint8_t smtMajorityVote(uint8_t classId) {
+	if (classId >= KMCD_MAX_COLOR_MODELS) {
+		return classId;
+	}
+	bool majorityLost = false;
+	if (KMCD_SMOOTHING_VOTES == _smtVotesCount) {
+		// ring is full - the oldest vote leaves the histogram
+		uint8_t oldest = _smtVotes[_smtVotesPos];
+		_smtVotesHistogram[oldest]--;
+		majorityLost = (oldest == _smtMajorityClass);
+	} else {
+		if (0 == _smtVotesCount) {
+			_smtMajorityClass = classId;
+		}
+		_smtVotesCount++;
+	}
+	_smtVotes[_smtVotesPos] = classId;
+	if (++_smtVotesPos >= KMCD_SMOOTHING_VOTES) {
+		_smtVotesPos = 0;
+	}
+	_smtVotesHistogram[classId]++;
+
+	if (true == majorityLost) {
+		// only when the majority class lost a vote other classes need to be checked,
+		// it's bounded by KMCD_MAX_COLOR_MODELS; on tie the current majority stays
+		for (uint8_t i = 0; i < KMCD_MAX_COLOR_MODELS; i++) {
+			if (_smtVotesHistogram[i] > _smtVotesHistogram[_smtMajorityClass]) {
+				_smtMajorityClass = i;
+			}
+		}
+	} else if (_smtVotesHistogram[classId] > _smtVotesHistogram[_smtMajorityClass]) {
+		_smtMajorityClass = classId;
+	}
+	return _smtMajorityClass;
+}
+
+uint8_t smtHysteresis(uint8_t classId) {
+	if (false == _smtOutputValid) {
+		_smtOutputClass = classId;
+		_smtOutputValid = true;
+	} else if (classId == _smtOutputClass) {
+		_smtCandidateCount = 0;
+	} else {
+		if (classId == _smtCandidateClass && _smtCandidateCount > 0) {
+			_smtCandidateCount++;
+		} else {
+			_smtCandidateClass = classId;
+			_smtCandidateCount = 1;
+		}
+		if (_smtCandidateCount >= KMCD_SMOOTHING_HYSTERESIS) {
+			_smtOutputClass = classId;
+			_smtCandidateCount = 0;
+		}
+	}
+	return _smtOutputClass;
+}
+
+uint8_t smtFilterClass(uint8_t classId) {
+	uint8_t result = classId;
+	if (0 != (_smtPolicy & SMT_POLICY_MAJORITY)) {
+		result = smtMajorityVote(result);
+	}
+	if (0 != (_smtPolicy & SMT_POLICY_HYSTERESIS)) {
+		result = smtHysteresis(result);
+	}
+	return result;
+}
@@ -0,0 +1,88 @@
+/** @file
+ * @brief Temporal smoothing and hysteresis of consecutive color classifications.
+ * Smoothing.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SMOOTHING_H_
+#define SMOOTHING_H_
+
+#include "common.h"
+
+#include <stdint.h>
+
+#include "ColorTools.h"
+
+/// No smoothing, each classification is used as-is.
+#define SMT_POLICY_NONE			0x00
+/// Exponential moving average of the normalized color (used by #smtFilterColor).
+#define SMT_POLICY_EMA			0x01
+/// Majority vote over the last KMCD_SMOOTHING_VOTES class numbers (used by #smtFilterClass).
+#define SMT_POLICY_MAJORITY		0x02
+/// Output class changes only after KMCD_SMOOTHING_HYSTERESIS consecutive agreeing classifications.
+#define SMT_POLICY_HYSTERESIS	0x04
+
+/**
+Initializes smoothing with specific policy. Policies can be combined, e.g.
+SMT_POLICY_EMA | SMT_POLICY_HYSTERESIS.
+Following definitions to be set in config.h file @n
+#define \b KMCD_SMOOTHING_EMA_SHIFT weight of the new sample in EMA as power of two (2 means 1/4)@n
+#define \b KMCD_SMOOTHING_VOTES number of last class numbers used in majority vote@n
+#define \b KMCD_SMOOTHING_HYSTERESIS number of consecutive agreeing classifications to change output class@n
+All routines work in constant time and use only statically allocated memory.
+@param policy Combination of SMT_POLICY_* values.
+*/
+void smtInit(uint8_t policy);
+
+/**
+Changes smoothing policy and resets smoothing history.
+@param policy Combination of SMT_POLICY_* values.
+*/
+void smtSetPolicy(uint8_t policy);
+
+/**
+Returns current smoothing policy.
+@result Combination of SMT_POLICY_* values.
+*/
+uint8_t smtGetPolicy(void);
+
+/**
+Resets smoothing history, so the next sample is used as-is.
+*/
+void smtReset(void);
+
+/**
+Filters normalized color with exponential moving average in case SMT_POLICY_EMA is active.
+@param color Normalized color of the current measure.
+@result Smoothed normalized color or color as-is when SMT_POLICY_EMA is not active.
+*/
+RgbColor8_t smtFilterColor(RgbColor8_t color);
+
+/**
+Filters class number with majority vote and hysteresis in case they are active.
+Class numbers equal or greater than KMCD_MAX_COLOR_MODELS are not voted.
+@param classId Class number of the current measure.
+@result Class number to be used as the output.
+*/
+uint8_t smtFilterClass(uint8_t classId);
+
+#endif /* SMOOTHING_H_ */
@@ -0,0 +1,241 @@
+/*
+ * SoftSerial.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+
+#include "SoftSerial.h"
+#include "TimerDefs.h"
+#include "TimerManager.h"
+#include "Power.h"
+
+#if (SWS_TX_BUFFER_SIZE & (SWS_TX_BUFFER_SIZE - 1)) != 0 || SWS_TX_BUFFER_SIZE > 128
+#error "SWS_TX_BUFFER_SIZE has to be power of two up to 128"
+#endif
+
+// Internal definition of types.
+#define SWS_TX_BUFFER_MASK (SWS_TX_BUFFER_SIZE - 1)
+// Start bit, 8 data bits and stop bit
+#define SWS_FRAME_BITS 10
+// Stop bit and idle line are high
+#define SWS_STOP_BIT (1U << (SWS_FRAME_BITS - 1))
+// CPU cycles between writing OCR0 and the first edge, enough for swsScheduleRun to program the start bit
+#define SWS_START_CYCLES 200
+// Timer0 in normal mode, so OCR0 isn't buffered and can be moved forward in the interrupt
+#define SWS_TCCR0_EDGE_LOW (TCC_0_MODE_0 | TCC0_COMP_OUT_CLEAR)
+#define SWS_TCCR0_EDGE_HIGH (TCC_0_MODE_0 | TCC0_COMP_OUT_SET)
+
+// "Private" global variables.
+static uint8_t _swsTxBuffer[SWS_TX_BUFFER_SIZE];
+static volatile uint8_t _swsTxBufferGetIndex = 0;
+static volatile uint8_t _swsTxBufferPutIndex = 0;
+
+// Clock select bits of Timer0
+static uint8_t _swsPrescalerBits = TCC0_STOP;
+// Timer0 counts per bit and the longest run of equal bits fitting in 8 bit counter
+static uint8_t _swsBitTicks = 0;
+static uint8_t _swsMaxRun = 0;
+// Timer0 counts covering SWS_START_CYCLES
+static uint8_t _swsStartTicks = 0;
+
+// Bits of the current frame not yet scheduled, the next one is LSB
+static uint16_t _swsFrame = 0;
+static uint8_t _swsFrameBits = 0;
+// Length in counts of the run starting at the programmed compare, 0 if line becomes idle there
+static uint8_t _swsRunTicks = 0;
+static volatile bool _swsActive = false;
+
+// Clock select bits and shift of each Timer0 prescaler
+static const uint8_t _swsPrescalers[][2] PROGMEM = {
+	{TCC0_PRSC_1, 0},
+	{TCC0_PRSC_8, 3},
+	{TCC0_PRSC_64, 6},
+	{TCC0_PRSC_256, 8},
+	{TCC0_PRSC_1024, 10}
+};
+
+// "Private" functions.
+uint8_t swsScheduleRun(void);
+void swsStart(void);
+void swsWait(void);
+void irqCompare(void);
+
+// Implementation
+uint8_t swsScheduleRun(void) {
+	// called with OCR0 pointing at the end of the current run, programs level of the next one
+	if (0 == _swsFrameBits) {
+		uint8_t getIndex = _swsTxBufferGetIndex;
+		if (getIndex == _swsTxBufferPutIndex) {
+			// line stays high after the stop bit
+			TCCR0 = SWS_TCCR0_EDGE_HIGH | _swsPrescalerBits;
+			return 0;
+		}
+		// start bit is LSB
+		_swsFrame = SWS_STOP_BIT | ((uint16_t)_swsTxBuffer[getIndex & SWS_TX_BUFFER_MASK] << 1);
+		_swsFrameBits = SWS_FRAME_BITS;
+		_swsTxBufferGetIndex = getIndex + 1;
+	}
+	uint8_t level = _swsFrame & 1;
+	uint8_t run = 0;
+	do {
+		_swsFrame >>= 1;
+		_swsFrameBits--;
+		run++;
+	} while (0 != _swsFrameBits && run < _swsMaxRun && level == (_swsFrame & 1));
+	TCCR0 = (0 != level ? SWS_TCCR0_EDGE_HIGH : SWS_TCCR0_EDGE_LOW) | _swsPrescalerBits;
+	return run * _swsBitTicks;
+}
+
+void swsStart(void) {
+	// called atomically when line is idle and the ring isn't empty
+	pwrAllowPowerDown(PWR_SOFT_SERIAL, false);
+	_swsActive = true;
+	// compare is moved away before the start bit is programmed, so a stale match can't stretch it
+	OCR0 = TCNT0 + _swsStartTicks;
+	_swsRunTicks = swsScheduleRun();
+	uint8_t remaining = OCR0 - TCNT0;
+	if (0 != remaining && remaining <= _swsStartTicks) {
+		// flag of a match before OCR0 was moved, match of the start bit sets it again
+		tmrClearFlags(_BV(OCF0));
+	}
+	tmrEnableInterrupts(_BV(OCIE0));
+}
+
+void swsWait(void) {
+	if (bit_is_clear(SREG, SREG_I)) {
+		// interrupts are disabled, so the compare flag is polled and the handler is called directly
+		if (bit_is_set(TIFR, OCF0)) {
+			tmrClearFlags(_BV(OCF0));
+			irqCompare();
+		}
+	}
+}
+
+void irqCompare(void) {
+	// level of the run programmed before has just been set on the pin by the compare match
+	uint8_t ticks = _swsRunTicks;
+	if (0 == ticks) {
+		// stop bit of the last byte has ended
+		tmrDisableInterrupts(_BV(OCIE0));
+		_swsActive = false;
+		pwrAllowPowerDown(PWR_SOFT_SERIAL, true);
+		return;
+	}
+	OCR0 += ticks;
+	_swsRunTicks = swsScheduleRun();
+}
+
+bool swsInit(uint32_t baud) {
+	if (0 == baud || false == tmrReserve(TMR_TIMER_0, TMR_USER_SOFT_SERIAL, TMR_MODE_EXCLUSIVE)) {
+		return false;
+	}
+	uint32_t cycles = (F_CPU + baud / 2) / baud;
+	int8_t selected = -1;
+	for (uint8_t i = 0; i < sizeof(_swsPrescalers) / sizeof(_swsPrescalers[0]); i++) {
+		uint8_t shift = pgm_read_byte(&_swsPrescalers[i][1]);
+		uint32_t ticks = (cycles + ((1UL << shift) >> 1)) >> shift;
+		if (0 == ticks || ticks > UINT8_MAX) {
+			continue;
+		}
+		if (selected < 0) {
+			// the most accurate prescaler, used if none fits the whole frame
+			selected = i;
+		}
+		if ((ticks << shift) == cycles && ticks * SWS_FRAME_BITS <= UINT8_MAX) {
+			selected = i;
+			break;
+		}
+	}
+	if (selected < 0) {
+		tmrRelease(TMR_TIMER_0, TMR_USER_SOFT_SERIAL);
+		return false;
+	}
+	uint8_t shift = pgm_read_byte(&_swsPrescalers[selected][1]);
+	_swsPrescalerBits = pgm_read_byte(&_swsPrescalers[selected][0]);
+	_swsBitTicks = (cycles + ((1UL << shift) >> 1)) >> shift;
+	_swsMaxRun = UINT8_MAX / _swsBitTicks;
+	// at least one whole count passes, since Timer0 may count just after TCNT0 is read
+	_swsStartTicks = (SWS_START_CYCLES >> shift) + 2;
+	_swsTxBufferGetIndex = _swsTxBufferPutIndex = 0;
+	_swsFrameBits = 0;
+	_swsActive = false;
+
+	// idle line is high, also before OC0 takes over the pin
+	SWS_TX_PORT |= _BV(SWS_TX_PIN);
+	SWS_TX_DDR |= _BV(SWS_TX_PIN);
+	TCCR0 = SWS_TCCR0_EDGE_HIGH | _swsPrescalerBits;
+	// forced compare sets OC0 without interrupt
+	TCCR0 |= _BV(FOC0);
+	return true;
+}
+
+uint8_t swsAvailableForWrite(void) {
+	return SWS_TX_BUFFER_SIZE - (uint8_t)(_swsTxBufferPutIndex - _swsTxBufferGetIndex);
+}
+
+size_t swsWriteChar(uint8_t c) {
+	while (0 == swsAvailableForWrite()) {
+		swsWait();
+	}
+	uint8_t putIndex = _swsTxBufferPutIndex;
+	_swsTxBuffer[putIndex & SWS_TX_BUFFER_MASK] = c;
+	// index is published after the byte is stored
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		_swsTxBufferPutIndex = putIndex + 1;
+		if (false == _swsActive) {
+			swsStart();
+		}
+	}
+	return 1;
+}
+
+void swsPrintString(const char *str) {
+	while (0 != *str) {
+		swsWriteChar(*str++);
+	}
+}
+
+void swsPrintString_P(const char *str) {
+	char c;
+	while (0 != (c = pgm_read_byte(str++))) {
+		swsWriteChar(c);
+	}
+}
+
+void swsSendBinary(const uint8_t *buf, uint8_t len) {
+	while (len-- > 0) {
+		swsWriteChar(*buf++);
+	}
+}
+
+void swsFlush(void) {
+	while (true == _swsActive) {
+		swsWait();
+	}
+}
+
+ISR(TIMER0_COMP_vect) {
+	irqCompare();
+}
@@ -0,0 +1,102 @@
+/** @file
+ * @brief Interrupt driven software UART transmitter on Timer0 compare output.
+ * SoftSerial.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Transmitter uses OC0 pin (PB3 for ATmega32), so bit edges are generated by Timer0 compare match
+ *  in hardware and interrupts of other modules (e.g. INT0 counting sensor pulses) don't add jitter.
+ *  Timer0 runs freely and the compare interrupt only programs the level and time of the next edge,
+ *  so it's issued once per run of equal bits instead of once per bit. Interrupt just has to be served
+ *  before the next edge, at least one bit time (192 cycles at 57600 baud).
+ *  Format is 8N1, only transmission is supported.
+ *
+ *  References:
+ * -# http://ww1.microchip.com/downloads/en/DeviceDoc/doc2503.pdf (chapter 8-bit Timer/Counter0 with PWM)
+ */
+
+#ifndef SOFTSERIAL_H_
+#define SOFTSERIAL_H_
+
+#include "common.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+
+/// Direction register of the transmit pin, OC0 of Timer0
+#define SWS_TX_DDR DDRB
+/// Port register of the transmit pin, OC0 of Timer0
+#define SWS_TX_PORT PORTB
+/// Transmit pin, OC0 of Timer0
+#define SWS_TX_PIN PB3
+
+/**
+Initializes software UART transmitter and reserves Timer0 exclusively.
+Timer0 prescaler is selected so that the number of counts per bit is exact and the whole
+frame fits in 8 bit counter, e.g. prescaler 8 and 24 counts per bit at 57600 baud.
+If there is no such prescaler, the most accurate one is used and long runs are split.
+Following definitions to be set in config.h file @n
+#define \b SWS_TX_BUFFER_SIZE size of the transmit ring, power of two up to 128@n
+@param baud Baud rate, F_CPU / baud has to be lower than 255 * 1024.
+@result false if Timer0 is used by other module or baud rate is out of range.
+*/
+bool swsInit(uint32_t baud);
+
+/**
+Returns number of bytes which can be written without waiting.
+@result Free space in the transmit ring.
+*/
+uint8_t swsAvailableForWrite(void);
+
+/**
+Writes single character to the transmit ring, waits if the ring is full.
+@param c Character to be sent.
+@result Returns 1 in case character has been buffered.
+*/
+size_t swsWriteChar(uint8_t c);
+
+/**
+Writes string terminated by '\0' to the transmit ring.
+@param str String to be sent.
+*/
+void swsPrintString(const char *str);
+
+/**
+Writes string from program memory terminated by '\0' to the transmit ring.
+@param str String in program memory to be sent.
+*/
+void swsPrintString_P(const char *str);
+
+/**
+Writes binary buffer to the transmit ring.
+@param buf Buffer of the binary data.
+@param len Number of bytes to be sent.
+*/
+void swsSendBinary(const uint8_t *buf, uint8_t len);
+
+/**
+Waits until all bytes from the transmit ring are shifted out, including the stop bit of the last one.
+*/
+void swsFlush(void);
+
+#endif /* SOFTSERIAL_H_ */
@@ -28,44 +28,187 @@
 #include <stdbool.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
 
 #include "config.h"
 #include "TimerDefs.h"
+#include "TimerManager.h"
+#include "FixedPoint.h"
+#include "Events.h"
 #include "SoftwareTimer.h"
 
 #define TCC2_TOP TCC_TOP_1
+/// Timer2 counts per second in tickless mode, with prescaler /1024 (10800 for 11.0592MHz)
+#define SWT_TICKLESS_COUNTS_PER_SECOND (F_CPU / 1024UL)
+/// Longest period between two compare interrupts in tickless mode
+#define SWT_TICKLESS_MAX_SEGMENT (TCC2_TOP + 1)
+/// Longest period of Timer2 in CTC mode in counts
+#define TCC2_PERIOD_MAX (TCC2_TOP + 1)
+/// Timer2 counts without prescaler per millisecond in Q16.16 format, rounded up so exact periods are not shortened
+#define SWT_CYCLES_PER_MILLISECOND ((uint32_t)(((uint64_t)(F_CPU) * 65536ULL + 999ULL) / 1000ULL))
+
+TCC_STATIC_ASSERT((uint64_t)UINT16_MAX * SWT_TICKLESS_COUNTS_PER_SECOND <= UINT32_MAX, "Tickless counts of the longest interval don't fit in 32 bits");
+TCC_STATIC_ASSERT((uint64_t)UINT16_MAX * F_CPU / 1000ULL / 256ULL <= (uint64_t)UINT16_MAX * TCC2_PERIOD_MAX, "Soft prescaler of the longest periodic interval doesn't fit in 16 bits");
+/// Duration of single Timer2 count in microseconds in Q16.16 format for specific prescaler, calculated at compile time
+#define SWT_MICROS_PER_COUNT(PRESCALER) ((uint32_t)(1000000ULL * 65536ULL * (PRESCALER) / (F_CPU)))
+
+/// End of the list of software timers
+#define SWT_NIL 0xFF
+
+#if SWT_SIZE_OF >= SWT_NIL
+#error "SWT_SIZE_OF needs to be lower than 255"
+#endif
+
+/// Mask of the index in the ring of expired timers
+#define SWT_EXPIRED_MASK (SWT_EXPIRED_SIZE_OF - 1)
+
+#if SWT_EXPIRED_SIZE_OF & SWT_EXPIRED_MASK || SWT_EXPIRED_SIZE_OF > 128
+#error "SWT_EXPIRED_SIZE_OF needs to be power of two not greater than 128"
+#endif
+
+#if defined(SWT_STATS) && !defined(SWT_CLOCK)
+#error "SWT_STATS requires Timer2 counts of swtMicros clock, define SWT_CLOCK"
+#endif
 
 // Internal definition of types.
+/// Timer is stopped
+#define SWT_STATE_IDLE 0
+/// Timer is waiting in the delta queue
+#define SWT_STATE_QUEUED 1
+/// Timer is expired and waiting for dispatch in swtLoop
+#define SWT_STATE_EXPIRED 2
+
 typedef struct {
-	bool enabled;
-	SwtValueType currentValue;
 	SwtCallback *_timerCallback;
 	void *userData;
+	// Ticks (Timer2 counts in tickless mode) to expire counted from the expiry of the previous timer in the queue
+	uint32_t delta;
+	// Number of the next timer in the queue
+	uint8_t next;
+	uint8_t state;
+#ifdef SWT_STATS
+	// Timer2 counts at the expiry, set in the interrupt
+	uint32_t expiredAt;
+#endif
 } swtItem;
 
+#ifdef SWT_STATS
+typedef struct {
+	uint16_t dispatches;
+	uint16_t latenessMin;
+	uint16_t latenessMax;
+	uint16_t durationMax;
+	uint32_t latenessSum;
+	uint32_t durationSum;
+} swtStatsItem;
+#endif
+
 // "Private" global variables.
-static swtItem _timers[SWT_SIZE_OF];
+// Shared with Timer2 interrupt, which changes only queued timers. Main loop changes the queue
+// with interrupts disabled, while expired timers are handed over without disabling interrupts.
+static volatile swtItem _timers[SWT_SIZE_OF];
+// Queue of running timers sorted by expiry time, each one keeps only the difference to the previous one,
+// so the tick needs to decrement only the head
+static volatile uint8_t _swtQueueHead = SWT_NIL;
+// Single producer single consumer ring of expired timer numbers. Interrupt writes the number
+// and then increments the head, swtLoop reads it and then increments the tail.
+// Single byte indexes are read and written atomically, so the loop never disables interrupts.
+static volatile uint8_t _swtExpired[SWT_EXPIRED_SIZE_OF];
+static volatile uint8_t _swtExpiredHead = 0;
+static volatile uint8_t _swtExpiredTail = 0;
+// Ring was full, expired timers need to be found by their state
+static volatile bool _swtExpiredOverflow = false;
 static volatile SwtValueType _mainInterval = 0;
+static bool _swtTickless = false;
+// Number of Timer2 counts between the start of current segment and the programmed compare match,
+// 0 when no interrupt is expected in tickless mode
+static volatile uint16_t _swtSegment = 0;
+#ifdef SWT_CLOCK
+// Clock extended by software in each compare interrupt, both values wrap after 2^32
+static volatile uint32_t _swtMicros = 0;
+static volatile uint32_t _swtMillis = 0;
+// Fraction of microsecond in Q0.16 not yet added to _swtMicros
+static volatile uint16_t _swtMicrosFraction = 0;
+// Microseconds not yet added to _swtMillis
+static volatile uint16_t _swtMillisMicros = 0;
+// Duration of single Timer2 count in Q16.16 format
+static uint32_t _swtMicrosPerCount = 0;
+#endif
+#ifdef SWT_STATS
+// Timer2 counts since initialization, wraps after 2^32
+static volatile uint32_t _swtCounts = 0;
+static swtStatsItem _swtStats[SWT_SIZE_OF];
+#endif
 static volatile uint16_t _softPrescallerInit = 0;
 static volatile uint16_t _softPrescallerCurrent = 0;
 
 // "Private" functions.
-void timer2SetPeriod(int32_t miliseconds);
+void timer2SetPeriod(uint16_t miliseconds);
+void swtExpiredAppend(uint8_t timerNo);
+void swtDispatch(uint8_t timerNo);
+void swtQueueInsert(uint8_t timerNo, uint32_t ticks);
+void swtQueueRemove(uint8_t timerNo);
+void swtQueueAdvance(uint32_t elapsed);
+uint32_t swtMilisecondsToTicks(SwtValueType miliseconds);
+uint16_t swtSegmentElapsed(void);
+void swtSegmentProgram(void);
+void swtSegmentUpdate(void);
+#ifdef SWT_CLOCK
+void swtClockSetPrescaler(uint8_t prescalerSelectBits);
+void swtClockAdvance(uint16_t counts);
+#endif
+#ifdef SWT_STATS
+uint32_t swtClockCounts(void);
+uint16_t swtStatsSaturate(uint32_t counts);
+void swtStatsUpdate(uint8_t timerNo, uint32_t lateness, uint32_t duration);
+#endif
 
 // Implementation
-void swtInit(int16_t miliseconds) {
+bool swtInit(int16_t miliseconds) {
 	_mainInterval = miliseconds;
 	for (int i = 0; i < SWT_SIZE_OF; i++) {
-		_timers[i].enabled = false;
+		_timers[i].state = SWT_STATE_IDLE;
 		_timers[i]._timerCallback = NULL;
-		_timers[i].currentValue = 0;
+		_timers[i].delta = 0;
+		_timers[i].next = SWT_NIL;
+	}
+	_swtQueueHead = SWT_NIL;
+	_swtExpiredHead = 0;
+	_swtExpiredTail = 0;
+	_swtExpiredOverflow = false;
+	_swtSegment = 0;
+	_swtTickless = SWT_INTERVAL_TICKLESS == miliseconds;
+#ifdef SWT_STATS
+	swtResetStats();
+#endif
+	// Period of Timer2 is changed by the scheduler at any time, so it can't be shared
+	if (false == tmrReserve(TMR_TIMER_2, TMR_USER_SCHEDULER, TMR_MODE_EXCLUSIVE)) {
+		return false;
 	}
 	/// Timer2 mode 2 - CTC top value OCR2
 	TCCR2 |= TCC_2_MODE_2;
-	/// Timer/Counter2 Output Compare Match Interrupt Enable
-	TIMSK = _BV(OCIE2);
-	// set prescaler and OCR2
-	timer2SetPeriod(miliseconds);
+	if (true == _swtTickless) {
+		TCCR2 |= TCC2_PRSC_1024;
+#ifndef SWT_CLOCK
+		// Compare interrupt is enabled only when any timer is running
+		tmrDisableInterrupts(_BV(OCIE2));
+#else
+		// Clock needs interrupt at least once per counter period, also when no timer is running
+		swtClockSetPrescaler(TCC2_PRSC_1024);
+		TCNT2 = 0;
+		swtSegmentProgram();
+		// counter could match the previous compare value before the new one was written
+		tmrClearFlags(_BV(OCF2));
+		tmrEnableInterrupts(_BV(OCIE2));
+#endif
+	} else {
+		/// Timer/Counter2 Output Compare Match Interrupt Enable, interrupts of other timers are kept
+		tmrEnableInterrupts(_BV(OCIE2));
+		// set prescaler and OCR2
+		timer2SetPeriod(miliseconds);
+		_swtSegment = OCR2 + 1;
+	}
+	return true;
 }
 
 void swtDisable(void) {
@@ -73,85 +216,419 @@ void swtDisable(void) {
 }
 
 void swtLoop(void) {
-	for (int i = 0; i < SWT_SIZE_OF; i++) {
-		if (true == _timers[i].enabled && 0 == _timers[i].currentValue) {
-			SwtValueType newCurrent = 0;
-			_timers[i]._timerCallback(_timers[i].userData, &newCurrent);
-			if (0 == newCurrent) {
-				_timers[i].enabled = false;
-			}
-			_timers[i].currentValue = newCurrent / _mainInterval;
+	// only expired timers are visited, callbacks can start and stop timers freely
+	while (_swtExpiredTail != _swtExpiredHead) {
+		uint8_t timerNo = _swtExpired[_swtExpiredTail & SWT_EXPIRED_MASK];
+		_swtExpiredTail++;
+		swtDispatch(timerNo);
+	}
+	if (true == _swtExpiredOverflow) {
+		_swtExpiredOverflow = false;
+		for (uint8_t i = 0; i < SWT_SIZE_OF; i++) {
+			swtDispatch(i);
 		}
 	}
 }
 
+void swtDispatch(uint8_t timerNo) {
+	// Interrupt doesn't touch expired timers, so state can be changed without disabling interrupts.
+	// Timer stopped or restarted after expiry leaves stale number in the ring, which is skipped here,
+	// so callback is never issued twice for single expiry.
+	if (SWT_STATE_EXPIRED != _timers[timerNo].state) {
+		return;
+	}
+	_timers[timerNo].state = SWT_STATE_IDLE;
+	SwtValueType newCurrent = 0;
+#ifdef SWT_STATS
+	// expiry is read before the callback, which can start the timer again
+	uint32_t dispatchedAt = swtClockCounts();
+	uint32_t lateness = dispatchedAt - _timers[timerNo].expiredAt;
+#endif
+	_timers[timerNo]._timerCallback(_timers[timerNo].userData, &newCurrent);
+#ifdef SWT_STATS
+	swtStatsUpdate(timerNo, lateness, swtClockCounts() - dispatchedAt);
+#endif
+	if (0 != newCurrent) {
+		swtStart(timerNo, newCurrent);
+	}
+}
+
 void swtRegisterCallback(uint8_t timerNo, void *userData, void (*callback)(void *, SwtValueType *)) {
-	_timers[timerNo].enabled = false;
-	_timers[timerNo].currentValue = 0;
+	swtQueueRemove(timerNo);
 	_timers[timerNo]._timerCallback = callback;
 	_timers[timerNo].userData = userData;
 }
 
 void swtUnregisterCallback(uint8_t timerNo) {
-	_timers[timerNo].enabled = false;
-	_timers[timerNo].currentValue = 0;
+	swtQueueRemove(timerNo);
 	_timers[timerNo]._timerCallback = NULL;
 	_timers[timerNo].userData = NULL;
 }
 
 void swtStart(uint8_t timerNo, SwtValueType miliseconds) {
-	_timers[timerNo].enabled = true;
-	_timers[timerNo].currentValue = miliseconds / _mainInterval;
+	uint32_t ticks = swtMilisecondsToTicks(miliseconds);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		swtQueueRemove(timerNo);
+		if (true == _swtTickless && ticks > 0) {
+			// deltas in the queue are counted from the start of current segment
+			ticks += swtSegmentElapsed();
+		}
+		swtQueueInsert(timerNo, ticks);
+		if (true == _swtTickless) {
+			swtSegmentUpdate();
+		}
+	}
+}
+
+uint32_t swtMilisecondsToTicks(SwtValueType miliseconds) {
+	if (true == _swtTickless) {
+		return (uint32_t)miliseconds * SWT_TICKLESS_COUNTS_PER_SECOND / 1000UL;
+	}
+	return miliseconds / _mainInterval;
+}
+
+void swtExpiredAppend(uint8_t timerNo) {
+	// called from interrupt or with interrupts disabled, so there is always single producer
+	_timers[timerNo].state = SWT_STATE_EXPIRED;
+	_timers[timerNo].next = SWT_NIL;
+#ifdef SWT_STATS
+	_timers[timerNo].expiredAt = swtClockCounts();
+#endif
+	uint8_t head = _swtExpiredHead;
+	if ((uint8_t)(head - _swtExpiredTail) < SWT_EXPIRED_SIZE_OF) {
+		_swtExpired[head & SWT_EXPIRED_MASK] = timerNo;
+		_swtExpiredHead = head + 1;
+	} else {
+		_swtExpiredOverflow = true;
+	}
+	evtPost(EVT_TIMER_EXPIRED);
+}
+
+void swtQueueInsert(uint8_t timerNo, uint32_t ticks) {
+	if (0 == ticks) {
+		// nothing to wait for, dispatch in the next swtLoop
+		swtExpiredAppend(timerNo);
+		return;
+	}
+	// find position, timers with the same expiry are kept in order of start
+	uint8_t previous = SWT_NIL;
+	uint8_t current = _swtQueueHead;
+	while (SWT_NIL != current && ticks >= _timers[current].delta) {
+		ticks -= _timers[current].delta;
+		previous = current;
+		current = _timers[current].next;
+	}
+	_timers[timerNo].delta = ticks;
+	_timers[timerNo].next = current;
+	_timers[timerNo].state = SWT_STATE_QUEUED;
+	if (SWT_NIL != current) {
+		_timers[current].delta -= ticks;
+	}
+	if (SWT_NIL == previous) {
+		_swtQueueHead = timerNo;
+	} else {
+		_timers[previous].next = timerNo;
+	}
+}
+
+void swtQueueRemove(uint8_t timerNo) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if (SWT_STATE_QUEUED == _timers[timerNo].state) {
+			uint8_t previous = SWT_NIL;
+			uint8_t current = _swtQueueHead;
+			while (current != timerNo) {
+				previous = current;
+				current = _timers[current].next;
+			}
+			uint8_t next = _timers[timerNo].next;
+			if (SWT_NIL == previous) {
+				_swtQueueHead = next;
+			} else {
+				_timers[previous].next = next;
+			}
+			// following timer takes over the remaining time
+			if (SWT_NIL != next) {
+				_timers[next].delta += _timers[timerNo].delta;
+			}
+			_timers[timerNo].next = SWT_NIL;
+		}
+		// expired timer is left in the ring and skipped in swtDispatch
+		_timers[timerNo].state = SWT_STATE_IDLE;
+	}
+}
+
+void swtQueueAdvance(uint32_t elapsed) {
+	// move all timers expiring within elapsed ticks to the expired list and decrement the new head
+	uint8_t head = _swtQueueHead;
+	while (SWT_NIL != head && elapsed >= _timers[head].delta) {
+		elapsed -= _timers[head].delta;
+		_swtQueueHead = _timers[head].next;
+		swtExpiredAppend(head);
+		head = _swtQueueHead;
+	}
+	if (SWT_NIL != head) {
+		_timers[head].delta -= elapsed;
+	}
+}
+
+uint16_t swtSegmentElapsed(void) {
+	if (0 == _swtSegment) {
+		// no segment is running, new one starts now
+		return 0;
+	}
+	uint16_t elapsed = TCNT2;
+	if (TIFR & _BV(OCF2)) {
+		// compare match already happened, but interrupt is not yet served,
+		// counter is read again, since it could be cleared after the first read
+		elapsed = TCNT2 + _swtSegment;
+	}
+	return elapsed;
 }
 
-void timer2SetPeriod(int32_t miliseconds) {
-	int64_t cycles = (int64_t)(F_CPU);
-	cycles *= miliseconds;
-	cycles /= 1000ULL;
+void swtSegmentProgram(void) {
+	// next compare match at the head expiry, or after full counter period for longer delays
+	uint8_t head = _swtQueueHead;
+#ifndef SWT_CLOCK
+	if (SWT_NIL == head) {
+		// nothing to wait for, no more interrupts until next swtStart
+		tmrDisableInterrupts(_BV(OCIE2));
+		_swtSegment = 0;
+		return;
+	}
+	uint32_t delta = _timers[head].delta;
+#else
+	// nothing to wait for, only the clock is extended after full counter period
+	uint32_t delta = SWT_NIL == head ? SWT_TICKLESS_MAX_SEGMENT : _timers[head].delta;
+#endif
+	// segment starts at the compare match, but the interrupt can be served a few counts later,
+	// so the compare value is kept ahead of the counter, otherwise it's missed until the counter wraps
+	uint16_t earliest = TCNT2 + 2;
+	if (delta < earliest) {
+		delta = earliest;
+	}
+	_swtSegment = delta < SWT_TICKLESS_MAX_SEGMENT ? delta : SWT_TICKLESS_MAX_SEGMENT;
+	OCR2 = _swtSegment - 1;
+}
+
+void swtSegmentUpdate(void) {
+	uint8_t head = _swtQueueHead;
+	if (SWT_NIL == head) {
+		return;
+	}
+	if (0 == _swtSegment) {
+		// wake up from idle, start new segment
+		TCNT2 = 0;
+		swtSegmentProgram();
+		// counter could match the previous compare value before the new one was written
+		tmrClearFlags(_BV(OCF2));
+		tmrEnableInterrupts(_BV(OCIE2));
+		return;
+	}
+	// counter is read before the flag, so a compare match between both reads is not missed,
+	// when the flag is clear, the counter was read within the running segment
+	uint16_t earliest = TCNT2 + 2;
+	if (_timers[head].delta < _swtSegment && 0 == (TIFR & _BV(OCF2))) {
+		// new head expires before the running segment ends, shorten it
+		// keeping a margin, so the compare value is not passed before it's written
+		uint16_t segment = _timers[head].delta > earliest ? _timers[head].delta : earliest;
+		if (segment < _swtSegment) {
+			OCR2 = segment - 1;
+			_swtSegment = segment;
+		}
+	}
+}
+
+#ifdef SWT_CLOCK
+uint32_t swtMicros(void) {
+	uint16_t elapsed;
+	uint16_t fraction;
+	uint32_t result;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		elapsed = swtSegmentElapsed();
+		fraction = _swtMicrosFraction;
+		result = _swtMicros;
+	}
+	// counts of the current segment are added outside of the atomic block
+	return result + ((fxMulU16U32(elapsed, _swtMicrosPerCount) + fraction) >> 16);
+}
+
+uint32_t swtMillis(void) {
+	uint16_t elapsed;
+	uint16_t fraction;
+	uint16_t micros;
+	uint32_t result;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		elapsed = swtSegmentElapsed();
+		fraction = _swtMicrosFraction;
+		micros = _swtMillisMicros;
+		result = _swtMillis;
+	}
+	micros += (fxMulU16U32(elapsed, _swtMicrosPerCount) + fraction) >> 16;
+	return result + micros / 1000;
+}
+
+void swtClockSetPrescaler(uint8_t prescalerSelectBits) {
+	switch (prescalerSelectBits) {
+		case TCC2_PRSC_1: {
+			_swtMicrosPerCount = SWT_MICROS_PER_COUNT(1);
+			break;
+		}
+		case TCC2_PRSC_8: {
+			_swtMicrosPerCount = SWT_MICROS_PER_COUNT(8);
+			break;
+		}
+		case TCC2_PRSC_32: {
+			_swtMicrosPerCount = SWT_MICROS_PER_COUNT(32);
+			break;
+		}
+		case TCC2_PRSC_64: {
+			_swtMicrosPerCount = SWT_MICROS_PER_COUNT(64);
+			break;
+		}
+		case TCC2_PRSC_128: {
+			_swtMicrosPerCount = SWT_MICROS_PER_COUNT(128);
+			break;
+		}
+		case TCC2_PRSC_256: {
+			_swtMicrosPerCount = SWT_MICROS_PER_COUNT(256);
+			break;
+		}
+		default: {
+			_swtMicrosPerCount = SWT_MICROS_PER_COUNT(1024);
+			break;
+		}
+	}
+}
+
+void swtClockAdvance(uint16_t counts) {
+#ifdef SWT_STATS
+	_swtCounts += counts;
+#endif
+	// at most 256 counts of up to ~93us each, so microseconds of single segment fit in 16 bits
+	uint32_t micros = fxMulU16U32(counts, _swtMicrosPerCount) + _swtMicrosFraction;
+	_swtMicrosFraction = (uint16_t)micros;
+	_swtMicros += micros >> 16;
+	uint16_t millisMicros = _swtMillisMicros + (uint16_t)(micros >> 16);
+	_swtMillis += millisMicros / 1000;
+	_swtMillisMicros = millisMicros % 1000;
+}
+#endif
+
+#ifdef SWT_STATS
+uint32_t swtClockCounts(void) {
+	uint32_t result;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		result = _swtCounts + swtSegmentElapsed();
+	}
+	return result;
+}
+
+uint16_t swtStatsSaturate(uint32_t counts) {
+	return counts > UINT16_MAX ? UINT16_MAX : (uint16_t)counts;
+}
+
+void swtStatsUpdate(uint8_t timerNo, uint32_t lateness, uint32_t duration) {
+	swtStatsItem *stats = &_swtStats[timerNo];
+	if (UINT16_MAX == stats->dispatches) {
+		// sums can't be extended anymore, keep the collected mean
+		return;
+	}
+	uint16_t latenessCounts = swtStatsSaturate(lateness);
+	uint16_t durationCounts = swtStatsSaturate(duration);
+	if (0 == stats->dispatches || latenessCounts < stats->latenessMin) {
+		stats->latenessMin = latenessCounts;
+	}
+	if (latenessCounts > stats->latenessMax) {
+		stats->latenessMax = latenessCounts;
+	}
+	if (durationCounts > stats->durationMax) {
+		stats->durationMax = durationCounts;
+	}
+	stats->latenessSum += latenessCounts;
+	stats->durationSum += durationCounts;
+	stats->dispatches++;
+}
+
+SwtStats_t swtGetStats(uint8_t timerNo) {
+	swtStatsItem *stats = &_swtStats[timerNo];
+	SwtStats_t result = { 0, 0, 0, 0, 0, 0 };
+	if (0 != stats->dispatches) {
+		result.dispatches = stats->dispatches;
+		result.latenessMin = stats->latenessMin;
+		result.latenessMax = stats->latenessMax;
+		result.latenessMean = stats->latenessSum / stats->dispatches;
+		result.durationMax = stats->durationMax;
+		result.durationMean = stats->durationSum / stats->dispatches;
+	}
+	return result;
+}
+
+void swtResetStats(void) {
+	for (uint8_t i = 0; i < SWT_SIZE_OF; i++) {
+		_swtStats[i].dispatches = 0;
+		_swtStats[i].latenessMin = 0;
+		_swtStats[i].latenessMax = 0;
+		_swtStats[i].durationMax = 0;
+		_swtStats[i].latenessSum = 0;
+		_swtStats[i].durationSum = 0;
+	}
+}
+#endif
+
+void timer2SetPeriod(uint16_t miliseconds) {
+	// 32 bit multiplication only, 16 bit interval can't overflow the product
+	uint32_t cycles = fxMulU32Q16_16(miliseconds, SWT_CYCLES_PER_MILLISECOND);
 	uint8_t timer2PrescalerSelectBits = 0;
-	if (cycles < TCC2_TOP) {
+	_softPrescallerInit = 0;
+	if (cycles <= TCC2_PERIOD_MAX) {
 		// no prescaler, full XTAL
 		timer2PrescalerSelectBits = TCC2_PRSC_1;
-		} else if ((cycles >>= 3) < TCC2_TOP) {
+		} else if ((cycles >>= 3) <= TCC2_PERIOD_MAX) {
 		// prescaler by /8
 		timer2PrescalerSelectBits = TCC2_PRSC_8;
-		} else if ((cycles >>= 2) < TCC2_TOP) {
+		} else if ((cycles >>= 2) <= TCC2_PERIOD_MAX) {
 		// prescaler by /32
 		timer2PrescalerSelectBits = TCC2_PRSC_32;
-		} else if ((cycles >>= 1) < TCC2_TOP) {
+		} else if ((cycles >>= 1) <= TCC2_PERIOD_MAX) {
 		// prescaler by /64
 		timer2PrescalerSelectBits = TCC2_PRSC_64;
-		} else if ((cycles >>= 1) < TCC2_TOP) {
+		} else if ((cycles >>= 1) <= TCC2_PERIOD_MAX) {
 		// prescaler by /128
 		timer2PrescalerSelectBits = TCC2_PRSC_128;
-		} else if ((cycles >>= 1) < TCC2_TOP) {
+		} else if ((cycles >>= 1) <= TCC2_PERIOD_MAX) {
 		// prescaler by /256
 		timer2PrescalerSelectBits = TCC2_PRSC_256;
-		} else if ((cycles >>= 2) < TCC2_TOP) {
+		} else if ((cycles >> 2) <= TCC2_PERIOD_MAX) {
 		// prescaler by /1024
 		timer2PrescalerSelectBits = TCC2_PRSC_1024;
+		cycles >>= 2;
 		} else {
-		// use HW prescaler / 256 & soft prescaler to achieve 24 bit limit
+		// use HW prescaler / 256 & soft prescaler, the tick is split into equal compare periods
 		timer2PrescalerSelectBits = TCC2_PRSC_256;
-		cycles = (int64_t)(F_CPU);	
-		cycles *= miliseconds;
-		cycles /= 1000ULL;
-		cycles >>= 8;
-		_softPrescallerInit = (cycles >> 8) & 0xFFFF;
-		cycles &= 0xFF;
+		uint16_t periods = (cycles + TCC2_PERIOD_MAX - 1) / TCC2_PERIOD_MAX;
+		_softPrescallerInit = periods - 1;
+		cycles = (cycles + periods / 2) / periods;
 		}
-	OCR2 = cycles; // it should be already less than 0xFF
+	// in CTC mode the period is OCR2 + 1 counts
+	OCR2 = cycles > 0 ? cycles - 1 : 0;
 	TCCR2 |= timer2PrescalerSelectBits;
+#ifdef SWT_CLOCK
+	swtClockSetPrescaler(timer2PrescalerSelectBits);
+#endif
 	return;
 }
 
 ISR(TIMER2_COMP_vect) {
-	if (_softPrescallerCurrent == 0) {
-		for (int i = 0; i < SWT_SIZE_OF; i++) {
-			if (true == _timers[i].enabled && _timers[i].currentValue > 0) {
-				_timers[i].currentValue--;
-			}
-		}
+#ifdef SWT_CLOCK
+	swtClockAdvance(_swtSegment);
+#endif
+	if (true == _swtTickless) {
+		// segment is over, the head is updated and compare is set to the next expiry
+		swtQueueAdvance(_swtSegment);
+		swtSegmentProgram();
+	} else if (_softPrescallerCurrent == 0) {
+		// only the head of the delta queue is decremented, so tick takes the same time for any number of timers
+		swtQueueAdvance(1);
 		_softPrescallerCurrent = _softPrescallerInit;
 	} else {
 		_softPrescallerCurrent--;
@@ -31,6 +31,9 @@
 
 #include "common.h"
 
+#include <stdint.h>
+#include <stdbool.h>
+
 /// Definition of the software timer next step time value.
 typedef uint16_t SwtValueType;
 
@@ -56,6 +59,13 @@ internal routines.
 #define SWT_INTERVAL_1MS 1
 /// Another typical resolution interval.
 #define SWT_INTERVAL_10MS 10
+/**
+Tickless mode to be passed to #swtInit function. There is no periodic interrupt,
+Timer2 compare is programmed to the nearest expiry (or full counter period for longer delays),
+and no interrupts are generated when none of the timers is running.
+Resolution is one Timer2 count with prescaler /1024 (~93us for 11.0592MHz).
+*/
+#define SWT_INTERVAL_TICKLESS 0
 
 /// To be used as reference to software timer 0
 #define SWT_TIMER_0 0
@@ -82,8 +92,13 @@ internal routines.
 Initialization of the Software Timer routines with main .
 \b NOTE: Although even seconds are possible, for typical applications and 
 quartz values best option is to use 1ms.
+Running timers are kept in a queue sorted by expiry time, where each entry holds only
+the number of ticks after the previous one, so the tick interrupt decrements only the head
+of the queue and its duration doesn't depend on number of timers.
 Following definitions to be set in config.h file @n
-#define \b SWT_SIZE_OF \\ Number of available software timers. To be adjusted to the needs.@n
+#define \b SWT_SIZE_OF \\ Number of available software timers, lower than 255. To be adjusted to the needs.@n
+#define \b SWT_EXPIRED_SIZE_OF \\ Size of the ring passing expired timers from interrupt to #swtLoop, power of two.@n
+#define \b SWT_CLOCK \\ Enables #swtMicros and #swtMillis clock, which costs Timer2 interrupt also when idle.@n
 @code
 #include <stdbool.h>
 #include <stdint.h>
@@ -109,9 +124,11 @@ int main(void)
 		continue;
 	}
 @endcode
-@param milisecondsResolution Main interval of the software timers defined in miliseconds.
+@param milisecondsResolution Main interval of the software timers defined in miliseconds,
+or #SWT_INTERVAL_TICKLESS for tickless mode.
+@result false if Timer2 is reserved by other module, software timers don't run then.
 */
-void swtInit(int16_t milisecondsResolution);
+bool swtInit(int16_t milisecondsResolution);
 
 /**
 Stops the all Software Timers. Use #swtInit to start it again.
@@ -120,6 +137,7 @@ void swtDisable(void);
 
 /**
 To be periodically issued in the main loop.
+Only expired timers are visited, so the time doesn't depend on number of timers.
 */
 void swtLoop(void);
 
@@ -148,4 +166,60 @@ The value should be multiplication of the value used in the @swtInit function.
 */
 void swtStart(uint8_t timerNo, SwtValueType miliseconds);
 
+#ifdef SWT_CLOCK
+/**
+Returns number of microseconds since #swtInit, including counts of Timer2 since the last interrupt.
+Value wraps after 2^32 microseconds (~71 minutes), so differences should be calculated
+with unsigned subtraction, e.g. (uint32_t)(swtMicros() - start). Resolution is equal to single
+Timer2 count (~93us with prescaler /1024 in tickless mode for 11.0592MHz).
+\b NOTE: To keep the clock running, Timer2 interrupt is issued at least once per its full period,
+also in tickless mode when none of the timers is running (~23.7ms), so the clock is available
+only if SWT_CLOCK is defined in config.h.
+@result Microseconds since initialization.
+*/
+uint32_t swtMicros(void);
+
+/**
+Returns number of milliseconds since #swtInit. Value wraps after 2^32 milliseconds (~49 days),
+so differences should be calculated with unsigned subtraction.
+@result Milliseconds since initialization.
+*/
+uint32_t swtMillis(void);
+#endif
+
+#ifdef SWT_STATS
+/// Dispatch statistics of single software timer, all times in Timer2 counts.
+typedef struct {
+	/// Number of callbacks issued since the last reset.
+	uint16_t dispatches;
+	/// Shortest time between expiry and the callback.
+	uint16_t latenessMin;
+	/// Longest time between expiry and the callback.
+	uint16_t latenessMax;
+	/// Average time between expiry and the callback.
+	uint16_t latenessMean;
+	/// Longest execution time of the callback.
+	uint16_t durationMax;
+	/// Average execution time of the callback.
+	uint16_t durationMean;
+} SwtStats_t;
+
+/**
+Returns dispatch statistics of the software timer collected in #swtLoop since the last #swtResetStats.
+Lateness is counted from the expiry recorded in Timer2 interrupt until the callback is issued,
+so it shows how long the main loop was busy with other events. Times are in Timer2 counts
+(~93us with prescaler /1024 in tickless mode for 11.0592MHz) and saturate at 0xFFFF.
+Following definitions to be set in config.h file @n
+#define \b SWT_STATS \\ Enables the statistics, requires swtMicros clock (SWT_CLOCK defined).@n
+@param timerNo Number of the software timer.
+@result Statistics of the timer, all values are 0 if it was not dispatched.
+*/
+SwtStats_t swtGetStats(uint8_t timerNo);
+
+/**
+Clears dispatch statistics of all software timers.
+*/
+void swtResetStats(void);
+#endif
+
 #endif /* SOFTWARETIMER_H_ */
\ No newline at end of file
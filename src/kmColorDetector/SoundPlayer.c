@@ -24,6 +24,8 @@
 
 #include "SoundPlayer.h"
 #include "Serial.h"
+#include "SoftwareTimer.h"
+#include "Power.h"
 
 #define SNDPL_CMD_NEXT				0x01
 #define SNDPL_CMD_PREVIOUS			0x02
@@ -84,6 +86,26 @@
 #define SNDPL_FRAME_VERSION_CODE	0xFF
 #define SNDPL_FRAME_DEFAULT_LENGTH	0x06
 
+#define SNDPL_QUEUE_MASK (SNDPL_QUEUE_SIZE_OF - 1)
+
+_Static_assert((SNDPL_QUEUE_SIZE_OF & SNDPL_QUEUE_MASK) == 0 && SNDPL_QUEUE_SIZE_OF <= 128,
+		"SNDPL_QUEUE_SIZE_OF has to be power of two up to 128");
+
+// Internal definition of types.
+typedef struct {
+	uint8_t cmd;
+	uint16_t argument;
+} SndCommand_t;
+
+typedef enum {
+	// No command is in progress
+	SND_STATE_IDLE = 0,
+	// Command at the head of the queue is sent, next one waits for the interval
+	SND_STATE_PACING,
+	// Command at the head of the queue is sent and waits for the reply of the module
+	SND_STATE_ACK
+} SndState;
+
 static uint8_t _txFrame[SNDPL_FRAME_SIZE_OF] = {
 	  SNDPL_FRAME_START_CODE
 	, SNDPL_FRAME_VERSION_CODE
@@ -97,6 +119,15 @@ static uint8_t _rxFrame[SNDPL_FRAME_SIZE_OF];
 static uint8_t _rxFramePos = 0;
 static bool _ackRequestActive = false;
 
+// Commands waiting for transmission, command at the head is the one in progress
+static SndCommand_t _sndQueue[SNDPL_QUEUE_SIZE_OF];
+static uint8_t _sndQueueHead = 0;
+static uint8_t _sndQueueCount = 0;
+static SndState _sndState = SND_STATE_IDLE;
+static uint8_t _sndRetries = 0;
+static uint8_t _sndTimerNo = 0;
+static SndStats_t _sndStats;
+
 // Frame definition
 // 7E FF 06 0F 00 01 01 xx xx EF
 // 0	->	7E is start code
@@ -115,28 +146,109 @@ void sndFillArgument(uint16_t argument);
 void sndSendToSerial(void);
 void sndSendCmdWithArgument(uint8_t cmd, uint16_t argument);
 void sndSendCmd(uint8_t cmd);
+void sndSendHead(void);
+void sndRemoveHead(void);
+void sndFrameReceived(void);
+void callbackCommandTimer(void *userData, SwtValueType *newTimerValue);
 
 // Implementation
-void sndInit(void) {
+void sndInit(uint8_t timerNo) {
+	_sndTimerNo = timerNo;
+	_sndQueueHead = 0;
+	_sndQueueCount = 0;
+	_sndState = SND_STATE_IDLE;
+	_sndStats = (SndStats_t){0, 0, 0, 0};
+	swtRegisterCallback(_sndTimerNo, NULL, callbackCommandTimer);
 	serInit(PLYR_SERIAL_BAUD_RATE);
 }
 
 void sndLoop(void) {
-	if (serAvailable() > 0) {
+	while (serAvailable() > 0) {
 		uint8_t serialData = serRead();
+		// bytes before the start code are skipped, so the receiver synchronizes with the frames
+		if (0 == _rxFramePos && SNDPL_FRAME_START_CODE != serialData) {
+			continue;
+		}
 		_rxFrame[_rxFramePos++] = serialData;
-		if (SNDPL_FRAME_END_CODE == serialData) {
-			_rxFramePos = 0;
-			// TODO: call raw callback
-		} else if (SNDPL_FRAME_POS_END_CODE == _rxFramePos) {
+		if (SNDPL_FRAME_SIZE_OF == _rxFramePos) {
 			_rxFramePos = 0;
+			uint16_t checksum = sndCalcChecksum(_rxFrame);
+			if (SNDPL_FRAME_END_CODE == serialData
+					&& (checksum >> 0x08) == _rxFrame[SNDPL_FRAME_POS_CHECKSUM_HI]
+					&& (checksum & 0xFF) == _rxFrame[SNDPL_FRAME_POS_CHECKSUM_LO]) {
+				sndFrameReceived();
+			}
+		}
+	}
+}
+
+void sndFrameReceived(void) {
+	if (SND_STATE_ACK != _sndState) {
+		return;
+	}
+	if (SNDPL_CMD_REPLY == _rxFrame[SNDPL_FRAME_POS_COMMAND]) {
+		// command is acknowledged, next one is sent after the interval
+		_sndState = SND_STATE_PACING;
+		swtStart(_sndTimerNo, SNDPL_CMD_INTERVAL);
+	} else if (SNDPL_CMD_RESEND == _rxFrame[SNDPL_FRAME_POS_COMMAND]) {
+		// module is busy or the frame was corrupted, it's retried after the interval as on timeout
+		swtStart(_sndTimerNo, SNDPL_CMD_INTERVAL);
+	}
+}
+
+void callbackCommandTimer(void *userData, SwtValueType *newTimerValue) {
+	if (SND_STATE_ACK == _sndState) {
+		if (_sndRetries < SNDPL_MAX_RETRIES) {
+			// frame of the command at the head is still in the buffer
+			_sndRetries++;
+			_sndStats.retries++;
+			sndSendToSerial();
+			swtStart(_sndTimerNo, SNDPL_ACK_TIMEOUT);
+			return;
 		}
+		_sndStats.failed++;
 	}
+	sndRemoveHead();
 }
 
 void sndSetAckRequest(bool ackActive) {
+	// applies to commands sent from now on
 	_ackRequestActive = ackActive;
-	_txFrame[SNDPL_FRAME_POS_ACK] = ackActive == true ? 0x01 : 0x00;
+}
+
+SndStats_t sndGetStats(void) {
+	return _sndStats;
+}
+
+void sndSendHead(void) {
+	SndCommand_t *command = &_sndQueue[_sndQueueHead];
+	_txFrame[SNDPL_FRAME_POS_COMMAND] = command->cmd;
+	_txFrame[SNDPL_FRAME_POS_ACK] = true == _ackRequestActive ? 0x01 : 0x00;
+	sndFillArgument(command->argument);
+	sndFillChecksum();
+	// frame is sent from the buffer, it's not altered before the interval which is longer than transmission
+	sndSendToSerial();
+	_sndStats.sent++;
+	_sndRetries = 0;
+	if (true == _ackRequestActive) {
+		_sndState = SND_STATE_ACK;
+		swtStart(_sndTimerNo, SNDPL_ACK_TIMEOUT);
+	} else {
+		_sndState = SND_STATE_PACING;
+		swtStart(_sndTimerNo, SNDPL_CMD_INTERVAL);
+	}
+}
+
+void sndRemoveHead(void) {
+	_sndQueueHead = (_sndQueueHead + 1) & SNDPL_QUEUE_MASK;
+	_sndQueueCount--;
+	if (_sndQueueCount > 0) {
+		sndSendHead();
+	} else {
+		_sndState = SND_STATE_IDLE;
+		// software timers are stopped in power-down, so it's allowed only with empty queue
+		pwrAllowPowerDown(PWR_SOUND_PLAYER, true);
+	}
 }
 
 uint16_t sndCalcChecksum(const uint8_t *frame) {
@@ -169,10 +281,18 @@ void sndSendToSerial(void) {
 }
 
 void sndSendCmdWithArgument(uint8_t cmd, uint16_t argument) {
-	_txFrame[SNDPL_FRAME_POS_COMMAND] = cmd;
-	sndFillArgument(argument);
-	sndFillChecksum();
-	sndSendToSerial();
+	if (SNDPL_QUEUE_SIZE_OF == _sndQueueCount) {
+		_sndStats.dropped++;
+		return;
+	}
+	SndCommand_t *command = &_sndQueue[(_sndQueueHead + _sndQueueCount) & SNDPL_QUEUE_MASK];
+	command->cmd = cmd;
+	command->argument = argument;
+	_sndQueueCount++;
+	pwrAllowPowerDown(PWR_SOUND_PLAYER, false);
+	if (SND_STATE_IDLE == _sndState) {
+		sndSendHead();
+	}
 }
 
 void sndSendCmd(uint8_t cmd) {
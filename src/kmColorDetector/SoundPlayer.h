@@ -22,6 +22,12 @@
  *  You should have received a copy of the GNU General Public License
  *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
  *
+ *  Commands are queued and sent one by one, at least #SNDPL_CMD_INTERVAL apart, since the module
+ *  ignores commands coming during processing of the previous one. With ACK requests enabled
+ *  the next command waits for the reply (0x41) of the module, the command is sent again
+ *  if the reply doesn't come within #SNDPL_ACK_TIMEOUT or the module reports an error (0x40).
+ *  Commands issued when the queue is full are dropped, see #sndGetStats.
+ *
  *  References:
  * -# https://wiki.dfrobot.com/DFPlayer_Mini_SKU_DFR0299
  *
@@ -77,22 +83,47 @@
 /// Source device type Flash to be used in #sndSetDevice function.
 #define SNDPL_PLAYBACK_SRC_FLASH	0x04
 
+/// Statistics of the command queue.
+typedef struct {
+	/// Number of commands sent to the module, retries are not counted.
+	uint16_t sent;
+	/// Number of commands dropped since the queue was full.
+	uint16_t dropped;
+	/// Number of commands sent again after timeout or error reply.
+	uint16_t retries;
+	/// Number of commands not acknowledged after all retries.
+	uint16_t failed;
+} SndStats_t;
+
 /**
 Initialization of the module.
+Following definitions to be set in config.h file @n
+#define \b SNDPL_QUEUE_SIZE_OF 8 \\ Size of the queue of commands, power of two up to 128.@n
+#define \b SNDPL_CMD_INTERVAL 30 \\ Minimum time in ms between consecutive commands.@n
+#define \b SNDPL_ACK_TIMEOUT 100 \\ Time in ms to wait for the reply when ACK requests are enabled.@n
+#define \b SNDPL_MAX_RETRIES 2 \\ Number of retries of the command which isn't acknowledged.@n
+@param timerNo Software timer used for pacing of the commands and for the timeout of the reply.
 */
-void sndInit(void);
+void sndInit(uint8_t timerNo);
 
 /**
-To be periodically issued in the main loop.
+To be issued when bytes are received from the module, processes replies of the module.
 */
 void sndLoop(void);
 
 /**
-Enables or disables ACK requests after each command. Disabled by default
+Enables or disables ACK requests after each command. Disabled by default.
+Commands sent with ACK request wait for the reply and they are retried if it doesn't come.
 @param ackActive If true - the ACK requests are enabled.
 */
 void sndSetAckRequest(bool ackActive);
 
+/**
+Returns statistics of the command queue collected since #sndInit.
+@result Numbers of sent, dropped, retried and failed commands.
+*/
+SndStats_t sndGetStats(void);
+
 /**
 Sets and plays track for WAV files in XX directories, where XX is from 0 to 99
 @param trackNumber Number of track.
@@ -0,0 +1,129 @@
+/*
+ * Telemetry.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "common.h"
+
+#include <stdint.h>
+#include <util/crc16.h>
+
+#include "Telemetry.h"
+#include "SoftwareTimer.h"
+
+// Internal definition of types.
+// Layout of the measure record, structures are packed (-fpack-struct) and AVR is little endian
+typedef struct {
+	uint8_t type;
+	uint16_t sequence;
+	uint32_t timestamp;
+	RgbColor16_t raw;
+	RgbColor8_t norm;
+	uint8_t colorClass;
+	uint8_t flags;
+	uint16_t crc;
+} tlmMeasureRecord;
+
+_Static_assert(sizeof(tlmMeasureRecord) == 20, "measure record has to be packed");
+_Static_assert(sizeof(tlmMeasureRecord) <= TLM_RECORD_MAX_SIZE_OF, "measure record is too long");
+
+// "Private" global variables.
+static TlmMode _tlmMode = TLM_MODE_ASCII;
+static uint16_t _tlmSequence = 0;
+static FmtSink _tlmSink = FMT_SINK_SERIAL;
+
+// "Private" functions.
+void tlmSendRecord(uint8_t *record, uint8_t length);
+
+// Implementation
+void tlmInit(FmtSink sink) {
+	_tlmSink = sink;
+	_tlmMode = TLM_MODE_ASCII;
+	_tlmSequence = 0;
+}
+
+void tlmSetMode(TlmMode mode) {
+	if (TLM_MODE_BINARY == mode && TLM_MODE_BINARY != _tlmMode) {
+		// delimiter separates the first frame from ASCII text sent before
+		fmtChar(_tlmSink, 0);
+	}
+	_tlmMode = mode;
+}
+
+TlmMode tlmGetMode(void) {
+	return _tlmMode;
+}
+
+void tlmSendMeasure(RgbColor16_t raw, RgbColor8_t norm, uint8_t colorClass, uint8_t flags) {
+	tlmMeasureRecord record;
+	record.type = TLM_RECORD_MEASURE;
+	record.sequence = _tlmSequence++;
+#ifdef SWT_CLOCK
+	record.timestamp = swtMillis();
+#else
+	// not reached, config.h enables the clock with telemetry
+	record.timestamp = 0;
+#endif
+	record.raw = raw;
+	record.norm = norm;
+	record.colorClass = colorClass;
+	record.flags = flags;
+	tlmSendRecord((uint8_t *)&record, sizeof(record));
+}
+
+uint8_t tlmCobsEncode(const uint8_t *src, uint8_t length, uint8_t *dst) {
+	// records are shorter than 254 bytes, so every block ends with zero or the end of data
+	uint8_t *code = dst++;
+	uint8_t encoded = 1;
+	uint8_t distance = 1;
+	while (length-- > 0) {
+		uint8_t c = *src++;
+		if (0 == c) {
+			*code = distance;
+			code = dst++;
+			distance = 1;
+		} else {
+			*dst++ = c;
+			distance++;
+		}
+		encoded++;
+	}
+	*code = distance;
+	return encoded;
+}
+
+uint8_t tlmEncodeFrame(uint8_t *record, uint8_t length, uint8_t *frame) {
+	uint16_t crc = 0xFFFF;
+	for (uint8_t i = 0; i < length - 2; i++) {
+		crc = _crc_ccitt_update(crc, record[i]);
+	}
+	record[length - 2] = (uint8_t)crc;
+	record[length - 1] = (uint8_t)(crc >> 8);
+	uint8_t encoded = tlmCobsEncode(record, length, frame);
+	frame[encoded++] = 0;
+	return encoded;
+}
+
+void tlmSendRecord(uint8_t *record, uint8_t length) {
+	uint8_t frame[TLM_FRAME_SIZE_OF(TLM_RECORD_MAX_SIZE_OF)];
+	fmtBinary(_tlmSink, frame, tlmEncodeFrame(record, length, frame));
+}
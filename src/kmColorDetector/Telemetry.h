@@ -0,0 +1,127 @@
+/** @file
+ * @brief Binary telemetry of measures sent over serial interface.
+ * Telemetry.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Each record is followed by CRC-16 (_crc_ccitt_update, initial value 0xFFFF, little endian)
+ *  and encoded with COBS, so the frame doesn't contain any zero byte and it's terminated by 0x00.
+ *  All fields are little endian. Measure record (#TLM_RECORD_MEASURE):
+ *  | Offset | Size | Field |
+ *  |--------|------|-------|
+ *  | 0      | 1    | record type |
+ *  | 1      | 2    | sequence number |
+ *  | 3      | 4    | timestamp in ms (swtMillis) |
+ *  | 7      | 6    | raw color R, G, B from the sensor |
+ *  | 13     | 3    | normalized color R, G, B |
+ *  | 16     | 1    | color class |
+ *  | 17     | 1    | flags (TLM_FLAG_*) |
+ *
+ *  Host decoder: src/tools/kmcdTelemetry.py
+ *
+ *  References:
+ * -# https://en.wikipedia.org/wiki/Consistent_Overhead_Byte_Stuffing
+ * -# https://www.nongnu.org/avr-libc/user-manual/group__util__crc.html
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include "common.h"
+
+#include <stdint.h>
+
+#include "ColorTools.h"
+#include "Format.h"
+
+/// Type of the record carrying single measure
+#define TLM_RECORD_MEASURE 0x01
+/// Type of the record carrying trace message, see Trace.h
+#define TLM_RECORD_TRACE 0x02
+
+/// Maximum size of the record including CRC
+#define TLM_RECORD_MAX_SIZE_OF 32
+/// Size of the frame for record of given size, one byte of COBS overhead and the delimiter
+#define TLM_FRAME_SIZE_OF(RECORD_SIZE_OF) ((RECORD_SIZE_OF) + 2)
+
+/// Color doesn't match any of known colors closely enough, class is the nearest one
+#define TLM_FLAG_UNKNOWN 0x01
+/// Measure is a sample of the trained class
+#define TLM_FLAG_TRAINING 0x02
+/// Normalized color and class are smoothed
+#define TLM_FLAG_SMOOTHED 0x04
+
+/// Format of the measures sent over serial interface.
+typedef enum {
+	/// Human readable lines, see #dbMeasureToSerial
+	TLM_MODE_ASCII = 0,
+	/// COBS framed binary records
+	TLM_MODE_BINARY = 1
+} TlmMode;
+
+/**
+Initializes telemetry in ASCII mode and resets the sequence number.
+@param sink Serial interface the frames are sent to, #FMT_SINK_SERIAL or #FMT_SINK_SOFT_SERIAL.
+*/
+void tlmInit(FmtSink sink);
+
+/**
+Selects format of the measures sent over serial interface.
+Switching to binary mode sends frame delimiter, so the first frame is not merged with preceding text.
+@param mode New format.
+*/
+void tlmSetMode(TlmMode mode);
+
+/**
+Returns format of the measures sent over serial interface.
+@result Current format.
+*/
+TlmMode tlmGetMode(void);
+
+/**
+Sends measure record frame over serial interface, regardless of the selected mode.
+@param raw Color as measured by the sensor.
+@param norm Normalized color.
+@param colorClass Class of the color.
+@param flags Combination of TLM_FLAG_* values.
+*/
+void tlmSendMeasure(RgbColor16_t raw, RgbColor8_t norm, uint8_t colorClass, uint8_t flags);
+
+/**
+Builds frame from the record: stores CRC in the last two bytes of the record,
+encodes it with COBS and adds terminating zero.
+@param record Record with two bytes reserved for CRC at the end, up to #TLM_RECORD_MAX_SIZE_OF bytes.
+@param length Number of bytes of the record including CRC.
+@param frame Buffer of #TLM_FRAME_SIZE_OF(length) bytes for the frame.
+@result Number of bytes of the frame.
+*/
+uint8_t tlmEncodeFrame(uint8_t *record, uint8_t length, uint8_t *frame);
+
+/**
+Encodes data with COBS, so the result doesn't contain zero bytes. Terminating zero is not added.
+@param src Data to be encoded, up to 253 bytes.
+@param length Number of bytes of data.
+@param dst Buffer for encoded data, at least length + 1 bytes.
+@result Number of bytes of encoded data.
+*/
+uint8_t tlmCobsEncode(const uint8_t *src, uint8_t length, uint8_t *dst);
+
+#endif /* TELEMETRY_H_ */
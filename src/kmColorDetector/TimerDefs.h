@@ -258,4 +258,7 @@
 /// Timers bottom value
 #define TCC_BOTOM		0x00
 
+/// Compile time assertion, e.g. for the period of the timer given as constant
+#define TCC_STATIC_ASSERT(CONDITION, MESSAGE) _Static_assert(CONDITION, MESSAGE)
+
 #endif /* TIMERDEFS_H_ */
\ No newline at end of file
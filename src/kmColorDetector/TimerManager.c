@@ -0,0 +1,97 @@
+/*
+ * TimerManager.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#include "TimerManager.h"
+
+// "Private" global variables.
+// Each bit is one user of the timer
+static uint8_t _tmrUsers[TMR_SIZE_OF];
+// Each bit is one timer reserved exclusively
+static uint8_t _tmrExclusive = 0;
+static const uint8_t _tmrInterruptBits[TMR_SIZE_OF] = {
+	TMR_TIMSK_TIMER_0,
+	TMR_TIMSK_TIMER_1,
+	TMR_TIMSK_TIMER_2
+};
+
+// Implementation
+void tmrInit(void) {
+	for (uint8_t i = 0; i < TMR_SIZE_OF; i++) {
+		_tmrUsers[i] = 0;
+	}
+	_tmrExclusive = 0;
+}
+
+bool tmrReserve(TmrTimer timer, TmrUser user, TmrMode mode) {
+	uint8_t others = _tmrUsers[timer] & ~_BV(user);
+	if (TMR_MODE_EXCLUSIVE == mode) {
+		if (0 != others) {
+			return false;
+		}
+		_tmrExclusive |= _BV(timer);
+	} else {
+		if (0 != others && 0 != (_tmrExclusive & _BV(timer))) {
+			return false;
+		}
+		_tmrExclusive &= ~_BV(timer);
+	}
+	_tmrUsers[timer] |= _BV(user);
+	return true;
+}
+
+void tmrRelease(TmrTimer timer, TmrUser user) {
+	_tmrUsers[timer] &= ~_BV(user);
+	if (0 == _tmrUsers[timer]) {
+		_tmrExclusive &= ~_BV(timer);
+		tmrDisableInterrupts(_tmrInterruptBits[timer]);
+	}
+}
+
+bool tmrIsShared(TmrTimer timer) {
+	uint8_t users = _tmrUsers[timer];
+	// more than one bit set
+	return 0 != (users & (users - 1));
+}
+
+void tmrEnableInterrupts(uint8_t mask) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		TIMSK |= mask;
+	}
+}
+
+void tmrDisableInterrupts(uint8_t mask) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		TIMSK &= ~mask;
+	}
+}
+
+void tmrClearFlags(uint8_t mask) {
+	TIFR = mask;
+}
@@ -0,0 +1,139 @@
+/** @file
+ * @brief Allocation of hardware timers Timer0, Timer1 and Timer2 between modules.
+ * TimerManager.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Timer can be reserved exclusively, so the user may change any of its settings,
+ *  or in shared mode, where the users keep the prescaler and period set by the first
+ *  one and use only their own compare outputs and interrupts, e.g. the PWM on OC1A
+ *  running on the same period as color sensor gate on Timer1 overflow.
+ *  Interrupt enable bits of all timers are in single TIMSK register, so they
+ *  are changed only with #tmrEnableInterrupts and #tmrDisableInterrupts
+ *  to never disable interrupts of another user.
+ */
+
+#ifndef TIMERMANAGER_H_
+#define TIMERMANAGER_H_
+
+#include "common.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+
+/// All interrupt enable bits of Timer0 in TIMSK register
+#define TMR_TIMSK_TIMER_0 (_BV(OCIE0) | _BV(TOIE0))
+/// All interrupt enable bits of Timer1 in TIMSK register
+#define TMR_TIMSK_TIMER_1 (_BV(TICIE1) | _BV(OCIE1A) | _BV(OCIE1B) | _BV(TOIE1))
+/// All interrupt enable bits of Timer2 in TIMSK register
+#define TMR_TIMSK_TIMER_2 (_BV(OCIE2) | _BV(TOIE2))
+
+/// Hardware timers available for allocation.
+typedef enum {
+	/// 8 bit Timer0.
+	TMR_TIMER_0 = 0,
+	/// 16 bit Timer1.
+	TMR_TIMER_1 = 1,
+	/// 8 bit Timer2, the only one which can run asynchronously.
+	TMR_TIMER_2 = 2
+} TmrTimer;
+
+/// Number of the hardware timers.
+#define TMR_SIZE_OF 3
+
+/// Users of the hardware timers, each one is represented by single bit.
+typedef enum {
+	/// Color sensor gate time.
+	TMR_USER_SENSOR = 0,
+	/// Software timers and swtMillis clock.
+	TMR_USER_SCHEDULER = 1,
+	/// PWM outputs driving actuators.
+	TMR_USER_PWM = 2,
+	/// Application specific use.
+	TMR_USER_APPLICATION = 3,
+	/// One-shot timers on compare channels.
+	TMR_USER_ONE_SHOT = 4,
+	/// Software UART transmitter, see SoftSerial.h.
+	TMR_USER_SOFT_SERIAL = 5
+} TmrUser;
+
+/// Reservation modes of the hardware timer.
+typedef enum {
+	/// The only user of the timer, no other reservation is accepted.
+	TMR_MODE_EXCLUSIVE,
+	/// Timer is shared with other users, its prescaler and period can't be changed.
+	TMR_MODE_SHARED
+} TmrMode;
+
+/**
+Initialization of the timer manager, all timers are released.
+*/
+void tmrInit(void);
+
+/**
+Reserves the timer for the user. Reserving again by the same user changes the mode,
+as long as it's allowed by other reservations.
+@param timer Timer to be reserved.
+@param user User reserving the timer.
+@param mode #TMR_MODE_EXCLUSIVE succeeds only if no other user reserved the timer,
+#TMR_MODE_SHARED succeeds if the timer is not reserved exclusively by another user.
+@result true if the timer has been reserved, false if it's used by other user in conflicting mode.
+*/
+bool tmrReserve(TmrTimer timer, TmrUser user, TmrMode mode);
+
+/**
+Releases the timer reserved with #tmrReserve. Once the last user releases it,
+all interrupts of the timer are disabled.
+@param timer Timer to be released.
+@param user User releasing the timer.
+*/
+void tmrRelease(TmrTimer timer, TmrUser user);
+
+/**
+Checks if the timer is currently used by more than one user.
+@param timer Timer to be checked.
+@result true if other users would be affected by stopping the timer or changing its period.
+*/
+bool tmrIsShared(TmrTimer timer);
+
+/**
+Enables timer interrupts by atomic read-modify-write of TIMSK register,
+so interrupts of other timers are left intact. Can be called from interrupts.
+@param mask Interrupt enable bits, e.g. _BV(OCIE2).
+*/
+void tmrEnableInterrupts(uint8_t mask);
+
+/**
+Disables timer interrupts by atomic read-modify-write of TIMSK register,
+so interrupts of other timers are left intact. Can be called from interrupts.
+@param mask Interrupt enable bits, e.g. _BV(TOIE1).
+*/
+void tmrDisableInterrupts(uint8_t mask);
+
+/**
+Clears pending interrupt flags of timers. Flags are cleared by writing one,
+so the register is written directly, read-modify-write would clear all pending flags.
+@param mask Interrupt flags to be cleared, e.g. _BV(OCF2).
+*/
+void tmrClearFlags(uint8_t mask);
+
+#endif /* TIMERMANAGER_H_ */
@@ -24,18 +24,30 @@
  */
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <avr/interrupt.h>
 #include <util/atomic.h>
 
 #include "TimerOne.h"
+#include "TimerManager.h"
+#include "FixedPoint.h"
 #include "Debug.h"
 
-#define TCC1_TOP TCC_TOP_3
+/// Timer1 counts without prescaler per microsecond in Q16.16 format, rounded up so exact periods are not shortened
+#define TIMER1_CYCLES_PER_MICROSECOND ((uint32_t)(((uint64_t)(F_CPU) * 65536ULL + 1999999ULL) / 2000000ULL))
 
 static uint8_t _timer1PrescalerSelectBits = 0;
 static uint16_t _timer1PwmCycles = 0;
 static Timer1Callback *_timerCallback = NULL;
 static void *_timer1CallbackUserData = NULL;
+// Timer1 runs in CTC mode, periods are counted in input capture interrupt
+static bool _timer1Timebase = false;
+// Callback is enabled in time base mode, where the interrupt is always enabled
+static volatile bool _timer1CallbackEnabled = false;
+static volatile uint16_t _timer1Periods = 0;
+
+// "Private" functions.
+void timer1ReleasePwm(void);
 
 void timer1Start(void) {
 	TCCR1B |= _timer1PrescalerSelectBits;
@@ -51,9 +63,17 @@ void timer1Restart(void) {
 
 void timer1SetPeriod(int32_t microseconds) {
 	// the counter runs backwards after TOP, interrupt is at BOTTOM so divide microseconds by 2
-	int64_t cycles = (int64_t)(F_CPU);
-	cycles *= microseconds;
-	cycles /= 2000000ULL;
+	uint32_t cycles = 0;
+	if (microseconds > TIMER1_MAX_MICROSECONDS) {
+		// out of bounds, also protects the multiplication below against overflow
+		cycles = UINT32_MAX;
+	} else if (microseconds > 0) {
+		cycles = fxMulU32Q16_16((uint32_t)microseconds, TIMER1_CYCLES_PER_MICROSECOND);
+		if (true == _timer1Timebase) {
+			// counter runs only up in CTC mode
+			cycles <<= 1;
+		}
+	}
 	if (cycles < TCC_TOP_3) {
 		// no prescaler, full xtal
 		_timer1PrescalerSelectBits = TCC1_PRSC_1;
@@ -74,22 +94,107 @@ void timer1SetPeriod(int32_t microseconds) {
 		_timer1PrescalerSelectBits = TCC1_PRSC_1024;
 		cycles = TCC1_TOP;
 	}
-	_timer1PwmCycles = cycles;
+	if (true == _timer1Timebase && cycles > 0) {
+		// period is top + 1 counts in CTC mode
+		cycles--;
+	}
+	timer1SetPeriodCycles(_timer1PrescalerSelectBits, (uint16_t)cycles);
+}
+
+void timer1SetPeriodCycles(uint8_t prescalerBits, uint16_t top) {
+	_timer1PrescalerSelectBits = prescalerBits;
+	_timer1PwmCycles = top;
 	ICR1 = _timer1PwmCycles;
 	 // reset prescaler bits
 	timer1Stop();
 }
 
+void timer1SetTop(uint16_t top) {
+	// 16 bit register is written through shared TEMP register, so it has to be atomic
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		_timer1PwmCycles = top;
+		ICR1 = top;
+	}
+}
+
 void timer1Init(int32_t microseconds) {
 	// clear control register A
 	// Set Timer1 mode 8 - PWM, Phase and Frequency Correct with ICR1 as top
 	TCCR1A = TCC_1_MODE_8_A;
 	TCCR1B = TCC_1_MODE_8_B;
+	_timer1Timebase = false;
 	timer1SetPeriod(microseconds);
 }
 
+void timer1InitCycles(uint8_t prescalerBits, uint16_t top) {
+	// Set Timer1 mode 8 - PWM, Phase and Frequency Correct with ICR1 as top
+	TCCR1A = TCC_1_MODE_8_A;
+	TCCR1B = TCC_1_MODE_8_B;
+	_timer1Timebase = false;
+	timer1SetPeriodCycles(prescalerBits, top);
+}
+
+void timer1InitTimebaseCycles(uint8_t prescalerBits, uint16_t top) {
+	// Set Timer1 mode 12 - CTC with ICR1 as top, compare registers are not buffered
+	TCCR1A = TCC_1_MODE_C_A;
+	TCCR1B = TCC_1_MODE_C_B;
+	_timer1Timebase = true;
+	_timer1CallbackEnabled = false;
+	timer1SetPeriodCycles(prescalerBits, top);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		TCNT1 = 0;
+		_timer1Periods = 0;
+	}
+	tmrClearFlags(_BV(ICF1));
+	tmrEnableInterrupts(_BV(TICIE1));
+}
+
+bool timer1IsTimebase(void) {
+	return _timer1Timebase;
+}
+
+Timer1Time_t timer1GetTime(void) {
+	Timer1Time_t result;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		result.count = TCNT1;
+		result.period = _timer1Periods;
+		if (TIFR & _BV(ICF1)) {
+			// top was reached, but interrupt is not yet served,
+			// counter is read again, since it could be cleared after the first read
+			result.count = TCNT1;
+			result.period++;
+		}
+	}
+	return result;
+}
+
+uint16_t timer1GetTop(void) {
+	return _timer1PwmCycles;
+}
+
+uint16_t timer1GetPrescaler(void) {
+	switch (_timer1PrescalerSelectBits) {
+		case TCC1_PRSC_1 : {
+			return 1;
+		}
+		case TCC1_PRSC_8 : {
+			return 8;
+		}
+		case TCC1_PRSC_64 : {
+			return 64;
+		}
+		case TCC1_PRSC_256 : {
+			return 256;
+		}
+		default : {
+			return 1024;
+		}
+	}
+}
+
 void timer1SetPwmDuty(Tcc1PwmOut pwmOut, uint16_t duty) {
-	uint32_t dutyCycle = _timer1PwmCycles * duty;
+	// 16 bit factors, 32 bit product
+	uint32_t dutyCycle = fxMulU16(_timer1PwmCycles, duty);
 	dutyCycle >>= 10;
 	switch (pwmOut) {
 		case TCC1_PWM_OUT_A: {
@@ -104,8 +209,17 @@ void timer1SetPwmDuty(Tcc1PwmOut pwmOut, uint16_t duty) {
 	}
 }
 
-void timer1EnablePwm(Tcc1PwmOut pwmOut, uint16_t duty, int32_t microseconds) {
+bool timer1EnablePwm(Tcc1PwmOut pwmOut, uint16_t duty, int32_t microseconds) {
+	// compare registers are not buffered in time base mode, so PWM needs Timer1 in PWM mode
+	if (true == _timer1Timebase || false == tmrReserve(TMR_TIMER_1, TMR_USER_PWM, TMR_MODE_SHARED)) {
+		return false;
+	}
 	if (microseconds > 0) {
+		if (true == tmrIsShared(TMR_TIMER_1)) {
+			// period of shared timer belongs to the other users
+			timer1ReleasePwm();
+			return false;
+		}
 		timer1SetPeriod(microseconds);
 	}
 	switch (pwmOut) {
@@ -127,6 +241,7 @@ void timer1EnablePwm(Tcc1PwmOut pwmOut, uint16_t duty, int32_t microseconds) {
 	}
 	timer1SetPwmDuty(pwmOut, duty);
 	timer1Start();
+	return true;
 }
 
 void timer1DisablePwm(Tcc1PwmOut pwmOut) {
@@ -143,15 +258,31 @@ void timer1DisablePwm(Tcc1PwmOut pwmOut) {
 		}
 	// no default
 	}
+	timer1ReleasePwm();
+}
+
+void timer1ReleasePwm(void) {
+	// Timer1 is released once none of the outputs is driven
+	if (0 == (TCCR1A & (_BV(COM1A1) | _BV(COM1B1)))) {
+		tmrRelease(TMR_TIMER_1, TMR_USER_PWM);
+	}
 }
 
 void timer1EnableInterrupt(void) {
-	TIMSK |= _BV(TOIE1);
+	if (true == _timer1Timebase) {
+		_timer1CallbackEnabled = true;
+	} else {
+		tmrEnableInterrupts(_BV(TOIE1));
+	}
 	timer1Start();
 }
 
 void timer1DisableInterrupt(void) {
-	TIMSK &= ~_BV(TOIE1);
+	if (true == _timer1Timebase) {
+		_timer1CallbackEnabled = false;
+	} else {
+		tmrDisableInterrupts(_BV(TOIE1));
+	}
 }
 
 void timer1RegisterCallback(Timer1Callback *callback, void *userData) {
@@ -169,4 +300,11 @@ ISR(TIMER1_OVF_vect) {
 	if (_timerCallback != NULL) {
 		_timerCallback(_timer1CallbackUserData);
 	}
-}
\ No newline at end of file
+}
+
+ISR(TIMER1_CAPT_vect) {
+	_timer1Periods++;
+	if (true == _timer1CallbackEnabled && _timerCallback != NULL) {
+		_timerCallback(_timer1CallbackUserData);
+	}
+}
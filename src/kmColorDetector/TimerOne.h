@@ -33,6 +33,8 @@
 
 #include "common.h"
 
+#include <stdbool.h>
+
 #include "TimerDefs.h"
 
 /// User data remapping macro for callback registration
@@ -41,6 +43,73 @@
 /// Default value of the timer1 interval in microseconds.
 #define TIMER1_DEFAULT_MICROSEDONDS 1000000 // 1s
 
+/// Top value of Timer1 in PWM, Phase and Frequency Correct mode with ICR1 as top
+#define TCC1_TOP TCC_TOP_3
+/// Timer1 counts without prescaler for the period in microseconds,
+/// the counter runs up and down, so it's a half of the period
+#define TIMER1_CYCLES(US) ((uint64_t)(F_CPU) * (US) / 2000000ULL)
+/// Prescaler of Timer1 for number of counts without prescaler, the lowest one keeping counts below #TCC1_TOP
+#define TIMER1_PRESCALER_OF(CYCLES) ( \
+	(CYCLES) < TCC1_TOP ? 1 : \
+	((CYCLES) >> 3) < TCC1_TOP ? 8 : \
+	((CYCLES) >> 6) < TCC1_TOP ? 64 : \
+	((CYCLES) >> 8) < TCC1_TOP ? 256 : 1024)
+/// Clock select bits of Timer1 for number of counts without prescaler
+#define TIMER1_PRESCALER_BITS_OF(CYCLES) ( \
+	1 == TIMER1_PRESCALER_OF(CYCLES) ? (TCC1_PRSC_1) : \
+	8 == TIMER1_PRESCALER_OF(CYCLES) ? (TCC1_PRSC_8) : \
+	64 == TIMER1_PRESCALER_OF(CYCLES) ? (TCC1_PRSC_64) : \
+	256 == TIMER1_PRESCALER_OF(CYCLES) ? (TCC1_PRSC_256) : (TCC1_PRSC_1024))
+/// Prescaler of Timer1 for the period in microseconds
+#define TIMER1_PRESCALER(US) TIMER1_PRESCALER_OF(TIMER1_CYCLES(US))
+/// Clock select bits of Timer1 for the period in microseconds
+#define TIMER1_PRESCALER_BITS(US) TIMER1_PRESCALER_BITS_OF(TIMER1_CYCLES(US))
+/// Value of ICR1 for the period in microseconds
+#define TIMER1_TOP(US) ((uint16_t)(TIMER1_CYCLES(US) / TIMER1_PRESCALER(US)))
+/// Non zero if the period in microseconds can be represented by Timer1
+#define TIMER1_PERIOD_VALID(US) ((US) > 0 && (TIMER1_CYCLES(US) >> 10) < TCC1_TOP)
+
+/// Timer1 counts without prescaler for the period in microseconds in time base (CTC) mode
+#define TIMER1_TIMEBASE_CYCLES(US) ((uint64_t)(F_CPU) * (US) / 1000000ULL)
+/// Value of ICR1 for the period in microseconds in time base mode, the period is ICR1 + 1 counts
+#define TIMER1_TIMEBASE_TOP(US) ((uint16_t)(TIMER1_TIMEBASE_CYCLES(US) / TIMER1_PRESCALER_OF(TIMER1_TIMEBASE_CYCLES(US)) - 1))
+/// Non zero if the period in microseconds can be represented by Timer1 in time base mode
+#define TIMER1_TIMEBASE_PERIOD_VALID(US) ((US) > 0 && (TIMER1_TIMEBASE_CYCLES(US) >> 10) < TCC1_TOP)
+/// The longest period in microseconds, longer ones are clipped by #timer1SetPeriod
+#define TIMER1_MAX_MICROSECONDS ((int32_t)((uint64_t)(TCC1_TOP) * 1024ULL * 2000000ULL / (F_CPU)))
+
+/**
+Initializes timer with constant period in microseconds, prescaler and ICR1 are calculated
+at compile time, and compilation fails if the period can't be represented by Timer1.
+@param US Constant number of microseconds between timer intervals.
+*/
+#define TIMER1_INIT(US) do { \
+	TCC_STATIC_ASSERT(TIMER1_PERIOD_VALID(US), "Timer1 period out of range"); \
+	timer1InitCycles(TIMER1_PRESCALER_BITS(US), TIMER1_TOP(US)); \
+} while (0)
+
+/**
+Initializes timer as a time base with constant period in microseconds. Timer1 runs in CTC mode
+with ICR1 as top, so compare registers OCR1A and OCR1B are not buffered and can be used
+for one-shot timers, but PWM outputs are not available. Callback registered with
+#timer1RegisterCallback is issued at the end of each period.
+@param US Constant number of microseconds between timer intervals.
+*/
+#define TIMER1_INIT_TIMEBASE(US) do { \
+	TCC_STATIC_ASSERT(TIMER1_TIMEBASE_PERIOD_VALID(US), "Timer1 period out of range"); \
+	timer1InitTimebaseCycles(TIMER1_PRESCALER_BITS_OF(TIMER1_TIMEBASE_CYCLES(US)), TIMER1_TIMEBASE_TOP(US)); \
+} while (0)
+
+/**
+Defines constant period of the timer in microseconds, prescaler and ICR1 are calculated
+at compile time, and compilation fails if the period can't be represented by Timer1.
+@param US Constant number of microseconds between timer intervals.
+*/
+#define TIMER1_SET_PERIOD(US) do { \
+	TCC_STATIC_ASSERT(TIMER1_PERIOD_VALID(US), "Timer1 period out of range"); \
+	timer1SetPeriodCycles(TIMER1_PRESCALER_BITS(US), TIMER1_TOP(US)); \
+} while (0)
+
 /**
 Definition of the Timer1 Callback
 @param Pointer for void content that is registered in #timer1RegisterCallback function
@@ -58,6 +127,14 @@ typedef enum {
 	TCC1_PWM_OUT_B
 } Tcc1PwmOut;
 
+/// Time of Timer1 running as time base, see #timer1InitTimebaseCycles.
+typedef struct {
+	/// Number of periods since initialization, wraps after 2^16.
+	uint16_t period;
+	/// Counts of Timer1 in the current period, from 0 to ICR1.
+	uint16_t count;
+} Timer1Time_t;
+
 /**
 Initializes timer with specific number of microseconds.
 \b NOTE: This timer does not start automatically after initialization.
@@ -66,6 +143,51 @@ To start it use #timer1Start function.
 */
 void timer1Init(int32_t microseconds);
 
+/**
+Initializes timer with prescaler and top value, e.g. calculated by #TIMER1_INIT macro.
+\b NOTE: This timer does not start automatically after initialization.
+To start it use #timer1Start function.
+@param prescalerBits Clock select bits, one of TCC1_PRSC_* values.
+@param top Value of ICR1, half of the period in prescaled counts.
+*/
+void timer1InitCycles(uint8_t prescalerBits, uint16_t top);
+
+/**
+Initializes timer as a time base with prescaler and top value, e.g. calculated by #TIMER1_INIT_TIMEBASE macro.
+Timer1 runs in CTC mode with ICR1 as top and counts its periods in input capture interrupt,
+which stays enabled also when the callback is disabled with #timer1DisableInterrupt.
+\b NOTE: This timer does not start automatically after initialization.
+To start it use #timer1Start function.
+@param prescalerBits Clock select bits, one of TCC1_PRSC_* values.
+@param top Value of ICR1, the period is top + 1 prescaled counts.
+*/
+void timer1InitTimebaseCycles(uint8_t prescalerBits, uint16_t top);
+
+/**
+Checks if timer was initialized as a time base.
+@result true if Timer1 runs in CTC mode initialized with #timer1InitTimebaseCycles.
+*/
+bool timer1IsTimebase(void);
+
+/**
+Returns current time of Timer1 initialized as a time base, including the period
+which ended just now but its interrupt is not yet served.
+@result Number of periods and counts in the current period.
+*/
+Timer1Time_t timer1GetTime(void);
+
+/**
+Returns current top value of the timer.
+@result Value of ICR1.
+*/
+uint16_t timer1GetTop(void);
+
+/**
+Returns current prescaler of the timer selected by the last period setting.
+@result Prescaler value 1, 8, 64, 256 or 1024.
+*/
+uint16_t timer1GetPrescaler(void);
+
 /**
 Enables and starts timer. Can be disabled by #timer1Stop function.
 */
@@ -82,12 +204,27 @@ Restarts the timer by setting it's current value to 0.
 void timer1Restart(void);
 
 /**
-Defines main period of the timer in microseconds.
+Defines main period of the timer in microseconds, also in time base mode.
 The internal routines use F_CPU variable for calculations.
 @param microseconds Number of microseconds between timer intervals.
 */
 void timer1SetPeriod(int32_t microseconds);
 
+/**
+Defines main period of the timer with prescaler and top value, e.g. calculated by #TIMER1_SET_PERIOD macro.
+Same as #timer1SetPeriod the timer is stopped and needs to be started with #timer1Start.
+@param prescalerBits Clock select bits, one of TCC1_PRSC_* values.
+@param top Value of ICR1, half of the period in prescaled counts.
+*/
+void timer1SetPeriodCycles(uint8_t prescalerBits, uint16_t top);
+
+/**
+Changes only the top value of the running timer keeping its prescaler, so it's short
+enough to be called from interrupt, e.g. to change the gate length per channel.
+@param top Value of ICR1, e.g. #TIMER1_TOP for the period with the same #TIMER1_PRESCALER.
+*/
+void timer1SetTop(uint16_t top);
+
 
 /**
 Sets PWM duty of specific PWM output to duty value.
@@ -98,14 +235,17 @@ void timer1SetPwmDuty(Tcc1PwmOut pwmOut, uint16_t duty);
 
 /**
 Enables PWM on specific PWM output, and sets duty value.
+Timer1 is reserved for #TMR_USER_PWM in #TMR_MODE_SHARED mode until both outputs are disabled.
 @param pwmOut Either TCC1_PWM_OUT_A or TCC1_PWM_OUT_B.
 @param duty Duty value in range of 0 to 1024 (full duty); 512 is for 50%/50%
-@param microseconds Number of microseconds of the full PWM cycle.
+@param microseconds Number of microseconds of the full PWM cycle, 0 keeps the current period,
+which is required when Timer1 is shared with other users.
+@result false if Timer1 is reserved exclusively, runs in time base mode or the period can't be changed.
 */
-void timer1EnablePwm(Tcc1PwmOut pwmOut, uint16_t duty, int32_t microseconds);
+bool timer1EnablePwm(Tcc1PwmOut pwmOut, uint16_t duty, int32_t microseconds);
 
 /**
-Disables PWM on specific PWM output.
+Disables PWM on specific PWM output. Timer1 is released once both outputs are disabled.
 @param pwmOut Either TCC1_PWM_OUT_A or TCC1_PWM_OUT_B.
 */
 void timer1DisablePwm(Tcc1PwmOut pwmOut);
@@ -0,0 +1,165 @@
+/*
+ * Trace.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <util/atomic.h>
+
+#include "Trace.h"
+#include "Telemetry.h"
+#include "Serial.h"
+#include "Events.h"
+#include "SoftwareTimer.h"
+
+#if (TRC_BUFFER_SIZE & (TRC_BUFFER_SIZE - 1)) != 0 || TRC_BUFFER_SIZE > 128
+#error "TRC_BUFFER_SIZE has to be power of two up to 128"
+#endif
+#define TRC_BUFFER_MASK (TRC_BUFFER_SIZE - 1)
+
+/// Record with all arguments and CRC
+#define TRC_RECORD_MAX_SIZE_OF (4 + 2 * TRC_MAX_ARGS + 2)
+
+// "Private" global variables.
+// Ring of complete frames. Put index is written by trcLog with interrupts disabled, since it can be called
+// from interrupts as well. Get index is written only by the transmit interrupt, queued index only by trcLoop.
+static uint8_t _trcBuffer[TRC_BUFFER_SIZE];
+static volatile uint8_t _trcPutIndex = 0;
+static volatile uint8_t _trcGetIndex = 0;
+static uint8_t _trcQueuedIndex = 0;
+static volatile uint16_t _trcDropped = 0;
+
+/// Frame with delimiter preceding it
+#define TRC_FRAME_MAX_SIZE_OF (1 + TLM_FRAME_SIZE_OF(TRC_RECORD_MAX_SIZE_OF))
+
+// "Private" functions.
+uint8_t trcBuildFrame(uint8_t *frame, TrcMessage message, uint8_t count, const uint16_t *args);
+bool trcStore(const uint8_t *frame, uint8_t length);
+uint8_t trcNextByte(void);
+
+// Implementation
+void trcInit(void) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		_trcPutIndex = 0;
+		_trcGetIndex = 0;
+		_trcQueuedIndex = 0;
+		_trcDropped = 0;
+	}
+}
+
+void trcLog(TrcMessage message, uint8_t count, const uint16_t *args) {
+	// frame is built before interrupts are disabled
+	uint8_t frame[TRC_FRAME_MAX_SIZE_OF];
+	uint8_t length = trcBuildFrame(frame, message, count, args);
+	if (true == trcStore(frame, length)) {
+		evtPost(EVT_TRACE);
+	} else {
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			if (_trcDropped < UINT16_MAX) {
+				_trcDropped++;
+			}
+		}
+	}
+}
+
+void trcLoop(void) {
+	uint16_t dropped;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		dropped = _trcDropped;
+	}
+	if (dropped > 0) {
+		// reported as soon as there is room for it
+		uint8_t frame[TRC_FRAME_MAX_SIZE_OF];
+		uint8_t length = trcBuildFrame(frame, TRC_DROPPED, 1, &dropped);
+		if (true == trcStore(frame, length)) {
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+				_trcDropped -= dropped;
+			}
+		}
+	}
+	// ring contains only complete frames, so all of them are queued as single transfer
+	uint8_t putIndex = _trcPutIndex;
+	uint8_t pending = putIndex - _trcQueuedIndex;
+	if (0 == pending) {
+		return;
+	}
+	if (true == serSendFromSource(trcNextByte, pending)) {
+		_trcQueuedIndex = putIndex;
+	} else {
+		// queue of serial transfers is full, try again when other events are handled
+		evtPost(EVT_TRACE);
+	}
+}
+
+uint8_t trcBuildFrame(uint8_t *frame, TrcMessage message, uint8_t count, const uint16_t *args) {
+	uint8_t record[TRC_RECORD_MAX_SIZE_OF];
+	if (count > TRC_MAX_ARGS) {
+		count = TRC_MAX_ARGS;
+	}
+#ifdef SWT_CLOCK
+	uint16_t timestamp = (uint16_t)swtMillis();
+#else
+	// not reached, config.h enables the clock with trace
+	uint16_t timestamp = 0;
+#endif
+	record[0] = TLM_RECORD_TRACE;
+	record[1] = message;
+	record[2] = (uint8_t)timestamp;
+	record[3] = (uint8_t)(timestamp >> 8);
+	uint8_t length = 4;
+	for (uint8_t i = 0; i < count; i++) {
+		record[length++] = (uint8_t)args[i];
+		record[length++] = (uint8_t)(args[i] >> 8);
+	}
+	// space for CRC
+	length += 2;
+	// frame starts with delimiter separating it from ASCII output
+	frame[0] = 0;
+	return 1 + tlmEncodeFrame(record, length, &frame[1]);
+}
+
+bool trcStore(const uint8_t *frame, uint8_t length) {
+	bool stored = false;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		uint8_t putIndex = _trcPutIndex;
+		if (length <= TRC_BUFFER_SIZE - (uint8_t)(putIndex - _trcGetIndex)) {
+			for (uint8_t i = 0; i < length; i++) {
+				_trcBuffer[(uint8_t)(putIndex + i) & TRC_BUFFER_MASK] = frame[i];
+			}
+			_trcPutIndex = putIndex + length;
+			stored = true;
+		}
+	}
+	return stored;
+}
+
+// Called only by the transmit interrupt of Serial, never more times than bytes queued by trcLoop
+uint8_t trcNextByte(void) {
+	uint8_t getIndex = _trcGetIndex;
+	uint8_t c = _trcBuffer[getIndex & TRC_BUFFER_MASK];
+	_trcGetIndex = getIndex + 1;
+	return c;
+}
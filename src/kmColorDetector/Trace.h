@@ -0,0 +1,96 @@
+/** @file
+ * @brief Deferred binary trace messages formatted on the host.
+ * Trace.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Call site stores only identifier of the message, its integer arguments and timestamp.
+ *  Record is framed the same way as telemetry (see Telemetry.h), each frame is preceded
+ *  by additional delimiter, so it's separated also from ASCII debug output. Record:
+ *  | Offset | Size | Field |
+ *  |--------|------|-------|
+ *  | 0      | 1    | record type #TLM_RECORD_TRACE |
+ *  | 1      | 1    | message identifier, see TraceMessages.h |
+ *  | 2      | 2    | lower 16 bits of timestamp in ms (swtMillis) |
+ *  | 4      | 2 * n| arguments, up to #TRC_MAX_ARGS |
+ *
+ *  Frames wait in the ring and the transmit interrupt of Serial takes them directly from there.
+ *  When the ring is full messages are dropped and their number is reported with #TRC_DROPPED.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/// Maximum number of arguments of the message
+#define TRC_MAX_ARGS 4
+
+/// Identifiers of trace messages as defined in TraceMessages.h
+typedef enum {
+#define TRC_MESSAGE(ID, FORMAT) ID,
+#include "TraceMessages.h"
+#undef TRC_MESSAGE
+	TRC_SIZE_OF
+} TrcMessage;
+
+/**
+Initializes empty ring of trace frames.
+*/
+void trcInit(void);
+
+/**
+Stores trace message in the ring, it can be called also from interrupts.
+Use TRC_LOGn macros, so the calls are removed when trace is disabled.
+@param message Identifier of the message.
+@param count Number of arguments, up to #TRC_MAX_ARGS.
+@param args Arguments of the message.
+*/
+void trcLog(TrcMessage message, uint8_t count, const uint16_t *args);
+
+/**
+Queues stored frames for serial transmission, to be registered as handler of #EVT_TRACE.
+*/
+void trcLoop(void);
+
+#if !defined(KMCD_NO_TRACE) && !defined(KMCD_NO_SERIAL_DEBUG)
+/// Stores trace message without arguments.
+#define TRC_LOG0(MESSAGE) trcLog((MESSAGE), 0, NULL)
+/// Stores trace message with single argument.
+#define TRC_LOG1(MESSAGE, A) trcLog((MESSAGE), 1, (const uint16_t[]){(A)})
+/// Stores trace message with two arguments.
+#define TRC_LOG2(MESSAGE, A, B) trcLog((MESSAGE), 2, (const uint16_t[]){(A), (B)})
+/// Stores trace message with three arguments.
+#define TRC_LOG3(MESSAGE, A, B, C) trcLog((MESSAGE), 3, (const uint16_t[]){(A), (B), (C)})
+/// Stores trace message with four arguments.
+#define TRC_LOG4(MESSAGE, A, B, C, D) trcLog((MESSAGE), 4, (const uint16_t[]){(A), (B), (C), (D)})
+#else
+#define TRC_LOG0(MESSAGE)
+#define TRC_LOG1(MESSAGE, A)
+#define TRC_LOG2(MESSAGE, A, B)
+#define TRC_LOG3(MESSAGE, A, B, C)
+#define TRC_LOG4(MESSAGE, A, B, C, D)
+#endif
+
+#endif /* TRACE_H_ */
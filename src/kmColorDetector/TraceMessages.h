@@ -0,0 +1,36 @@
+/** @file
+ * @brief Dictionary of trace messages.
+ * TraceMessages.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Each TRC_MESSAGE(ID, FORMAT) defines identifier of the message in order of appearance.
+ *  Format is never stored on the device, src/tools/kmcdTraceDict.py extracts it to the dictionary
+ *  used by src/tools/kmcdTrace.py on the host. Supported conversions: %u %d %x %X %c, one per argument.
+ *  New messages are to be appended at the end, so identifiers in older logs stay valid.
+ *  No include guard, the file is included once per expansion of TRC_MESSAGE.
+ */
+
+TRC_MESSAGE(TRC_DROPPED, "%u trace messages dropped")
+TRC_MESSAGE(TRC_MEASURE_START, "measure start")
+TRC_MESSAGE(TRC_MEASURE_DONE, "measure R:%X G:%X B:%X class %u")
+TRC_MESSAGE(TRC_UNKNOWN_COLOR, "unknown color, error %u")
+TRC_MESSAGE(TRC_TRAINING_SAMPLE, "training class %u, samples %u")
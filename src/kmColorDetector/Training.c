@@ -0,0 +1,187 @@
+/*
+ * Training.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Training.h"
+#include "Settings.h"
+
+// Internal definition of types.
+typedef struct {
+	// running mean in Q8.8 format
+	int32_t mean;
+	// sum of squares of differences from the mean in Q16.8 format
+	uint32_t m2;
+} trnChannel;
+
+// "Private" global variables.
+static bool _trnActive = false;
+static uint8_t _trnClassId = 0;
+static uint8_t _trnCount = 0;
+static trnChannel _trnR;
+static trnChannel _trnG;
+static trnChannel _trnB;
+
+// "Private" functions.
+void trnResetChannel(trnChannel *channel);
+void trnUpdateChannel(trnChannel *channel, uint8_t value);
+uint8_t trnChannelMean(const trnChannel *channel);
+uint16_t trnChannelVariance(const trnChannel *channel);
+
+// Implementation
+void trnResetChannel(trnChannel *channel) {
+	channel->mean = 0;
+	channel->m2 = 0;
+}
+
+void trnUpdateChannel(trnChannel *channel, uint8_t value) {
+	// Welford: delta = x - mean; mean += delta / n; m2 += delta * (x - mean)
+	int32_t x = (int32_t)value << 8;
+	int32_t delta = x - channel->mean;
+	channel->mean += delta / _trnCount;
+	int32_t delta2 = x - channel->mean;
+	// both deltas have the same sign, reduce them to Q8.4 so the product fits 32 bits
+	channel->m2 += (uint32_t)((delta >> 4) * (delta2 >> 4));
+}
+
+uint8_t trnChannelMean(const trnChannel *channel) {
+	int32_t result = (channel->mean + 0x80) >> 8;
+	return result > 0xFF ? 0xFF : (uint8_t)result;
+}
+
+uint16_t trnChannelVariance(const trnChannel *channel) {
+	if (_trnCount < 2) {
+		return 0;
+	}
+	return (uint16_t)((channel->m2 / (_trnCount - 1)) >> 8);
+}
+
+void trnStart(uint8_t classId) {
+	_trnClassId = classId;
+	_trnCount = 0;
+	trnResetChannel(&_trnR);
+	trnResetChannel(&_trnG);
+	trnResetChannel(&_trnB);
+	_trnActive = true;
+}
+
+void trnCancel(void) {
+	_trnActive = false;
+}
+
+bool trnActive(void) {
+	return _trnActive;
+}
+
+uint8_t trnGetClass(void) {
+	return _trnClassId;
+}
+
+bool trnAddSample(RgbColor8_t sample) {
+	if (false == _trnActive || _trnCount >= KMCD_TRAINING_MAX_SAMPLES) {
+		return false;
+	}
+	_trnCount++;
+	trnUpdateChannel(&_trnR, sample.r);
+	trnUpdateChannel(&_trnG, sample.g);
+	trnUpdateChannel(&_trnB, sample.b);
+	return true;
+}
+
+uint8_t trnGetSamplesCount(void) {
+	return _trnCount;
+}
+
+RgbColor8_t trnGetMean(void) {
+	RgbColor8_t result;
+	result.r = trnChannelMean(&_trnR);
+	result.g = trnChannelMean(&_trnG);
+	result.b = trnChannelMean(&_trnB);
+	return result;
+}
+
+RgbColor16_t trnGetVariance(void) {
+	RgbColor16_t result;
+	result.r = trnChannelVariance(&_trnR);
+	result.g = trnChannelVariance(&_trnG);
+	result.b = trnChannelVariance(&_trnB);
+	return result;
+}
+
+bool trnCommit(TrnCommitMode mode) {
+	if (false == _trnActive || _trnCount < KMCD_TRAINING_MIN_SAMPLES) {
+		return false;
+	}
+	if (TRN_COMMIT_ADD == mode) {
+		if (false == trnAddPrototype(_trnClassId, trnGetMean())) {
+			return false;
+		}
+	} else {
+		trnSetModel(_trnClassId, trnGetMean());
+	}
+	settingsStore();
+	_trnActive = false;
+	return true;
+}
+
+bool trnSetModel(uint8_t classId, RgbColor8_t color) {
+	if (classId >= KMCD_MAX_COLOR_MODELS) {
+		return false;
+	}
+	settingsSetColorModel(classId, color);
+	if (settingsGetAvailableColorModels() <= classId) {
+		settingsSetAvailableColorModels(classId + 1);
+	}
+
+	// replace first prototype of the class or add a new one at the end
+	ColorPrototype_t *prototypes = settingsGetColorPrototypes();
+	uint8_t prototypesAvailable = settingsGetAvailableColorPrototypes();
+	uint8_t prototypeNumber = 0;
+	while (prototypeNumber < prototypesAvailable && prototypes[prototypeNumber].classId != classId) {
+		prototypeNumber++;
+	}
+	if (prototypeNumber < KMCD_MAX_COLOR_PROTOTYPES) {
+		settingsSetColorPrototype(prototypeNumber, (ColorPrototype_t){.color = color, .classId = classId});
+		if (prototypeNumber == prototypesAvailable) {
+			settingsSetAvailableColorPrototypes(prototypesAvailable + 1);
+		}
+	}
+	return true;
+}
+
+bool trnAddPrototype(uint8_t classId, RgbColor8_t color) {
+	uint8_t prototypesAvailable = settingsGetAvailableColorPrototypes();
+	if (classId >= KMCD_MAX_COLOR_MODELS || prototypesAvailable >= KMCD_MAX_COLOR_PROTOTYPES) {
+		return false;
+	}
+	if (settingsGetAvailableColorModels() <= classId) {
+		// class without model gets the prototype as its model
+		settingsSetColorModel(classId, color);
+		settingsSetAvailableColorModels(classId + 1);
+	}
+	settingsSetColorPrototype(prototypesAvailable, (ColorPrototype_t){.color = color, .classId = classId});
+	settingsSetAvailableColorPrototypes(prototypesAvailable + 1);
+	return true;
+}
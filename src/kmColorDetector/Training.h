@@ -0,0 +1,135 @@
+/** @file
+ * @brief Supervised training of the color models based on captured samples.
+ * Training.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  References:
+ * -# https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Welford's_online_algorithm
+ */
+
+#ifndef TRAINING_H_
+#define TRAINING_H_
+
+#include "common.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ColorTools.h"
+
+/**
+How #trnCommit stores the mean of collected samples.
+*/
+typedef enum {
+	/// Mean replaces the model of the class and its first color prototype
+	TRN_COMMIT_REPLACE,
+	/// Mean is added as another color prototype of the class, so one class may cover several shades
+	TRN_COMMIT_ADD
+} TrnCommitMode;
+
+/**
+Starts training of specific color class. All previously collected samples are dropped.
+Following definitions to be set in config.h file @n
+#define \b KMCD_TRAINING_MIN_SAMPLES minimum number of samples required by #trnCommit@n
+#define \b KMCD_TRAINING_MAX_SAMPLES maximum number of samples collected for single class (up to 255)@n
+@param classId Number of the color class (0 to KMCD_MAX_COLOR_MODELS - 1) to be trained.
+*/
+void trnStart(uint8_t classId);
+
+/**
+Stops training without storing any results.
+*/
+void trnCancel(void);
+
+/**
+Returns true in case training has been started with #trnStart and not finished yet.
+@result true in case training is active.
+*/
+bool trnActive(void);
+
+/**
+Returns number of the color class currently trained.
+@result Number of the color class.
+*/
+uint8_t trnGetClass(void);
+
+/**
+Adds normalized color sample to the running mean and variance of the trained class.
+Calculations are done with Welford's online algorithm in fixed point, so no samples are stored.
+@param sample Normalized color sample.
+@result true if sample was accepted, false if training is not active or #KMCD_TRAINING_MAX_SAMPLES was reached.
+*/
+bool trnAddSample(RgbColor8_t sample);
+
+/**
+Returns number of samples collected since #trnStart.
+@result Number of samples.
+*/
+uint8_t trnGetSamplesCount(void);
+
+/**
+Returns the running mean of the collected samples.
+@result Mean normalized color of the samples.
+*/
+RgbColor8_t trnGetMean(void);
+
+/**
+Returns the sample variance of the collected samples for each of the color components.
+@result Variance of the samples in squared normalized color units.
+*/
+RgbColor16_t trnGetVariance(void);
+
+/**
+Stores mean of the collected samples in color models and prototypes of the trained class,
+with #trnSetModel for #TRN_COMMIT_REPLACE or with #trnAddPrototype for #TRN_COMMIT_ADD.
+Settings are stored with #settingsStore and training is finished.
+Color Tools need to be updated by the caller with #colorSetModels and #colorSetPrototypes
+since number of models and prototypes may change.
+@param mode How the mean is stored.
+@result true if model has been stored, false if less than #KMCD_TRAINING_MIN_SAMPLES were collected
+or there is no room for another prototype. Training continues in the latter case.
+*/
+bool trnCommit(TrnCommitMode mode);
+
+/**
+Stores color model of specific class and its first color prototype the same way as #trnCommit,
+but with color given directly, e.g. by remote tuning. Settings are not stored and training is not affected.
+Color Tools need to be updated by the caller with #colorSetModels and #colorSetPrototypes.
+@param classId Number of the color class (0 to KMCD_MAX_COLOR_MODELS - 1).
+@param color Normalized color of the model.
+@result true if model has been set, false for invalid class number.
+*/
+bool trnSetModel(uint8_t classId, RgbColor8_t color);
+
+/**
+Adds color prototype of specific class at the end of the prototypes, other prototypes of the class are kept.
+Color model of the class is set to the same color only if class has no model yet.
+Settings are not stored and training is not affected.
+Color Tools need to be updated by the caller with #colorSetModels and #colorSetPrototypes.
+@param classId Number of the color class (0 to KMCD_MAX_COLOR_MODELS - 1).
+@param color Normalized color of the prototype.
+@result true if prototype has been added, false for invalid class number
+or if all #KMCD_MAX_COLOR_PROTOTYPES are used.
+*/
+bool trnAddPrototype(uint8_t classId, RgbColor8_t color);
+
+#endif /* TRAINING_H_ */
@@ -38,6 +38,18 @@
 //#define KMCD_NO_LCD
 /// Disables debug functionalities based on serial port (speed 9600 baud).
 //#define KMCD_NO_SERIAL_DEBUG
+/// Disables binary telemetry of measures over serial debug interface.
+//#define KMCD_NO_TELEMETRY
+/// Disables deferred binary trace messages over serial debug interface.
+//#define KMCD_NO_TRACE
+/// Size of the ring of trace frames waiting for serial transmission, power of two up to 128
+#define TRC_BUFFER_SIZE 64
+/// Disables host initiated switch of serial debug baud rate, see BaudSwitch.h
+//#define KMCD_NO_BAUD_SWITCH
+/// Time in ms for the host to confirm new baud rate, detector goes back to the previous one after it
+#define KMCD_BAUD_SWITCH_TIMEOUT 1000
+/// Disables live ANSI terminal dashboard of measures ("set dashboard 1"), see Dashboard.h
+//#define KMCD_NO_DASHBOARD
 /// Disables EEPROM settings functionalities.
 #define KMCD_NO_EEPROM
 /** Disables DF Player Mini based on serial port (speed 9600 baud).@n
@@ -47,6 +59,34 @@
 #define KMCD_NO_DF_PLAYER
 /// Serial speed for DF Player Mini
 #define PLYR_SERIAL_BAUD_RATE 9600
+/// Size of the queue of DF Player commands, power of two up to 128
+#define SNDPL_QUEUE_SIZE_OF 8
+/// Minimum time in ms between consecutive DF Player commands, the module ignores commands coming faster
+#define SNDPL_CMD_INTERVAL 30
+/// Time in ms to wait for the reply of DF Player when ACK requests are enabled
+#define SNDPL_ACK_TIMEOUT 100
+/// Number of retries of DF Player command which isn't acknowledged
+#define SNDPL_MAX_RETRIES 2
+/** Sends debug output over software UART on OC0 pin (PB3), so measures can be observed also when
+DF Player uses the USART. Timer0 is used by software UART then. Serial debug (commands and trace)
+is disabled, measures are sent as telemetry frames or as text lines with KMCD_NO_TELEMETRY.
+*/
+//#define KMCD_SOFT_SERIAL_DEBUG
+/// Serial speed of software UART, 57600 is exactly 24 Timer0 counts per bit with prescaler 8
+#define SWS_BAUD_RATE 57600
+/// Size of the software UART transmit ring, power of two up to 128
+#define SWS_TX_BUFFER_SIZE 64
+/// Size of the serial receive ring, power of two up to 128
+#define SERIAL_RX_BUFFER_SIZE 32
+/// Size of the serial transmit ring, power of two up to 128
+#define SERIAL_TX_BUFFER_SIZE 64
+/// Size of the queue of serial transmit descriptors (RAM/flash buffers and runs of the transmit ring),
+/// power of two up to 128
+#define SERIAL_TX_QUEUE_SIZE_OF 16
+/// Size of the buffer of the line received by the command shell, longer lines are truncated
+#define SHL_LINE_SIZE_OF 32
+/// Maximum number of words in the command line including command name, e.g. "set model 1 255 0 0"
+#define SHL_MAX_ARGS 6
 
 /// Direction register for TCS3200 sensor module
 #define TSC_DDR    DDRD
@@ -109,22 +149,85 @@
 #define DEBUG_BLINK_INTERVAL 500 // 500 ms
 /// Interval of checking button state in Software Timer
 #define BUTTON_CHECK_INTERVAL 20 // 20 ms
+/// Time the button has to be held to report long press, which drives training without serial console
+#define BUTTON_LONG_PRESS_TIME 1000 // 1 s
 
 /// Maximum available color models
 #define KMCD_MAX_COLOR_MODELS 16
+/// Maximum available color prototypes (several prototypes can point to the same color model)
+#define KMCD_MAX_COLOR_PROTOTYPES 64
+/// Minimum number of samples needed to store the trained color model
+#define KMCD_TRAINING_MIN_SAMPLES 3
+/// Maximum number of samples collected for single trained color model (up to 255)
+#define KMCD_TRAINING_MAX_SAMPLES 255
+
+/// Error (sum of squared differences) to the nearest prototype above which color is treated as unknown
+#define KMCD_UNKNOWN_COLOR_ERROR 0x0C00
+/// Maximum number of clusters of unknown colors kept in RAM
+#define KMCD_CLUSTER_BUDGET 8
+/// Error (sum of squared differences) below which unknown color joins existing cluster
+#define KMCD_CLUSTER_RADIUS 0x0300
+/// Number of samples after which cluster center is updated with constant weight
+#define KMCD_CLUSTER_WEIGHT_LIMIT 64
+
+/// Smoothing policy of consecutive measures, combination of SMT_POLICY_* values from Smoothing.h
+#define KMCD_SMOOTHING_POLICY SMT_POLICY_NONE
+/// Weight of the new sample in exponential moving average as power of two (2 means 1/4)
+#define KMCD_SMOOTHING_EMA_SHIFT 2
+/// Number of last classifications used in majority vote
+#define KMCD_SMOOTHING_VOTES 5
+/// Number of consecutive agreeing classifications needed to change output class
+#define KMCD_SMOOTHING_HYSTERESIS 3
 
-/// Magic string for EEPROM settings
-#define KMCD_MAGIC "KMCD100"
+/// Magic string for EEPROM settings, to be changed with every change of the layout of stored settings
+#define KMCD_MAGIC "KMCD101"
 /// Length of magic string
 #define KMCD_MAGIC_LENGTH 8
 
 /// Number of available software timers. To be adjusted to the needs.
-#define SWT_SIZE_OF 2
+#define SWT_SIZE_OF 5
+/// Size of the ring of expired software timers, power of two, preferably greater than SWT_SIZE_OF
+#define SWT_EXPIRED_SIZE_OF 8
+/// Uncomment to enable swtMillis/swtMicros clock for timestamps, power-down timeout and statistics.
+/// Clock costs Timer2 compare interrupt at least every 256 counts (~23.7 ms), also when no software timer
+/// is running, so uC doesn't stay in idle without interrupts. Its resolution is single count (~93 us).
+/// It's enabled automatically with serial debug and any of telemetry, trace or dashboard, see below.
+//#define SWT_CLOCK
+/// Uncomment to measure worst-case latency of events (requires SWT_CLOCK, resolution ~93 us)
+//#define EVT_LATENCY_STATS
+/// Uncomment to collect lateness and duration of software timer callbacks (requires SWT_CLOCK)
+//#define SWT_STATS
+/// Uncomment to enable one-shot timers on Timer1 compare channels, sensor gate runs on Timer1 in CTC mode then,
+/// so Timer1 PWM outputs are not available
+//#define KMCD_ONE_SHOT_TIMERS
+/// Number of pending one-shot deadlines per Timer1 compare channel
+#define OST_QUEUE_SIZE_OF 4
+/// Uncomment to disable power-down, so uC only enters idle mode when no events are pending
+//#define KMCD_NO_POWER_DOWN
+/// Uncomment if a switch is wired to INT2 (PB2), e.g. in parallel to the button on BUTTON_PIN, which is polled
+/// and can't wake uC up. Power-down is disabled without it, otherwise nothing would wake uC up.
+/// Power-down timeout is measured with the clock of software timers, so SWT_CLOCK is required too.
+//#define KMCD_WAKE_PIN_INT2
+/// Time without activity after which uC enters power-down in ms, only INT2 (PB2) wakes it up then
+#define KMCD_POWER_DOWN_TIMEOUT 30000
 
 // Automatic calculation of the ports depending on above values.
 // Do not alter this part unless you know what you do.
 #ifndef NDEBUG
 #define KMCD_NO_LCD
 #endif
+#if !defined(KMCD_WAKE_PIN_INT2) && !defined(KMCD_NO_POWER_DOWN)
+// Only INT2 wakes uC up from power-down
+#define KMCD_NO_POWER_DOWN
+#endif
+#ifdef KMCD_SOFT_SERIAL_DEBUG
+// USART is left for DF Player
+#define KMCD_NO_SERIAL_DEBUG
+#endif
+#if !defined(SWT_CLOCK) && !defined(KMCD_NO_SERIAL_DEBUG) \
+	&& (!defined(KMCD_NO_TELEMETRY) || !defined(KMCD_NO_TRACE) || !defined(KMCD_NO_DASHBOARD))
+// Timestamps of telemetry and trace records and period of dashboard come from swtMillis
+#define SWT_CLOCK
+#endif
 
 #endif /* CONFIG_H_ */
\ No newline at end of file
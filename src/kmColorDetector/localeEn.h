@@ -27,6 +27,7 @@
 
 #define KMCD_INIT_STR		PSTR("kmColorDetector READY")
 #define KMCD_INIT_VERSION	PSTR("Version : ")
+#define KMCD_INIT_TIMERS_FAILED	PSTR("Timers conflict")
 #define KMCD_COLOR_WHITE	PSTR("white")
 #define KMCD_COLOR_BLACK	PSTR("black")
 #define KMCD_COLOR_RED		PSTR("red")
@@ -36,5 +37,12 @@
 #define KMCD_COLOR_BROWN	PSTR("brown")
 #define KMCD_COLOR_ORANGE	PSTR("orange")
 #define KMCD_MEASURE_START PSTR("Measure Start")
+#define KMCD_TRAINING_CLASS	PSTR("Training class ")
+#define KMCD_TRAINING_STORED	PSTR("Model stored")
+#define KMCD_TRAINING_CANCEL	PSTR("Training cancelled")
+#define KMCD_TRAINING_SAMPLES	PSTR("Samples: ")
+#define KMCD_CLUSTERS		PSTR("Unknown color clusters: ")
+#define KMCD_EVENTS_LATENCY	PSTR("Max event latency")
+#define KMCD_TIMERS_STATS	PSTR("Timer lateness min/max/mean, duration max/mean [Timer2 counts]")
 
 #endif /* LOCALEEN_H_ */
\ No newline at end of file
@@ -28,6 +28,7 @@
 
 #define KMCD_INIT_STR		PSTR("kmColorDetector GOTOWY")
 #define KMCD_INIT_VERSION	PSTR("Wersja : ")
+#define KMCD_INIT_TIMERS_FAILED	PSTR("Konflikt timerow")
 #define KMCD_COLOR_WHITE	PSTR("bialy")
 #define KMCD_COLOR_BLACK	PSTR("czarny")
 #define KMCD_COLOR_RED		PSTR("czerwony")
@@ -37,5 +38,12 @@
 #define KMCD_COLOR_BROWN	PSTR("brazowy")
 #define KMCD_COLOR_ORANGE	PSTR("pomaranczowy")
 #define KMCD_MEASURE_START  PSTR("Poczatek Pomiaru")
+#define KMCD_TRAINING_CLASS	PSTR("Uczenie klasy ")
+#define KMCD_TRAINING_STORED	PSTR("Model zapisany")
+#define KMCD_TRAINING_CANCEL	PSTR("Uczenie przerwane")
+#define KMCD_TRAINING_SAMPLES	PSTR("Probki: ")
+#define KMCD_CLUSTERS		PSTR("Grupy nieznanych kolorow: ")
+#define KMCD_EVENTS_LATENCY	PSTR("Maksymalne opoznienie zdarzen")
+#define KMCD_TIMERS_STATS	PSTR("Opoznienie timerow min/max/srednie, czas max/sredni [takty Timer2]")
 
 #endif /* LOCALEPL_H_ */
\ No newline at end of file
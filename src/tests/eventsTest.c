@@ -0,0 +1,479 @@
+/*
+ * eventsTest.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Host test of the event queue (Events.c) and simulation of worst-case latencies reported
+ *  by the "latency" command. The same load is run with three models, time is simulated in microseconds:
+ *  - polling appLoop used before the event queue, handlers print and wait for serial,
+ *  - evtLoop with the same handlers, which still wait for serial,
+ *  - evtLoop with handlers printing only parts that fit and continuing after EVT_SERIAL_TX,
+ *    the way Application.c prints measures and "dump".
+ *  Serial at 9600 baud sends single byte per 1042us from the queue of 16 transfers, flash strings
+ *  are sent without copying and only numbers take room in 64 byte transmission buffer (Serial.c).
+ *  Load of the transmission is about 70%:
+ *  - measure is streamed every 250-270ms, handling takes 1.5ms and its line is printed in 4 parts, 96 characters,
+ *  - button is checked by software timer every 20ms, callback takes 30us,
+ *  - "dump" command is typed every 700-1300ms and prints 16 replies, 288 characters,
+ *  - formatting of a part or reply takes 40us, single pass of the polling loop takes 20us.
+ *  Durations of handlers are estimates, not measured on hardware, and swtMicros has
+ *  exact resolution here. Run with "make test" in this directory.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+
+#include "config.h"
+#include "Events.h"
+#include "SoftwareTimer.h"
+
+#define SIM_DURATION 60000000UL
+#define SIM_BYTE_TIME 1042UL
+#define SIM_TX_RING_SIZE_OF 64
+#define SIM_TX_QUEUE_SIZE_OF 16
+#define SIM_MEASURE_INTERVAL 250000UL
+#define SIM_MEASURE_JITTER 20000UL
+#define SIM_MEASURE_DURATION 1500UL
+#define SIM_BUTTON_INTERVAL 20000UL
+#define SIM_BUTTON_DURATION 30UL
+#define SIM_COMMAND "dump\n"
+#define SIM_COMMAND_INTERVAL_MIN 700000UL
+#define SIM_COMMAND_INTERVAL_RANGE 600000UL
+#define SIM_DUMP_REPLIES 16
+#define SIM_PRINT_DURATION 40UL
+#define SIM_LOOP_DURATION 20UL
+/// Room checked before reply of "dump" is printed, APP_REPLY_BYTES and APP_REPLY_TRANSFERS
+#define SIM_REPLY_BYTES 44
+#define SIM_REPLY_TRANSFERS 3
+
+typedef enum {
+	SIM_POLLING,
+	SIM_BLOCKING,
+	SIM_DEFERRED
+} SimMode;
+
+/// Transfer of the output, bytes copied to transmission buffer or string sent from flash
+typedef struct {
+	bool ring;
+	uint8_t length;
+} SimTransfer;
+
+/// Part of the output checked with serWritable, up to 6 transfers
+typedef struct {
+	uint8_t bytes;
+	uint8_t count;
+	SimTransfer transfers[6];
+} SimPart;
+
+typedef struct {
+	SimMode mode;
+	uint32_t measureAt;
+	uint32_t buttonAt;
+	uint32_t commandAt;
+	uint8_t commandIndex;
+	uint8_t rxUsed;
+	uint8_t rxLines;
+	// queue of transfers and transmission buffer
+	SimTransfer queue[SIM_TX_QUEUE_SIZE_OF];
+	uint8_t queueGet;
+	uint8_t queued;
+	uint8_t txUsed;
+	uint32_t txAt;
+	// output deferred by handlers
+	bool measurePending;
+	uint8_t measurePart;
+	uint8_t dumpLeft;
+	uint32_t measures;
+	uint32_t lines;
+	// pending flags and worst latencies of the polling loop
+	uint8_t pending;
+	uint32_t postedAt[EVT_SIZE_OF];
+	uint32_t maxLatency[EVT_SIZE_OF];
+} SimState;
+
+// Measure line of dbMeasurePartToSerial, "colorOrg R:xxxx, G:xxxx, B:xxxx; colorNorm R:xx, ..."
+static const SimPart _measureParts[] = {
+	{18, 6, {{false, 9}, {true, 6}, {false, 2}, {true, 6}, {false, 2}, {true, 6}}},
+	{12, 6, {{false, 12}, {true, 4}, {false, 2}, {true, 4}, {false, 2}, {true, 4}}},
+	{12, 6, {{false, 11}, {true, 4}, {false, 2}, {true, 4}, {false, 2}, {true, 4}}},
+	{0, 3, {{false, 2}, {false, 6}, {false, 2}}}
+};
+#define SIM_MEASURE_PARTS_SIZE_OF (sizeof(_measureParts) / sizeof(_measureParts[0]))
+// Reply of appReply, e.g. "black 212 184 210"
+static const SimPart _reply = {8, 3, {{false, 8}, {true, 8}, {false, 2}}};
+
+static unsigned long _failures = 0;
+static uint32_t _seed = 1;
+static uint32_t _now = 0;
+static SimState _sim;
+static uint8_t _handled[8];
+static uint8_t _handledCount = 0;
+
+#define CHECK(condition, ...) do { \
+	if (!(condition)) { \
+		if (_failures++ < 10) { \
+			printf("  FAIL %s:%d: ", __FILE__, __LINE__); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+		} \
+	} \
+} while (0)
+
+void stubAtomicEnter(void) {
+}
+
+void stubAtomicExit(void) {
+}
+
+uint32_t swtMicros(void) {
+	return _now;
+}
+
+static uint32_t testRandom(uint32_t range) {
+	_seed = _seed * 1664525 + 1013904223;
+	return (_seed >> 8) % range;
+}
+
+static void simPost(EvtType event) {
+	if (SIM_POLLING != _sim.mode) {
+		evtPost(event);
+		return;
+	}
+	// flags polled by appLoop, latency is measured from the first post the same way as in evtPost
+	if (0 == (_sim.pending & _BV(event))) {
+		_sim.postedAt[event] = _now;
+	}
+	_sim.pending |= _BV(event);
+}
+
+static bool simPolled(EvtType event) {
+	if (0 == (_sim.pending & _BV(event))) {
+		return false;
+	}
+	_sim.pending &= ~_BV(event);
+	uint32_t latency = _now - _sim.postedAt[event];
+	if (latency > _sim.maxLatency[event]) {
+		_sim.maxLatency[event] = latency;
+	}
+	return true;
+}
+
+// Interrupts of sensor, Timer2 and USART, served at every simulated microsecond
+static void simInterrupts(void) {
+	if (_now >= _sim.measureAt) {
+		// next measure is started by the stream timer, so it drifts against the button timer
+		_sim.measureAt += SIM_MEASURE_INTERVAL + testRandom(SIM_MEASURE_JITTER);
+		simPost(EVT_MEASURE_DONE);
+	}
+	if (_now >= _sim.buttonAt) {
+		_sim.buttonAt += SIM_BUTTON_INTERVAL;
+		simPost(EVT_TIMER_EXPIRED);
+	}
+	if (_now >= _sim.commandAt) {
+		_sim.rxUsed++;
+		simPost(EVT_SERIAL_RX);
+		if (0 == SIM_COMMAND[++_sim.commandIndex]) {
+			_sim.rxLines++;
+			_sim.commandIndex = 0;
+			_sim.commandAt += SIM_COMMAND_INTERVAL_MIN + testRandom(SIM_COMMAND_INTERVAL_RANGE);
+		} else {
+			_sim.commandAt += SIM_BYTE_TIME;
+		}
+	}
+	if (_sim.queued > 0 && _now >= _sim.txAt) {
+		// the data register empty interrupt sends next byte of the first transfer
+		SimTransfer *transfer = &_sim.queue[_sim.queueGet];
+		if (true == transfer->ring) {
+			_sim.txUsed--;
+		}
+		if (0 == --transfer->length) {
+			_sim.queueGet = (_sim.queueGet + 1) % SIM_TX_QUEUE_SIZE_OF;
+			if (0 == --_sim.queued) {
+				simPost(EVT_SERIAL_TX);
+			}
+		}
+		_sim.txAt = _now + SIM_BYTE_TIME;
+	}
+}
+
+static void simSpend(uint32_t microseconds) {
+	while (microseconds-- > 0) {
+		_now++;
+		simInterrupts();
+	}
+}
+
+static SimTransfer *simLast(void) {
+	return &_sim.queue[(_sim.queueGet + _sim.queued - 1) % SIM_TX_QUEUE_SIZE_OF];
+}
+
+static void simQueue(bool ring, uint8_t length) {
+	// the same as txQueue, caller waits while the queue is full
+	while (SIM_TX_QUEUE_SIZE_OF == _sim.queued) {
+		simSpend(1);
+	}
+	if (0 == _sim.queued) {
+		_sim.txAt = _now + SIM_BYTE_TIME;
+	}
+	_sim.queued++;
+	*simLast() = (SimTransfer){ring, length};
+}
+
+static void simWrite(SimTransfer transfer) {
+	if (false == transfer.ring) {
+		simQueue(false, transfer.length);
+		return;
+	}
+	// bytes are copied one by one by serWriteChar, which extends the last transfer of the buffer
+	while (transfer.length-- > 0) {
+		while (SIM_TX_RING_SIZE_OF == _sim.txUsed) {
+			simSpend(1);
+		}
+		_sim.txUsed++;
+		if (_sim.queued > 0 && true == simLast()->ring) {
+			simLast()->length++;
+		} else {
+			simQueue(true, 1);
+		}
+	}
+}
+
+static bool simWritable(uint8_t bytes, uint8_t transfers) {
+	return SIM_TX_RING_SIZE_OF - _sim.txUsed >= bytes && SIM_TX_QUEUE_SIZE_OF - _sim.queued >= transfers;
+}
+
+static void simPrint(const SimPart *part) {
+	simSpend(SIM_PRINT_DURATION);
+	for (uint8_t i = 0; i < part->count; i++) {
+		simWrite(part->transfers[i]);
+	}
+}
+
+// Output of appSerialOutput, measure line is finished before the next reply
+static bool simOutput(void) {
+	while (true) {
+		if (0 == _sim.measurePart && true == _sim.measurePending) {
+			_sim.measurePending = false;
+			_sim.measurePart = SIM_MEASURE_PARTS_SIZE_OF;
+		}
+		while (_sim.measurePart > 0) {
+			const SimPart *part = &_measureParts[SIM_MEASURE_PARTS_SIZE_OF - _sim.measurePart];
+			if (false == simWritable(part->bytes, part->count)) {
+				return false;
+			}
+			simPrint(part);
+			if (0 == --_sim.measurePart) {
+				_sim.lines++;
+			}
+		}
+		if (0 == _sim.dumpLeft) {
+			return true;
+		}
+		if (false == simWritable(SIM_REPLY_BYTES, SIM_REPLY_TRANSFERS)) {
+			return false;
+		}
+		simPrint(&_reply);
+		_sim.dumpLeft--;
+	}
+}
+
+static bool simIdle(void) {
+	return false == _sim.measurePending && 0 == _sim.measurePart && 0 == _sim.dumpLeft
+			&& true == simWritable(SIM_REPLY_BYTES, SIM_REPLY_TRANSFERS);
+}
+
+static void simMeasureDone(void) {
+	simSpend(SIM_MEASURE_DURATION);
+	_sim.measures++;
+	if (SIM_DEFERRED == _sim.mode) {
+		// measure not printed yet is replaced with the latest one
+		_sim.measurePending = true;
+		simOutput();
+		return;
+	}
+	for (uint8_t i = 0; i < SIM_MEASURE_PARTS_SIZE_OF; i++) {
+		simPrint(&_measureParts[i]);
+	}
+	_sim.lines++;
+}
+
+static void simTimerExpired(void) {
+	simSpend(SIM_BUTTON_DURATION);
+}
+
+static void simSerialRead(void) {
+	// complete command prints the dump once its last byte is read
+	_sim.rxUsed--;
+	if (0 == _sim.rxUsed && _sim.rxLines > 0) {
+		_sim.rxLines--;
+		if (SIM_DEFERRED == _sim.mode) {
+			_sim.dumpLeft = SIM_DUMP_REPLIES;
+			simOutput();
+			return;
+		}
+		for (uint8_t i = 0; i < SIM_DUMP_REPLIES; i++) {
+			simPrint(&_reply);
+		}
+	}
+}
+
+static void simSerialReceived(void) {
+	// all received bytes are consumed, unless reply would wait for serial
+	while (_sim.rxUsed > 0) {
+		if (SIM_DEFERRED == _sim.mode && false == simIdle()) {
+			return;
+		}
+		simSpend(SIM_LOOP_DURATION);
+		simSerialRead();
+	}
+}
+
+static void simSerialWritable(void) {
+	if (true == simOutput()) {
+		simSerialReceived();
+	}
+}
+
+static void simReset(SimMode mode) {
+	_now = 0;
+	_seed = 1;
+	_sim = (SimState){0};
+	_sim.mode = mode;
+	_sim.measureAt = SIM_MEASURE_INTERVAL;
+	_sim.buttonAt = SIM_BUTTON_INTERVAL;
+	_sim.commandAt = SIM_COMMAND_INTERVAL_MIN;
+	evtInit();
+	evtRegisterHandler(EVT_MEASURE_DONE, simMeasureDone);
+	evtRegisterHandler(EVT_TIMER_EXPIRED, simTimerExpired);
+	evtRegisterHandler(EVT_SERIAL_RX, simSerialReceived);
+	if (SIM_DEFERRED == mode) {
+		evtRegisterHandler(EVT_SERIAL_TX, simSerialWritable);
+	}
+}
+
+// appLoop before the event queue, each source is polled in fixed order, serial one byte per pass
+static void simPollingLoop(void) {
+	simReset(SIM_POLLING);
+	while (_now < SIM_DURATION) {
+		simSpend(SIM_LOOP_DURATION);
+		if (true == simPolled(EVT_TIMER_EXPIRED)) {
+			simTimerExpired();
+		}
+		if (true == simPolled(EVT_MEASURE_DONE)) {
+			simMeasureDone();
+		}
+		if (_sim.rxUsed > 0) {
+			simPolled(EVT_SERIAL_RX);
+			simSerialRead();
+		}
+	}
+}
+
+static void simEventLoop(SimMode mode) {
+	simReset(mode);
+	while (_now < SIM_DURATION) {
+		evtLoop();
+		// idle until the next interrupt
+		simSpend(1);
+	}
+}
+
+static void handlerA(void) {
+	_handled[_handledCount++] = EVT_MEASURE_DONE;
+}
+
+static void handlerB(void) {
+	_handled[_handledCount++] = EVT_TIMER_EXPIRED;
+	// event posted by the handler is handled in the same evtLoop
+	if (1 == _handledCount) {
+		evtPost(EVT_MEASURE_DONE);
+	}
+}
+
+static void handlerC(void) {
+	_handled[_handledCount++] = EVT_SERIAL_RX;
+}
+
+static void testPriorities(void) {
+	evtInit();
+	evtRegisterHandler(EVT_MEASURE_DONE, handlerA);
+	evtRegisterHandler(EVT_TIMER_EXPIRED, handlerB);
+	evtRegisterHandler(EVT_SERIAL_RX, handlerC);
+	_handledCount = 0;
+	evtPost(EVT_SERIAL_RX);
+	evtPost(EVT_TIMER_EXPIRED);
+	evtPost(EVT_SERIAL_RX);
+	// event without handler is cleared
+	evtPost(EVT_BUTTON);
+	CHECK(true == evtPending(), "posted events not pending");
+	evtLoop();
+	CHECK(false == evtPending(), "events pending after evtLoop");
+	CHECK(3 == _handledCount, "%u handlers run, expected 3", _handledCount);
+	CHECK(EVT_TIMER_EXPIRED == _handled[0] && EVT_MEASURE_DONE == _handled[1] && EVT_SERIAL_RX == _handled[2],
+			"handlers run in order %u %u %u", _handled[0], _handled[1], _handled[2]);
+}
+
+static void simReport(const char *name, uint32_t *latency) {
+	printf("  %-22s %8u %8u %8u %8u   %4u/%u lines\n", name, latency[EVT_MEASURE_DONE], latency[EVT_TIMER_EXPIRED],
+			latency[EVT_SERIAL_RX], latency[EVT_SERIAL_TX], _sim.lines, _sim.measures);
+}
+
+static void testLatency(void) {
+	uint32_t polling[EVT_SIZE_OF];
+	uint32_t blocking[EVT_SIZE_OF];
+	uint32_t deferred[EVT_SIZE_OF];
+	printf("  worst-case latency [us]    measure    timer       rx       tx   printed measures\n");
+	simPollingLoop();
+	for (uint8_t i = 0; i < EVT_SIZE_OF; i++) {
+		polling[i] = _sim.maxLatency[i];
+	}
+	simReport("polling appLoop", polling);
+	simEventLoop(SIM_BLOCKING);
+	for (uint8_t i = 0; i < EVT_SIZE_OF; i++) {
+		blocking[i] = evtGetMaxLatency(i);
+	}
+	simReport("evtLoop, waiting", blocking);
+	simEventLoop(SIM_DEFERRED);
+	for (uint8_t i = 0; i < EVT_SIZE_OF; i++) {
+		deferred[i] = evtGetMaxLatency(i);
+	}
+	simReport("evtLoop, deferred", deferred);
+	// no handler waits for serial, so measure and timers wait at most for single handler formatting its output
+	CHECK(deferred[EVT_MEASURE_DONE] < SIM_BYTE_TIME * 5, "measure waits %u us for handlers", deferred[EVT_MEASURE_DONE]);
+	CHECK(deferred[EVT_TIMER_EXPIRED] < SIM_BYTE_TIME * 5, "timer waits %u us for handlers", deferred[EVT_TIMER_EXPIRED]);
+	CHECK(deferred[EVT_MEASURE_DONE] * 10 < polling[EVT_MEASURE_DONE], "measure not faster than with polling");
+	// transmission keeps up with the load, so lines are replaced only rarely
+	CHECK(_sim.lines * 10 >= _sim.measures * 9, "only %u of %u measures printed", _sim.lines, _sim.measures);
+}
+
+static void run(const char *name, void (*test)(void)) {
+	unsigned long failures = _failures;
+	test();
+	printf("%-24s %s\n", name, failures == _failures ? "OK" : "FAILED");
+}
+
+int main(void) {
+	run("evtLoop priorities", testPriorities);
+	run("evtLoop latency", testLatency);
+	return 0 == _failures ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+/*
+ * fixedPointTest.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Host test of fixed-point kernels (FixedPoint.c) and color normalization (ColorTools.c)
+ *  against double precision reference. Run with "make test" in this directory.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "FixedPoint.h"
+#include "ColorTools.h"
+
+static unsigned long _failures = 0;
+
+#define CHECK(condition, ...) do { \
+	if (!(condition)) { \
+		if (_failures++ < 10) { \
+			printf("  FAIL %s:%d: ", __FILE__, __LINE__); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+		} \
+	} \
+} while (0)
+
+static double clamp(double value, double min, double max) {
+	return value < min ? min : (value > max ? max : value);
+}
+
+static void testMulQ8_8(void) {
+	// all values of the first factor against every 251st value of the second one
+	for (int32_t a = INT16_MIN; a <= INT16_MAX; a++) {
+		for (int32_t b = INT16_MIN; b <= INT16_MAX; b += 251) {
+			double expected = clamp(floor((double)a * b / 256.0 + 0.5), INT16_MIN, INT16_MAX);
+			FxQ8_8_t result = fxMulQ8_8((FxQ8_8_t)a, (FxQ8_8_t)b);
+			CHECK(result == expected, "fxMulQ8_8(%d, %d) = %d, expected %.0f", a, b, result, expected);
+		}
+	}
+}
+
+static void testMulQ1_15(void) {
+	for (int32_t a = INT16_MIN; a <= INT16_MAX; a++) {
+		for (int32_t b = INT16_MIN; b <= INT16_MAX; b += 257) {
+			double expected = clamp(floor((double)a * b / 32768.0 + 0.5), INT16_MIN, INT16_MAX);
+			FxQ1_15_t result = fxMulQ1_15((FxQ1_15_t)a, (FxQ1_15_t)b);
+			CHECK(result == expected, "fxMulQ1_15(%d, %d) = %d, expected %.0f", a, b, result, expected);
+		}
+	}
+}
+
+static void testMulQ16_16(void) {
+	// product is truncated towards minus infinity, values are chosen so it doesn't overflow
+	uint32_t seed = 1;
+	for (uint32_t i = 0; i < 4000000; i++) {
+		seed = seed * 1664525 + 1013904223;
+		FxQ16_16_t a = (FxQ16_16_t)seed >> (seed & 0x0F);
+		seed = seed * 1664525 + 1013904223;
+		FxQ16_16_t b = (FxQ16_16_t)seed >> 16;
+		double expected = floor((double)a * b / 65536.0);
+		FxQ16_16_t result = fxMulQ16_16(a, b);
+		CHECK(result == expected, "fxMulQ16_16(%d, %d) = %d, expected %.0f", a, b, result, expected);
+	}
+}
+
+static void testMulU32Q16_16(void) {
+	// partial products are truncated separately, so the result may be one below the exact value
+	uint32_t seed = 7;
+	for (uint32_t i = 0; i < 4000000; i++) {
+		seed = seed * 1664525 + 1013904223;
+		uint32_t a = seed >> (seed & 0x0F);
+		seed = seed * 1664525 + 1013904223;
+		uint32_t b = seed >> 8;
+		double exact = floor((double)a * b / 65536.0);
+		if (exact > UINT32_MAX) {
+			continue;
+		}
+		uint32_t result = fxMulU32Q16_16(a, b);
+		CHECK(result == exact || result + 1 == exact, "fxMulU32Q16_16(%u, %u) = %u, expected %.0f", a, b, result, exact);
+	}
+}
+
+static void testRecipU16(void) {
+	// single Newton-Raphson step after the table seed gives relative error below 2^-14
+	for (uint32_t d = 2; d <= UINT16_MAX; d++) {
+		double expected = 4294967296.0 / d;
+		double error = fabs((double)fxRecipU16((uint16_t)d) - expected) / expected;
+		CHECK(error < 1.0 / 16384, "fxRecipU16(%u) relative error %g", d, error);
+	}
+	CHECK(UINT32_MAX == fxRecipU16(0), "fxRecipU16(0)");
+	CHECK(UINT32_MAX == fxRecipU16(1), "fxRecipU16(1)");
+}
+
+static void testDivU16(void) {
+	for (uint32_t d = 1; d <= UINT16_MAX; d++) {
+		for (uint32_t n = d % 97; n <= UINT16_MAX; n += 97) {
+			double expected = floor((double)n / d);
+			uint16_t result = fxDivU16((uint16_t)n, (uint16_t)d);
+			CHECK(result == expected, "fxDivU16(%u, %u) = %u, expected %.0f", n, d, result, expected);
+		}
+		// largest dividends are the most sensitive to the error of the reciprocal
+		uint16_t result = fxDivU16(UINT16_MAX, (uint16_t)d);
+		CHECK(result == UINT16_MAX / d, "fxDivU16(65535, %u) = %u", d, result);
+	}
+	CHECK(UINT16_MAX == fxDivU16(1, 0), "fxDivU16(1, 0)");
+}
+
+static uint8_t normalizeReference(uint16_t source, uint16_t black, uint16_t white) {
+	double range = white > black ? white - black : 1;
+	double scaled = ((double)source - black) * (COLOR_NORMAL_RESULT_WHITE_LEVEL - COLOR_NORMAL_RESULT_BLACK_LEVEL) / range;
+	// quotient is rounded towards zero, also below the black level
+	return (uint8_t)clamp(COLOR_NORMAL_RESULT_BLACK_LEVEL + trunc(scaled), 0x00, 0xFF);
+}
+
+static void testNormalize(void) {
+	static const RgbColor16_t references[][2] = {
+		{{0x00D4, 0x00B8, 0x00D2}, {0x057B, 0x056E, 0x0693}},
+		{{0, 0, 0}, {1, 2, 3}},
+		{{0, 1000, 30000}, {65535, 1001, 30007}},
+		{{100, 5000, 40000}, {100, 4000, 65535}},
+		{{12345, 3, 777}, {23456, 60000, 778}},
+	};
+	for (uint8_t i = 0; i < sizeof(references) / sizeof(references[0]); i++) {
+		RgbColor16_t black = references[i][0];
+		RgbColor16_t white = references[i][1];
+		colorSetBlackReference(black);
+		colorSetWhiteReference(white);
+		for (uint32_t source = 0; source <= UINT16_MAX; source++) {
+			RgbColor8_t result = colorNormalize((RgbColor16_t){source, source, source});
+			CHECK(result.r == normalizeReference(source, black.r, white.r), "colorNormalize R %u ref %u", source, i);
+			CHECK(result.g == normalizeReference(source, black.g, white.g), "colorNormalize G %u ref %u", source, i);
+			CHECK(result.b == normalizeReference(source, black.b, white.b), "colorNormalize B %u ref %u", source, i);
+		}
+	}
+}
+
+static void testDifferenceError(void) {
+	// components are independent, so each pair of values is checked in every channel
+	for (uint16_t a = 0; a <= 0xFF; a++) {
+		for (uint16_t b = 0; b <= 0xFF; b++) {
+			double expected = pow((double)a - b, 2) + pow((double)b - a, 2) + pow((double)a - 0x80, 2);
+			uint32_t result = colorDifferenceErrorRGB((RgbColor8_t){a, b, a}, (RgbColor8_t){b, a, 0x80});
+			CHECK(result == expected, "colorDifferenceErrorRGB(%u, %u) = %u, expected %.0f", a, b, result, expected);
+		}
+	}
+}
+
+static void run(const char *name, void (*test)(void)) {
+	unsigned long failures = _failures;
+	test();
+	printf("%-24s %s\n", name, failures == _failures ? "OK" : "FAILED");
+}
+
+int main(void) {
+	run("fxMulQ8_8", testMulQ8_8);
+	run("fxMulQ1_15", testMulQ1_15);
+	run("fxMulQ16_16", testMulQ16_16);
+	run("fxMulU32Q16_16", testMulU32Q16_16);
+	run("fxRecipU16", testRecipU16);
+	run("fxDivU16", testDivU16);
+	run("colorNormalize", testNormalize);
+	run("colorDifferenceErrorRGB", testDifferenceError);
+	return 0 == _failures ? 0 : 1;
+}
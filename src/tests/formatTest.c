@@ -0,0 +1,172 @@
+/*
+ * formatTest.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  Host test of number formatting (Format.c) against printf. Division by 100 with the reciprocal
+ *  of 25 is checked for all 16 bit values, decimal and hexadecimal conversions for all numbers
+ *  up to 2000000, near UINT32_MAX, around powers of 10 and for random numbers, which covers
+ *  the four digit steps of 32 bit numbers. Run with "make test" in this directory.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "Format.h"
+#include "FixedPoint.h"
+
+#define TEST_LOW_RANGE 2000000UL
+#define TEST_HIGH_RANGE 2000000UL
+#define TEST_RANDOM 4000000UL
+/// Reciprocal of 25 in Q19 used by fmtDiv100
+#define TEST_RECIP_25 0x51EC
+
+uint16_t fmtDiv100(uint16_t value);
+
+static unsigned long _failures = 0;
+static uint32_t _seed = 1;
+// Text written to the serial sink
+static char _sent[2 * FMT_BUFFER_SIZE_OF];
+static uint8_t _sentLength = 0;
+
+#define CHECK(condition, ...) do { \
+	if (!(condition)) { \
+		if (_failures++ < 10) { \
+			printf("  FAIL %s:%d: ", __FILE__, __LINE__); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+		} \
+	} \
+} while (0)
+
+size_t serWriteChar(uint8_t c) {
+	if (_sentLength + 1 < sizeof(_sent)) {
+		_sent[_sentLength++] = c;
+		_sent[_sentLength] = '\0';
+	}
+	return 1;
+}
+
+void serPrintString(const char *str) {
+	while (0 != *str) {
+		serWriteChar(*str++);
+	}
+}
+
+void serPrintString_P(const char *str) {
+	serPrintString(str);
+}
+
+void serSendBinary(const uint8_t *buf, uint8_t len) {
+}
+
+static uint32_t random32(void) {
+	_seed = _seed * 1664525 + 1013904223;
+	return _seed;
+}
+
+static void checkNumber(uint32_t value) {
+	char expected[16];
+	char buf[FMT_BUFFER_SIZE_OF];
+	sprintf(expected, "%lu", (unsigned long)value);
+	char *str = fmtDecToBuffer(buf, value);
+	CHECK(str >= buf && 0 == buf[FMT_BUFFER_SIZE_OF - 1] && 0 == strcmp(str, expected),
+			"fmtDecToBuffer(%s) = \"%s\"", expected, str);
+	sprintf(expected, "%lX", (unsigned long)value);
+	str = fmtHexToBuffer(buf, value);
+	CHECK(str >= buf && 0 == buf[FMT_BUFFER_SIZE_OF - 1] && 0 == strcmp(str, expected),
+			"fmtHexToBuffer(0x%s) = \"%s\"", expected, str);
+}
+
+static void testDiv100(void) {
+	for (uint32_t value = 0; value <= UINT16_MAX; value++) {
+		// value / 100 = (value / 4) / 25, the reciprocal alone and as used by fmtDiv100
+		uint32_t quarter = value >> 2;
+		CHECK((quarter * TEST_RECIP_25) >> 19 == quarter / 25, "%u * 0x51EC >> 19 != %u / 25", quarter, quarter);
+		CHECK(fmtDiv100(value) == value / 100, "fmtDiv100(%u) = %u", value, fmtDiv100(value));
+	}
+}
+
+static void testLowRange(void) {
+	for (uint32_t value = 0; value <= TEST_LOW_RANGE; value++) {
+		checkNumber(value);
+	}
+}
+
+static void testHighRange(void) {
+	for (uint32_t value = UINT32_MAX - TEST_HIGH_RANGE; value != 0; value++) {
+		checkNumber(value);
+	}
+}
+
+static void testBoundaries(void) {
+	// around powers of 10 and 16, and numbers with zero groups of four digits of the 32 bit steps
+	for (uint64_t power = 1; power <= UINT32_MAX; power *= 10) {
+		for (int32_t delta = -101; delta <= 101; delta++) {
+			uint64_t value = power + delta;
+			if (value <= UINT32_MAX) {
+				checkNumber((uint32_t)value);
+			}
+		}
+	}
+	for (uint8_t shift = 0; shift < 32; shift++) {
+		checkNumber(1UL << shift);
+		checkNumber((1UL << shift) - 1);
+		checkNumber((1UL << shift) + 1);
+	}
+	static const uint32_t groups[] = {
+		10000UL, 10001UL, 19999UL, 65535UL, 65536UL, 99990000UL, 100000000UL, 100000001UL,
+		100010000UL, 1000000000UL, 1000000099UL, 1000990000UL, 4000000000UL, 4294900000UL, 4294967295UL
+	};
+	for (uint8_t i = 0; i < sizeof(groups) / sizeof(groups[0]); i++) {
+		checkNumber(groups[i]);
+	}
+	for (uint32_t i = 0; i < TEST_RANDOM; i++) {
+		// all lengths of numbers are equally frequent
+		checkNumber(random32() >> (i % 32));
+	}
+}
+
+static void testSink(void) {
+	_sentLength = 0;
+	fmtDec(FMT_SINK_SERIAL, 4294967295UL);
+	CHECK(0 == strcmp(_sent, "4294967295"), "fmtDec wrote \"%s\"", _sent);
+	_sentLength = 0;
+	fmtHex(FMT_SINK_SERIAL, 0xABCDEF0UL);
+	CHECK(0 == strcmp(_sent, "ABCDEF0"), "fmtHex wrote \"%s\"", _sent);
+	_sentLength = 0;
+	fmtDec(FMT_SINK_SERIAL, 0);
+	CHECK(0 == strcmp(_sent, "0"), "fmtDec wrote \"%s\"", _sent);
+}
+
+static void run(const char *name, void (*test)(void)) {
+	unsigned long failures = _failures;
+	test();
+	printf("%-24s %s\n", name, failures == _failures ? "OK" : "FAILED");
+}
+
+int main(void) {
+	run("fmtDiv100", testDiv100);
+	run("fmt 0..2000000", testLowRange);
+	run("fmt near UINT32_MAX", testHighRange);
+	run("fmt boundaries", testBoundaries);
+	run("fmtDec/fmtHex", testSink);
+	return 0 == _failures ? 0 : 1;
+}
@@ -0,0 +1,284 @@
+/*
+ * shellTest.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  Host test of the command line path: numbers and words of the shell (Shell.c) and lines
+ *  received by Serial (serReadLine in Serial.c). Received bytes are put into UDR and the receive
+ *  interrupt handler is called directly. Checked are overflow of shlParseUint at its limit,
+ *  "0x" prefix edge cases, rest of the line kept in the last word at SHL_MAX_ARGS, truncation
+ *  of lines at maxLen, incomplete lines and mixed "\r\n" line ends. Run with "make test" in this directory.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/io.h>
+
+#include "config.h"
+#include "Events.h"
+#include "Power.h"
+#include "Serial.h"
+#include "Shell.h"
+
+#if SHL_MAX_ARGS != 6
+#error "Lines of testTokenize and testExecute are written for SHL_MAX_ARGS 6"
+#endif
+
+void USART_RXC_vect(void);
+
+volatile uint8_t SREG = _BV(SREG_I);
+volatile uint8_t UBRRH = 0;
+volatile uint8_t UBRRL = 0;
+volatile uint8_t UCSRA = _BV(UDRE) | _BV(TXC);
+volatile uint8_t UCSRB = 0;
+volatile uint8_t UCSRC = 0;
+volatile uint8_t UDR = 0;
+
+static unsigned long _failures = 0;
+static unsigned long _rxPosts = 0;
+// Arguments seen by the last handler called by the shell
+static uint8_t _handlerArgc = 0;
+static char **_handlerArgv = NULL;
+
+#define CHECK(condition, ...) do { \
+	if (!(condition)) { \
+		if (_failures++ < 10) { \
+			printf("  FAIL %s:%d: ", __FILE__, __LINE__); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+		} \
+	} \
+} while (0)
+
+void stubAtomicEnter(void) {
+}
+
+void stubAtomicExit(void) {
+}
+
+void evtPost(EvtType event) {
+	if (EVT_SERIAL_RX == event) {
+		_rxPosts++;
+	}
+}
+
+void pwrAllowPowerDown(PwrModule module, bool allow) {
+}
+
+static bool handlerAccept(uint8_t argc, char **argv) {
+	_handlerArgc = argc;
+	_handlerArgv = argv;
+	return true;
+}
+
+static bool handlerReject(uint8_t argc, char **argv) {
+	return false;
+}
+
+static const char _nameSet[] PROGMEM = "set";
+static const char _nameGet[] PROGMEM = "get";
+static const ShlCommand_t _commands[] PROGMEM = {
+	{_nameSet, handlerAccept},
+	{_nameGet, handlerReject}
+};
+
+static void receive(const char *str) {
+	while (0 != *str) {
+		UDR = *str++;
+		USART_RXC_vect();
+	}
+}
+
+static bool parse(const char *str, uint32_t max, uint32_t *value) {
+	*value = 0xA5A5A5A5;
+	return shlParseUint(str, max, value);
+}
+
+static void testParseUintLimits(void) {
+	uint32_t value;
+	CHECK(true == parse("4294967295", UINT32_MAX, &value) && UINT32_MAX == value, "UINT32_MAX decimal");
+	CHECK(false == parse("4294967296", UINT32_MAX, &value) && 0xA5A5A5A5 == value, "UINT32_MAX + 1 accepted");
+	CHECK(false == parse("42949672950", UINT32_MAX, &value), "10 * UINT32_MAX accepted");
+	CHECK(false == parse("99999999999", UINT32_MAX, &value), "11 digits accepted");
+	CHECK(false == parse("4294967295", UINT32_MAX - 1, &value), "max + 1 accepted");
+	CHECK(true == parse("0xFFFFFFFF", UINT32_MAX, &value) && UINT32_MAX == value, "UINT32_MAX hexadecimal");
+	CHECK(false == parse("0x100000000", UINT32_MAX, &value), "0x100000000 accepted");
+	CHECK(true == parse("0", 0, &value) && 0 == value, "0 with max 0");
+	CHECK(false == parse("1", 0, &value), "1 with max 0 accepted");
+	CHECK(true == parse("000000000000000255", 255, &value) && 255 == value, "leading zeros");
+
+	// every number up to the limit and above it, decimal and hexadecimal, against strtoul
+	static const uint32_t maxima[] = {1, 9, 10, 15, 16, 99, 100, 255, 256, 999, 1000, 4095, 4096};
+	for (uint8_t m = 0; m < sizeof(maxima) / sizeof(maxima[0]); m++) {
+		uint32_t max = maxima[m];
+		for (uint32_t n = 0; n <= 3 * max + 20; n++) {
+			char str[16];
+			bool accepted = n <= max;
+			sprintf(str, "%lu", (unsigned long)n);
+			bool result = parse(str, max, &value);
+			CHECK(accepted == result && (false == result || n == value), "\"%s\" with max %lu", str, (unsigned long)max);
+			sprintf(str, 0 != (n & 1) ? "0x%lx" : "0X%lX", (unsigned long)n);
+			result = parse(str, max, &value);
+			CHECK(accepted == result && (false == result || strtoul(str, NULL, 16) == value),
+					"\"%s\" with max %lu", str, (unsigned long)max);
+		}
+	}
+}
+
+static void testParseUintPrefix(void) {
+	uint32_t value;
+	CHECK(false == parse("", UINT32_MAX, &value) && 0xA5A5A5A5 == value, "empty word accepted");
+	CHECK(false == parse("0x", UINT32_MAX, &value) && 0xA5A5A5A5 == value, "bare prefix accepted");
+	CHECK(false == parse("0X", UINT32_MAX, &value), "bare upper case prefix accepted");
+	CHECK(false == parse("x1", UINT32_MAX, &value), "prefix without 0 accepted");
+	CHECK(false == parse("00x1", UINT32_MAX, &value), "prefix after two zeros accepted");
+	CHECK(false == parse("0x0x1", UINT32_MAX, &value), "double prefix accepted");
+	CHECK(false == parse("0xg", UINT32_MAX, &value), "non hexadecimal digit accepted");
+	CHECK(false == parse("0x-1", UINT32_MAX, &value), "sign accepted");
+	CHECK(false == parse("12a", UINT32_MAX, &value), "hexadecimal digit in decimal accepted");
+	CHECK(false == parse("1 2", UINT32_MAX, &value), "separator accepted");
+	CHECK(true == parse("0x0", UINT32_MAX, &value) && 0 == value, "0x0");
+	CHECK(true == parse("0x00000000000000ff", 255, &value) && 255 == value, "leading zeros after prefix");
+	CHECK(true == parse("0XaBcD", UINT32_MAX, &value) && 0xABCD == value, "mixed case digits");
+}
+
+static void testTokenize(void) {
+	char *argv[SHL_MAX_ARGS + 1];
+	char line[SHL_LINE_SIZE_OF];
+
+	strcpy(line, " \t ");
+	CHECK(0 == shlTokenize(line, argv, SHL_MAX_ARGS) && NULL == argv[0], "blank line has words");
+
+	strcpy(line, "\tset  model\t1 ");
+	uint8_t argc = shlTokenize(line, argv, SHL_MAX_ARGS);
+	CHECK(3 == argc && NULL == argv[3], "argc = %u, expected 3", argc);
+	CHECK(0 == strcmp(argv[0], "set") && 0 == strcmp(argv[1], "model") && 0 == strcmp(argv[2], "1"),
+			"words \"%s\" \"%s\" \"%s\"", argv[0], argv[1], argv[2]);
+
+	// exactly SHL_MAX_ARGS words, separators after the last one are kept in it
+	strcpy(line, "1 2 3 4 5 6  ");
+	argc = shlTokenize(line, argv, SHL_MAX_ARGS);
+	CHECK(SHL_MAX_ARGS == argc && NULL == argv[argc], "argc = %u, expected %u", argc, SHL_MAX_ARGS);
+	CHECK(0 == strcmp(argv[SHL_MAX_ARGS - 1], "6  "), "last word \"%s\"", argv[SHL_MAX_ARGS - 1]);
+
+	// words above SHL_MAX_ARGS stay in the last word, so they aren't silently dropped
+	strcpy(line, "1 2 3 4 5 6\t7  8");
+	argc = shlTokenize(line, argv, SHL_MAX_ARGS);
+	CHECK(SHL_MAX_ARGS == argc && NULL == argv[argc], "argc = %u, expected %u", argc, SHL_MAX_ARGS);
+	CHECK(0 == strcmp(argv[SHL_MAX_ARGS - 1], "6\t7  8"), "last word \"%s\"", argv[SHL_MAX_ARGS - 1]);
+	CHECK(0 == strcmp(argv[SHL_MAX_ARGS - 2], "5"), "word before the last \"%s\"", argv[SHL_MAX_ARGS - 2]);
+
+	strcpy(line, "set model");
+	argc = shlTokenize(line, argv, 1);
+	CHECK(1 == argc && 0 == strcmp(argv[0], "set model") && NULL == argv[1], "single word \"%s\"", argv[0]);
+}
+
+static void testExecute(void) {
+	char line[SHL_LINE_SIZE_OF];
+
+	strcpy(line, "  ");
+	CHECK(true == shlExecute(_commands, SHL_COMMANDS_SIZE_OF(_commands), line), "empty line rejected");
+	strcpy(line, "put 1");
+	CHECK(false == shlExecute(_commands, SHL_COMMANDS_SIZE_OF(_commands), line), "unknown command accepted");
+	strcpy(line, "sets 1");
+	CHECK(false == shlExecute(_commands, SHL_COMMANDS_SIZE_OF(_commands), line), "prefix of command accepted");
+	strcpy(line, "get 1");
+	CHECK(false == shlExecute(_commands, SHL_COMMANDS_SIZE_OF(_commands), line), "rejection ignored");
+
+	strcpy(line, "set a b c d e f g");
+	_handlerArgc = 0;
+	CHECK(true == shlExecute(_commands, SHL_COMMANDS_SIZE_OF(_commands), line), "command rejected");
+	CHECK(SHL_MAX_ARGS - 1 == _handlerArgc && NULL == _handlerArgv[_handlerArgc],
+			"handler argc = %u, expected %u", _handlerArgc, SHL_MAX_ARGS - 1);
+	CHECK(0 != _handlerArgc && 0 == strcmp(_handlerArgv[_handlerArgc - 1], "e f g"),
+			"last argument \"%s\"", _handlerArgv[_handlerArgc - 1]);
+}
+
+static void testReadLine(void) {
+	char buf[SHL_LINE_SIZE_OF];
+	serInit(9600);
+	serSetTerminationCharacter('\r');
+
+	// nothing is read until the terminator
+	CHECK(-1 == serReadLine(buf, sizeof(buf)), "line read from empty buffer");
+	receive("measure");
+	CHECK(0 == serAvailableLines(), "incomplete line available");
+	CHECK(-1 == serReadLine(buf, sizeof(buf)), "incomplete line read");
+	CHECK(7 == serAvailable(), "incomplete line consumed, %d bytes left", serAvailable());
+	receive("\r");
+	CHECK(7 == serReadLine(buf, sizeof(buf)) && 0 == strcmp(buf, "measure"), "line \"%s\"", buf);
+	CHECK(-1 == serReadLine(buf, sizeof(buf)), "second line read");
+
+	// "\r\n", "\r" and "\n\r" line ends, '\n' of the previous line is skipped at the start of the next one
+	receive("get\r\nset 1\r\n\rdump\r");
+	CHECK(4 == serAvailableLines(), "%d lines, expected 4", serAvailableLines());
+	CHECK(3 == serReadLine(buf, sizeof(buf)) && 0 == strcmp(buf, "get"), "line \"%s\"", buf);
+	CHECK(5 == serReadLine(buf, sizeof(buf)) && 0 == strcmp(buf, "set 1"), "line \"%s\"", buf);
+	CHECK(0 == serReadLine(buf, sizeof(buf)) && 0 == strcmp(buf, ""), "empty line \"%s\"", buf);
+	CHECK(4 == serReadLine(buf, sizeof(buf)) && 0 == strcmp(buf, "dump"), "line \"%s\"", buf);
+	CHECK(-1 == serReadLine(buf, sizeof(buf)), "line read after the last one");
+
+	// with '\n' terminator '\r' is skipped
+	serSetTerminationCharacter('\n');
+	receive("stream 0\r\nstream 1\n");
+	CHECK(8 == serReadLine(buf, sizeof(buf)) && 0 == strcmp(buf, "stream 0"), "line \"%s\"", buf);
+	CHECK(8 == serReadLine(buf, sizeof(buf)) && 0 == strcmp(buf, "stream 1"), "line \"%s\"", buf);
+	serSetTerminationCharacter('\r');
+
+	// line is truncated at maxLen - 1 characters and the rest is dropped up to the terminator
+	receive("0123456789\rabc\r");
+	memset(buf, 'x', sizeof(buf));
+	CHECK(4 == serReadLine(buf, 5) && 0 == strcmp(buf, "0123") && 'x' == buf[5], "truncated line \"%s\"", buf);
+	CHECK(3 == serReadLine(buf, 5) && 0 == strcmp(buf, "abc"), "line after truncated one \"%s\"", buf);
+	receive("abcd\rabcde\r");
+	CHECK(4 == serReadLine(buf, 5) && 0 == strcmp(buf, "abcd"), "line fitting exactly \"%s\"", buf);
+	CHECK(4 == serReadLine(buf, 5) && 0 == strcmp(buf, "abcd"), "line longer by one \"%s\"", buf);
+	receive("abc\rdef\r");
+	memset(buf, 'x', sizeof(buf));
+	CHECK(0 == serReadLine(buf, 1) && 0 == buf[0] && 'x' == buf[1], "line with maxLen 1 \"%s\"", buf);
+	CHECK(0 == serReadLine(buf, 0) && 'x' == buf[1], "line with maxLen 0 written");
+	CHECK(-1 == serReadLine(buf, sizeof(buf)), "dropped lines left");
+
+	// overflow without terminator flushes the buffer, so the next line isn't mixed with the garbage
+	for (uint8_t i = 0; i < SERIAL_RX_BUFFER_SIZE + 8; i++) {
+		receive("z");
+	}
+	CHECK(-1 == serReadLine(buf, sizeof(buf)), "overflowed line read");
+	CHECK(0 == serAvailable(), "%d bytes left after overflow", serAvailable());
+	receive("ok\r");
+	CHECK(2 == serReadLine(buf, sizeof(buf)) && 0 == strcmp(buf, "ok"), "line after overflow \"%s\"", buf);
+	CHECK(0 != _rxPosts, "EVT_SERIAL_RX not posted");
+}
+
+static void run(const char *name, void (*test)(void)) {
+	unsigned long failures = _failures;
+	test();
+	printf("%-24s %s\n", name, failures == _failures ? "OK" : "FAILED");
+}
+
+int main(void) {
+	run("shlParseUint limits", testParseUintLimits);
+	run("shlParseUint prefix", testParseUintPrefix);
+	run("shlTokenize", testTokenize);
+	run("shlExecute", testExecute);
+	run("serReadLine", testReadLine);
+	return 0 == _failures ? 0 : 1;
+}
@@ -0,0 +1,330 @@
+/*
+ * softwareTimerTest.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Host stress test of the tickless software timers (SoftwareTimer.c). Timer2 in CTC mode is
+ *  simulated count by count, the compare interrupt is served whenever interrupts are enabled.
+ *  Random sequences of start, restart and stop, also from callbacks, are checked for:
+ *  - every start not cancelled later expires exactly once, never before its delay,
+ *  - no timer is missed by swtLoop started after its expiry,
+ *  - timers are dispatched in order of expiry, as long as the ring of expired timers doesn't overflow.
+ *  Counter of Timer2 advances randomly within atomic blocks, so the compare interrupt is served late
+ *  and the margin of the compare value is exercised. Phases without swtLoop overflow the ring of expired timers,
+ *  which exercises the fallback scan. Run with "make test" in this directory.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+
+#include "config.h"
+#include "TimerDefs.h"
+#include "TimerManager.h"
+#include "Events.h"
+#include "SoftwareTimer.h"
+
+/// Timer2 counts per second with prescaler /1024
+#define TEST_COUNTS_PER_SECOND (F_CPU / 1024UL)
+/// Allowed lateness of the expiry in counts, a count within swtStart and the margin of the compare value
+#define TEST_TOLERANCE 4
+#define TEST_STEPS 6000000UL
+#define TEST_FLOOD_PERIOD 150000UL
+#define TEST_FLOOD_STEPS 3000UL
+
+void TIMER2_COMP_vect(void);
+
+volatile uint8_t TCCR2 = 0;
+volatile uint8_t OCR2 = 0;
+volatile uint8_t TIMSK = 0;
+volatile uint8_t TIFR = 0;
+
+typedef struct {
+	bool armed;
+	uint32_t startedAt;
+	uint32_t deadline;
+} TestExpectation;
+
+static unsigned long _failures = 0;
+static uint32_t _seed = 1;
+static volatile uint8_t _counter = 0;
+static uint32_t _now = 0;
+static uint8_t _atomicDepth = 0;
+// Counts passed since interrupts were disabled
+static uint8_t _maskedCounts = 0;
+static bool _flood = false;
+// Ring of expired timers didn't overflow since the last swtLoop, so timers are dispatched in order of expiry
+static bool _ordered = true;
+static bool _inLoop = false;
+static uint16_t _postsOutsideLoop = 0;
+static TestExpectation _expected[SWT_SIZE_OF];
+static unsigned long _starts = 0;
+static unsigned long _cancels = 0;
+static unsigned long _dispatches = 0;
+static unsigned long _overflows = 0;
+static unsigned long _maskedTotal = 0;
+
+#define CHECK(condition, ...) do { \
+	if (!(condition)) { \
+		if (_failures++ < 10) { \
+			printf("  FAIL %s:%d at %u: ", __FILE__, __LINE__, _now); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+		} \
+	} \
+} while (0)
+
+static uint32_t testRandom(uint32_t range) {
+	_seed = _seed * 1664525 + 1013904223;
+	return (_seed >> 8) % range;
+}
+
+// Timer2 in CTC mode, compare match clears the counter and sets the flag.
+// Compare value written below the counter is missed until the counter wraps.
+static void tick(void) {
+	if (0 == (TCCR2 & (TCC2_CS_MASK))) {
+		return;
+	}
+	_now++;
+	if (_counter == OCR2) {
+		_counter = 0;
+		TIFR |= _BV(OCF2);
+	} else {
+		_counter++;
+	}
+}
+
+static void serveInterrupts(void) {
+	if (0 != _atomicDepth) {
+		return;
+	}
+	while ((TIMSK & _BV(OCIE2)) && (TIFR & _BV(OCF2))) {
+		TIFR &= ~_BV(OCF2);
+		_atomicDepth++;
+		TIMER2_COMP_vect();
+		_atomicDepth--;
+	}
+	_maskedCounts = 0;
+}
+
+static void advance(uint32_t counts) {
+	while (counts-- > 0) {
+		tick();
+		serveInterrupts();
+	}
+}
+
+volatile uint8_t *stubTimer2Counter(void) {
+	// Timer2 counts every 1024 cycles, so atomic blocks and the interrupt together last at most
+	// single count, which is the assumption behind the margin of the compare value
+	if (0 == testRandom(4) && (0 == _atomicDepth || 0 == _maskedCounts)) {
+		tick();
+		if (0 != _atomicDepth) {
+			_maskedCounts++;
+			_maskedTotal++;
+		}
+	}
+	return &_counter;
+}
+
+void stubAtomicEnter(void) {
+	_atomicDepth++;
+}
+
+void stubAtomicExit(void) {
+	_atomicDepth--;
+	// pending interrupt is served as soon as interrupts are enabled again
+	serveInterrupts();
+}
+
+bool tmrReserve(TmrTimer timer, TmrUser user, TmrMode mode) {
+	return true;
+}
+
+void tmrEnableInterrupts(uint8_t mask) {
+	TIMSK |= mask;
+}
+
+void tmrDisableInterrupts(uint8_t mask) {
+	TIMSK &= ~mask;
+}
+
+void tmrClearFlags(uint8_t mask) {
+	// flags are cleared by writing one on AVR, which can't be modeled with plain variable
+	TIFR &= ~mask;
+}
+
+void evtPost(EvtType event) {
+	if (false == _inLoop) {
+		_postsOutsideLoop++;
+	}
+}
+
+static SwtValueType randomMiliseconds(void) {
+	uint32_t r = testRandom(64);
+	if (r < 4) {
+		return 0;
+	} else if (r < 44) {
+		return 1 + testRandom(30);
+	} else if (r < 60) {
+		return 1 + testRandom(300);
+	} else if (r < 63) {
+		return 1 + testRandom(5000);
+	}
+	return 1 + testRandom(UINT16_MAX);
+}
+
+static void expect(uint8_t timerNo, SwtValueType miliseconds) {
+	if (true == _expected[timerNo].armed) {
+		_cancels++;
+	}
+	_starts++;
+	_expected[timerNo].armed = true;
+	_expected[timerNo].startedAt = _now;
+	_expected[timerNo].deadline = _now + (uint32_t)miliseconds * TEST_COUNTS_PER_SECOND / 1000UL;
+}
+
+static void start(uint8_t timerNo, SwtValueType miliseconds) {
+	expect(timerNo, miliseconds);
+	swtStart(timerNo, miliseconds);
+}
+
+static void stop(uint8_t timerNo);
+
+static void callbackTimer(void *userData, SwtValueType *newTimerValue) {
+	uint8_t timerNo = (uint8_t)(uintptr_t)userData;
+	TestExpectation *expected = &_expected[timerNo];
+	_dispatches++;
+	CHECK(true == expected->armed, "timer %u dispatched, but not running", timerNo);
+	if (true == expected->armed) {
+		CHECK(_now >= expected->deadline, "timer %u dispatched %u counts early", timerNo, expected->deadline - _now);
+		if (true == _ordered) {
+			for (uint8_t i = 0; i < SWT_SIZE_OF; i++) {
+				CHECK(i == timerNo || false == _expected[i].armed || _expected[i].deadline + TEST_TOLERANCE >= expected->deadline,
+						"timer %u dispatched before timer %u expiring %u counts earlier", timerNo, i, expected->deadline - _expected[i].deadline);
+			}
+		}
+	}
+	expected->armed = false;
+	uint32_t r = testRandom(16);
+	if (r < 4) {
+		// restart through the callback argument, 0 keeps the timer stopped
+		SwtValueType miliseconds = randomMiliseconds();
+		if (0 != miliseconds) {
+			expect(timerNo, miliseconds);
+			*newTimerValue = miliseconds;
+		}
+	} else if (r < 6) {
+		// long callback, compare interrupts are served while swtLoop is running
+		advance(1 + testRandom(40));
+	} else if (r < 8) {
+		start(testRandom(SWT_SIZE_OF), true == _flood ? 0 : randomMiliseconds());
+	} else if (r < 9) {
+		stop(testRandom(SWT_SIZE_OF));
+	}
+}
+
+static void stop(uint8_t timerNo) {
+	if (true == _expected[timerNo].armed) {
+		_cancels++;
+	}
+	_expected[timerNo].armed = false;
+	swtUnregisterCallback(timerNo);
+	swtRegisterCallback(timerNo, SWT_USER_DATA((uintptr_t)timerNo), callbackTimer);
+}
+
+static void loop(void) {
+	if (_postsOutsideLoop > SWT_EXPIRED_SIZE_OF) {
+		_overflows++;
+	}
+	uint32_t loopStart = _now;
+	_inLoop = true;
+	swtLoop();
+	_inLoop = false;
+	_postsOutsideLoop = 0;
+	for (uint8_t i = 0; i < SWT_SIZE_OF; i++) {
+		CHECK(false == _expected[i].armed || _expected[i].deadline + TEST_TOLERANCE >= loopStart,
+				"timer %u started at %u missed, expired %u counts before swtLoop", i, _expected[i].startedAt, loopStart - _expected[i].deadline);
+	}
+#ifdef SWT_CLOCK
+	uint32_t millis = swtMillis();
+	uint32_t expectedMillis = (uint64_t)_now * 1000ULL / TEST_COUNTS_PER_SECOND;
+	CHECK(millis + 1 >= expectedMillis && millis <= expectedMillis + 1, "swtMillis() = %u, expected %u", millis, expectedMillis);
+#endif
+}
+
+static void operation(void) {
+	uint8_t timerNo = testRandom(SWT_SIZE_OF);
+	uint32_t r = testRandom(8);
+	if (true == _flood && r < 4) {
+		// zero delay expires immediately, repeated starts fill the ring of expired timers
+		start(timerNo, 0);
+	} else if (r < 6) {
+		start(timerNo, randomMiliseconds());
+	} else {
+		stop(timerNo);
+	}
+}
+
+static void testRandomSequences(void) {
+	CHECK(true == swtInit(SWT_INTERVAL_TICKLESS), "Timer2 not reserved");
+	for (uint8_t i = 0; i < SWT_SIZE_OF; i++) {
+		swtRegisterCallback(i, SWT_USER_DATA((uintptr_t)i), callbackTimer);
+	}
+	for (uint32_t step = 0; step < TEST_STEPS; step++) {
+		_flood = step % TEST_FLOOD_PERIOD < TEST_FLOOD_STEPS;
+		advance(1);
+		if (true == _flood) {
+			_ordered = false;
+		} else {
+			loop();
+			_ordered = true;
+		}
+		if (0 == testRandom(true == _flood ? 8 : 64)) {
+			operation();
+		}
+	}
+	// all running timers need to expire, the longest delay is 65535ms
+	_flood = false;
+	for (uint32_t step = 0; step < 710000UL + TEST_TOLERANCE; step++) {
+		advance(1);
+		loop();
+	}
+	for (uint8_t i = 0; i < SWT_SIZE_OF; i++) {
+		CHECK(false == _expected[i].armed, "timer %u never expired", i);
+	}
+	CHECK(_dispatches == _starts - _cancels, "%lu dispatches of %lu starts with %lu cancelled", _dispatches, _starts, _cancels);
+	CHECK(_overflows > 0, "ring of expired timers never overflowed");
+	printf("  %lu starts, %lu cancelled, %lu dispatches, %lu overflows, %lu counts with interrupts disabled\n",
+			_starts, _cancels, _dispatches, _overflows, _maskedTotal);
+}
+
+static void run(const char *name, void (*test)(void)) {
+	unsigned long failures = _failures;
+	test();
+	printf("%-24s %s\n", name, failures == _failures ? "OK" : "FAILED");
+}
+
+int main(void) {
+	run("swtRandomSequences", testRandomSequences);
+	return 0 == _failures ? 0 : 1;
+}
@@ -0,0 +1,16 @@
+/*
+ * interrupt.h
+ *
+ *  Host replacement of avr-libc header for unit tests, interrupt handlers are called by the test.
+ */
+
+#ifndef TESTS_INTERRUPT_H_
+#define TESTS_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define ISR(vector) void vector(void)
+#define sei()
+#define cli()
+
+#endif /* TESTS_INTERRUPT_H_ */
@@ -0,0 +1,72 @@
+/*
+ * io.h
+ *
+ *  Host replacement of avr-libc header for unit tests, registers are ordinary variables
+ *  defined in the test. Only Timer2 and USART of ATmega32 are available. Counter of Timer2 is returned
+ *  by a function of the test, so the time can advance on every access.
+ */
+
+#ifndef TESTS_IO_H_
+#define TESTS_IO_H_
+
+#include <stdint.h>
+
+#define _BV(b) (1 << (b))
+#define bit_is_set(sfr, bit) ((sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit) (!((sfr) & _BV(bit)))
+
+extern volatile uint8_t SREG;
+#define SREG_I 7
+
+extern volatile uint8_t TCCR2;
+extern volatile uint8_t OCR2;
+extern volatile uint8_t TIMSK;
+extern volatile uint8_t TIFR;
+volatile uint8_t *stubTimer2Counter(void);
+#define TCNT2 (*stubTimer2Counter())
+
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM21 3
+#define COM20 4
+#define COM21 5
+#define WGM20 6
+#define TOIE2 6
+#define OCIE2 7
+#define TOV2 6
+#define OCF2 7
+
+extern volatile uint8_t UBRRH;
+extern volatile uint8_t UBRRL;
+extern volatile uint8_t UCSRA;
+extern volatile uint8_t UCSRB;
+extern volatile uint8_t UCSRC;
+extern volatile uint8_t UDR;
+
+#define MPCM 0
+#define U2X 1
+#define PE 2
+#define DOR 3
+#define FE 4
+#define UDRE 5
+#define TXC 6
+#define RXC 7
+#define TXB8 0
+#define RXB8 1
+#define UCSZ2 2
+#define TXEN 3
+#define RXEN 4
+#define UDRIE 5
+#define TXCIE 6
+#define RXCIE 7
+#define UCPOL 0
+#define UCSZ0 1
+#define UCSZ1 2
+#define USBS 3
+#define UPM0 4
+#define UPM1 5
+#define UMSEL 6
+#define URSEL 7
+
+#endif /* TESTS_IO_H_ */
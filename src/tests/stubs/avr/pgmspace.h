@@ -0,0 +1,25 @@
+/*
+ * pgmspace.h
+ *
+ *  Host replacement of avr-libc header for unit tests, flash is ordinary memory.
+ */
+
+#ifndef TESTS_PGMSPACE_H_
+#define TESTS_PGMSPACE_H_
+
+#include <string.h>
+#include <stdint.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define PGM_P const char *
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_ptr(p) (*(void * const *)(p))
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+
+#endif /* TESTS_PGMSPACE_H_ */
@@ -0,0 +1,21 @@
+/*
+ * atomic.h
+ *
+ *  Host replacement of avr-libc header for unit tests. The test implements entry and exit
+ *  of the atomic block, so it can hold interrupts back and serve the pending ones at the exit.
+ */
+
+#ifndef TESTS_ATOMIC_H_
+#define TESTS_ATOMIC_H_
+
+#include <stdint.h>
+
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_FORCEON 1
+
+void stubAtomicEnter(void);
+void stubAtomicExit(void);
+
+#define ATOMIC_BLOCK(type) for (uint8_t _atomic = (stubAtomicEnter(), 1); _atomic; _atomic = (stubAtomicExit(), 0))
+
+#endif /* TESTS_ATOMIC_H_ */
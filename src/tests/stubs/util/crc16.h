@@ -0,0 +1,19 @@
+/*
+ * crc16.h
+ *
+ *  Host replacement of avr-libc header for unit tests, C equivalent of the inline assembler
+ *  given in avr-libc documentation.
+ */
+
+#ifndef TESTS_CRC16_H_
+#define TESTS_CRC16_H_
+
+#include <stdint.h>
+
+static inline uint16_t _crc_ccitt_update(uint16_t crc, uint8_t data) {
+	data ^= (uint8_t)crc;
+	data ^= data << 4;
+	return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+}
+
+#endif /* TESTS_CRC16_H_ */
@@ -0,0 +1,10 @@
+/*
+ * setbaud.h
+ *
+ *  Host replacement of avr-libc header for unit tests, Serial calculates the baud rate itself.
+ */
+
+#ifndef TESTS_SETBAUD_H_
+#define TESTS_SETBAUD_H_
+
+#endif /* TESTS_SETBAUD_H_ */
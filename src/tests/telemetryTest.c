@@ -0,0 +1,251 @@
+/*
+ * telemetryTest.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  Host test of telemetry frames (Telemetry.c). Random records, rich in zero bytes, are encoded
+ *  with tlmCobsEncode and tlmEncodeFrame and decoded back by an independent COBS decoder,
+ *  the same way as decode_record of src/tools/kmcdTelemetry.py does. CRC is checked against
+ *  bitwise CRC-16 (polynomial 0x8408 reflected, initial value 0xFFFF), which is what _crc_ccitt_update
+ *  of avr-libc calculates. Frames of tlmSendMeasure are checked against the layout documented
+ *  in Telemetry.h. Run with "make test" in this directory.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <util/crc16.h>
+
+#include "config.h"
+#include "Format.h"
+#include "SoftwareTimer.h"
+#include "Telemetry.h"
+
+/// Longest data accepted by tlmCobsEncode
+#define TEST_COBS_MAX_LENGTH 253
+#define TEST_RECORDS 200000UL
+#define TEST_GUARD 0xA5
+
+static unsigned long _failures = 0;
+static uint32_t _seed = 1;
+static uint32_t _millis = 0;
+// Bytes sent by Telemetry to the sink
+static uint8_t _sent[2 * TLM_FRAME_SIZE_OF(TLM_RECORD_MAX_SIZE_OF)];
+static uint8_t _sentLength = 0;
+
+#define CHECK(condition, ...) do { \
+	if (!(condition)) { \
+		if (_failures++ < 10) { \
+			printf("  FAIL %s:%d: ", __FILE__, __LINE__); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+		} \
+	} \
+} while (0)
+
+uint32_t swtMillis(void) {
+	return _millis;
+}
+
+void fmtChar(FmtSink sink, char c) {
+	if (_sentLength < sizeof(_sent)) {
+		_sent[_sentLength++] = c;
+	}
+}
+
+void fmtBinary(FmtSink sink, const uint8_t *buf, uint8_t len) {
+	while (len-- > 0) {
+		fmtChar(sink, *buf++);
+	}
+}
+
+static uint32_t random32(void) {
+	_seed = _seed * 1664525 + 1013904223;
+	return _seed;
+}
+
+static uint8_t randomByte(void) {
+	// every third byte is zero, so blocks of all lengths are encoded
+	uint32_t r = random32() >> 8;
+	return 0 == r % 3 ? 0 : (uint8_t)(r >> 8);
+}
+
+static uint16_t crcReference(const uint8_t *data, uint8_t length) {
+	uint16_t crc = 0xFFFF;
+	while (length-- > 0) {
+		crc ^= *data++;
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			crc = 0 != (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+		}
+	}
+	return crc;
+}
+
+// Decodes COBS data without the terminating zero, returns decoded length or -1 if it's malformed
+static int cobsDecode(const uint8_t *src, uint8_t length, uint8_t *dst) {
+	int decoded = 0;
+	uint8_t i = 0;
+	while (i < length) {
+		uint8_t code = src[i];
+		if (0 == code || i + code > length) {
+			return -1;
+		}
+		for (uint8_t j = 1; j < code; j++) {
+			dst[decoded++] = src[i + j];
+		}
+		i += code;
+		if (code < 0xFF && i < length) {
+			dst[decoded++] = 0;
+		}
+	}
+	return decoded;
+}
+
+static bool hasZero(const uint8_t *data, uint8_t length) {
+	return NULL != memchr(data, 0, length);
+}
+
+static void testCrc(void) {
+	static const uint8_t check[] = "123456789";
+	uint16_t crc = 0xFFFF;
+	for (uint8_t i = 0; i < 9; i++) {
+		crc = _crc_ccitt_update(crc, check[i]);
+	}
+	// check value of CRC-16/MCRF4XX, the same as crc_ccitt of kmcdTelemetry.py
+	CHECK(0x6F91 == crc, "CRC of \"123456789\" 0x%04X, expected 0x6F91", crc);
+	CHECK(crcReference(check, 9) == crc, "reference CRC 0x%04X", crcReference(check, 9));
+	for (uint32_t c = 0; c < 0x10000; c++) {
+		for (uint16_t data = 0; data < 0x100; data += 17) {
+			uint8_t byte = data;
+			uint16_t expected = (uint16_t)c ^ byte;
+			for (uint8_t bit = 0; bit < 8; bit++) {
+				expected = 0 != (expected & 1) ? (expected >> 1) ^ 0x8408 : expected >> 1;
+			}
+			uint16_t result = _crc_ccitt_update(c, byte);
+			CHECK(expected == result, "_crc_ccitt_update(0x%04X, 0x%02X) = 0x%04X, expected 0x%04X", c, byte, result, expected);
+		}
+	}
+}
+
+static void testCobs(void) {
+	uint8_t data[TEST_COBS_MAX_LENGTH];
+	uint8_t encoded[TEST_COBS_MAX_LENGTH + 2];
+	uint8_t decoded[TEST_COBS_MAX_LENGTH + 1];
+	for (uint32_t n = 0; n < TEST_RECORDS; n++) {
+		uint8_t length = n < 4 * TEST_COBS_MAX_LENGTH ? n % (TEST_COBS_MAX_LENGTH + 1) : random32() % (TEST_COBS_MAX_LENGTH + 1);
+		uint8_t pattern = n / (TEST_COBS_MAX_LENGTH + 1);
+		for (uint8_t i = 0; i < length; i++) {
+			// all zeros, no zeros and random bytes
+			data[i] = 0 == pattern ? 0 : (1 == pattern ? 0xFF - i : randomByte());
+		}
+		memset(encoded, TEST_GUARD, sizeof(encoded));
+		uint8_t result = tlmCobsEncode(data, length, encoded);
+		CHECK(length + 1 == result, "%u bytes encoded to %u", length, result);
+		CHECK(TEST_GUARD == encoded[length + 1], "%u bytes encoded beyond the result", length);
+		CHECK(false == hasZero(encoded, result), "zero in %u encoded bytes", length);
+		int decodedLength = cobsDecode(encoded, result, decoded);
+		CHECK(length == decodedLength && 0 == memcmp(data, decoded, length),
+				"%u bytes decoded to %d different bytes", length, decodedLength);
+	}
+}
+
+static void testEncodeFrame(void) {
+	uint8_t record[TLM_RECORD_MAX_SIZE_OF];
+	uint8_t frame[TLM_FRAME_SIZE_OF(TLM_RECORD_MAX_SIZE_OF) + 1];
+	uint8_t decoded[TLM_RECORD_MAX_SIZE_OF + 1];
+	for (uint32_t n = 0; n < TEST_RECORDS; n++) {
+		// shortest record is type and CRC
+		uint8_t length = 3 + random32() % (TLM_RECORD_MAX_SIZE_OF - 2);
+		for (uint8_t i = 0; i < length; i++) {
+			record[i] = randomByte();
+		}
+		memset(frame, TEST_GUARD, sizeof(frame));
+		uint8_t result = tlmEncodeFrame(record, length, frame);
+		CHECK(TLM_FRAME_SIZE_OF(length) == result, "%u bytes of record framed in %u", length, result);
+		CHECK(TEST_GUARD == frame[TLM_FRAME_SIZE_OF(length)], "%u bytes of record framed beyond the result", length);
+		CHECK(0 == frame[result - 1] && false == hasZero(frame, result - 1), "zero inside frame of %u bytes", length);
+		int decodedLength = cobsDecode(frame, result - 1, decoded);
+		CHECK(length == decodedLength && 0 == memcmp(record, decoded, length),
+				"record of %u bytes decoded to %d different bytes", length, decodedLength);
+		uint16_t crc = crcReference(decoded, length - 2);
+		CHECK((uint8_t)crc == decoded[length - 2] && (uint8_t)(crc >> 8) == decoded[length - 1],
+				"CRC of %u bytes 0x%02X%02X, expected 0x%04X", length, decoded[length - 1], decoded[length - 2], crc);
+		// any single bit error is detected
+		uint8_t bit = random32() % (8 * length);
+		decoded[bit / 8] ^= 1 << (bit % 8);
+		CHECK(crcReference(decoded, length - 2) != (decoded[length - 2] | (decoded[length - 1] << 8)),
+				"error in bit %u of %u bytes not detected", bit, length);
+	}
+}
+
+static void testSendMeasure(void) {
+	uint8_t decoded[TLM_RECORD_MAX_SIZE_OF + 1];
+	tlmInit(FMT_SINK_SERIAL);
+	_sentLength = 0;
+	tlmSetMode(TLM_MODE_BINARY);
+	CHECK(1 == _sentLength && 0 == _sent[0], "%u bytes sent by switch to binary mode", _sentLength);
+	tlmSetMode(TLM_MODE_BINARY);
+	CHECK(1 == _sentLength, "delimiter sent again in binary mode");
+	CHECK(TLM_MODE_BINARY == tlmGetMode(), "mode %d", tlmGetMode());
+
+	for (uint16_t sequence = 0; sequence < 300; sequence++) {
+		// values with zero bytes inside, so COBS blocks end in the middle of fields
+		_millis = 0x00120034UL + sequence * 0x100UL;
+		RgbColor16_t raw = {.r = 0x0100 + sequence, .g = 0x00FF, .b = 0x0000};
+		RgbColor8_t norm = {.r = 0x00, .g = sequence, .b = 0xFF};
+		_sentLength = 0;
+		tlmSendMeasure(raw, norm, sequence % 7, TLM_FLAG_UNKNOWN | TLM_FLAG_SMOOTHED);
+		CHECK(TLM_FRAME_SIZE_OF(20) == _sentLength && 0 == _sent[_sentLength - 1], "frame of %u bytes", _sentLength);
+		int length = cobsDecode(_sent, _sentLength - 1, decoded);
+		CHECK(20 == length, "measure record of %d bytes", length);
+		if (20 != length) {
+			break;
+		}
+		// offsets as documented in Telemetry.h
+		CHECK(TLM_RECORD_MEASURE == decoded[0], "type 0x%02X", decoded[0]);
+		CHECK(sequence == (decoded[1] | decoded[2] << 8), "sequence %u, expected %u", decoded[1] | decoded[2] << 8, sequence);
+		uint32_t timestamp = decoded[3] | decoded[4] << 8 | decoded[5] << 16 | (uint32_t)decoded[6] << 24;
+		CHECK(_millis == timestamp, "timestamp 0x%08X, expected 0x%08X", timestamp, _millis);
+		CHECK(raw.r == (decoded[7] | decoded[8] << 8) && raw.g == (decoded[9] | decoded[10] << 8)
+				&& raw.b == (decoded[11] | decoded[12] << 8), "raw color of measure %u", sequence);
+		CHECK(norm.r == decoded[13] && norm.g == decoded[14] && norm.b == decoded[15], "normalized color of measure %u", sequence);
+		CHECK(sequence % 7 == decoded[16], "class %u", decoded[16]);
+		CHECK((TLM_FLAG_UNKNOWN | TLM_FLAG_SMOOTHED) == decoded[17], "flags 0x%02X", decoded[17]);
+		CHECK(crcReference(decoded, 18) == (decoded[18] | decoded[19] << 8), "CRC of measure %u", sequence);
+	}
+
+	tlmSetMode(TLM_MODE_ASCII);
+	_sentLength = 0;
+	tlmSetMode(TLM_MODE_BINARY);
+	CHECK(1 == _sentLength && 0 == _sent[0], "no delimiter after switch from ASCII mode");
+}
+
+static void run(const char *name, void (*test)(void)) {
+	unsigned long failures = _failures;
+	test();
+	printf("%-24s %s\n", name, failures == _failures ? "OK" : "FAILED");
+}
+
+int main(void) {
+	run("_crc_ccitt_update", testCrc);
+	run("tlmCobsEncode", testCobs);
+	run("tlmEncodeFrame", testEncodeFrame);
+	run("tlmSendMeasure", testSendMeasure);
+	return 0 == _failures ? 0 : 1;
+}
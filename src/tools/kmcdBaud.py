@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+#
+# kmcdBaud.py
+#
+#  Created on: Oct 19, 2026
+#      Author: Krzysztof Moskwa
+#      License: GPL-3.0-or-later
+#
+#  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+#  Copyright (C) 2019  Krzysztof Moskwa
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+"""Host side of the baud rate switch of kmColorDetector serial debug (see BaudSwitch.h).
+
+    kmcdBaud.py --port /dev/ttyUSB0 --baud 9600 115200
+
+Requires pyserial. Other tools call switch_baud() with already opened port.
+"""
+
+import argparse
+import sys
+import time
+
+RATES = (9600, 19200, 38400, 57600, 115200, 230400, 460800, 691200, 1382400)
+COMMAND = b'B'
+PROBE = b'\x55'
+
+
+def read_until(port, expected, timeout):
+    """Reads bytes until expected sequence is found, other output of the detector is skipped."""
+    received = bytearray()
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        received += port.read(port.in_waiting or 1)
+        if expected in received:
+            return True
+    return False
+
+
+def switch_baud(port, baud, timeout=1.0, probes=5):
+    """Switches detector and the port to new rate, returns False if both stay at the old one."""
+    code = RATES.index(baud)
+    old = port.baudrate
+    port.timeout = 0.05
+    port.write(COMMAND + bytes([ord('0') + code]))
+    if not read_until(port, COMMAND + bytes([ord('0') + code]) + b'\r\n', timeout):
+        return False
+    port.flush()
+    port.baudrate = baud
+    port.reset_input_buffer()
+    # detector waits for the probe up to KMCD_BAUD_SWITCH_TIMEOUT, so probes are spread over shorter time
+    for _ in range(probes):
+        port.write(PROBE)
+        if read_until(port, PROBE, timeout / (2 * probes)):
+            return True
+    port.baudrate = old
+    return False
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('rate', type=int, choices=RATES, help='new baud rate')
+    parser.add_argument('--port', required=True, help='serial port of the detector')
+    parser.add_argument('--baud', type=int, default=9600, help='current baud rate of the detector')
+    args = parser.parse_args()
+
+    import serial
+    port = serial.Serial(args.port, args.baud)
+    if switch_baud(port, args.rate):
+        print('switched to %d' % args.rate)
+        return 0
+    print('switch failed, detector stays at %d' % args.baud, file=sys.stderr)
+    return 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
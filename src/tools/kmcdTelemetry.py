@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+#
+# kmcdTelemetry.py
+#
+#  Created on: Oct 19, 2026
+#      Author: Krzysztof Moskwa
+#      License: GPL-3.0-or-later
+#
+#  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+#  Copyright (C) 2019  Krzysztof Moskwa
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+"""Decoder of binary telemetry frames sent by kmColorDetector (see Telemetry.h).
+
+Reads COBS frames terminated by 0x00 from serial port (requires pyserial)
+or from a file with captured stream and prints measures as CSV lines.
+Frames with wrong CRC, e.g. ASCII text sent before binary mode was selected, are skipped.
+
+    kmcdTelemetry.py --port /dev/ttyUSB0 --baud 9600 --binary
+    kmcdTelemetry.py capture.bin > measures.csv
+"""
+
+import argparse
+import struct
+import sys
+
+from kmcdBaud import switch_baud
+
+RECORD_MEASURE = 0x01
+RECORD_TRACE = 0x02
+MEASURE_FORMAT = '<BHIHHHBBBBB'
+MEASURE_FIELDS = ('type', 'sequence', 'timestamp', 'rawR', 'rawG', 'rawB',
+                  'normR', 'normG', 'normB', 'colorClass', 'flags')
+FLAGS = ((0x01, 'unknown'), (0x02, 'training'), (0x04, 'smoothed'))
+
+
+def crc_ccitt_update(crc, data):
+    """The same as _crc_ccitt_update from avr-libc util/crc16.h."""
+    data ^= crc & 0xFF
+    data ^= (data << 4) & 0xFF
+    return ((data << 8) | (crc >> 8)) ^ (data >> 4) ^ (data << 3) & 0xFFFF
+
+
+def crc_ccitt(data):
+    crc = 0xFFFF
+    for c in data:
+        crc = crc_ccitt_update(crc, c)
+    return crc
+
+
+def cobs_decode(frame):
+    """Decodes frame without the terminating zero, returns None if it's malformed."""
+    result = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if 0 == code or i + code > len(frame):
+            return None
+        result += frame[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(frame):
+            result.append(0)
+    return bytes(result)
+
+
+def decode_record(frame):
+    """Returns dictionary with record fields or None if frame is not a valid record."""
+    record = cobs_decode(frame)
+    if record is None or len(record) < 3:
+        return None
+    payload, crc = record[:-2], struct.unpack('<H', record[-2:])[0]
+    if crc_ccitt(payload) != crc:
+        return None
+    if RECORD_MEASURE == payload[0] and struct.calcsize(MEASURE_FORMAT) == len(payload):
+        return dict(zip(MEASURE_FIELDS, struct.unpack(MEASURE_FORMAT, payload)))
+    if RECORD_TRACE == payload[0] and len(payload) >= 4 and 0 == len(payload) % 2:
+        message, timestamp = struct.unpack('<BH', payload[1:4])
+        args = struct.unpack('<%dH' % ((len(payload) - 4) // 2), payload[4:])
+        return {'type': RECORD_TRACE, 'message': message, 'timestamp': timestamp, 'args': args}
+    return None
+
+
+def frames(stream):
+    """Splits stream of bytes into frames terminated by zero."""
+    buffer = bytearray()
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            return
+        if 0 == chunk[0]:
+            if buffer:
+                yield bytes(buffer)
+            buffer = bytearray()
+        else:
+            buffer += chunk
+
+
+def flags_to_string(flags):
+    return '|'.join(name for bit, name in FLAGS if flags & bit)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('file', nargs='?', help='file with captured stream, stdin if neither file nor port is set')
+    parser.add_argument('--port', help='serial port of the detector')
+    parser.add_argument('--baud', type=int, default=9600, help='baud rate of the serial port')
+    parser.add_argument('--switch', type=int, help='switch detector to faster baud rate first, see kmcdBaud.py')
+    parser.add_argument('--binary', action='store_true', help='send "set output binary" command selecting binary telemetry')
+    args = parser.parse_args()
+
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud)
+        if args.switch and not switch_baud(stream, args.switch):
+            parser.error('baud rate switch failed')
+        if args.binary:
+            stream.write(b'set output binary\r')
+    elif args.file:
+        stream = open(args.file, 'rb')
+    else:
+        stream = sys.stdin.buffer
+
+    print(','.join(MEASURE_FIELDS[1:]))
+    skipped = 0
+    for frame in frames(stream):
+        record = decode_record(frame)
+        if record is None:
+            skipped += 1
+            continue
+        if RECORD_MEASURE != record['type']:
+            # trace messages are rendered by kmcdTrace.py
+            continue
+        values = [str(record[field]) for field in MEASURE_FIELDS[1:-1]]
+        values.append(flags_to_string(record['flags']))
+        print(','.join(values), flush=True)
+    if skipped:
+        print('skipped %d invalid frames' % skipped, file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+#
+# kmcdTrace.py
+#
+#  Created on: Oct 19, 2026
+#      Author: Krzysztof Moskwa
+#      License: GPL-3.0-or-later
+#
+#  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+#  Copyright (C) 2019  Krzysztof Moskwa
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+"""Renders deferred trace messages sent by kmColorDetector (see Trace.h).
+
+Formats are taken from the dictionary built by kmcdTraceDict.py, or directly
+from TraceMessages.h. Timestamps are 16 bit on the wire and they are unwrapped here,
+so gaps between messages have to be shorter than 65 s. Other frames are ignored.
+
+    kmcdTrace.py --dictionary kmColorDetector.trace.json --port /dev/ttyUSB0
+    kmcdTrace.py --header ../kmColorDetector/TraceMessages.h capture.bin
+"""
+
+import argparse
+import json
+import re
+import sys
+
+from kmcdBaud import switch_baud
+from kmcdTelemetry import RECORD_TRACE, decode_record, frames
+from kmcdTraceDict import build_dictionary
+
+CONVERSION = re.compile(r'%([udxXc])')
+
+
+def render(format, args):
+    values = []
+    for conversion, arg in zip(CONVERSION.findall(format), args):
+        # arguments are sent as unsigned 16 bit values
+        values.append(arg - 0x10000 if 'd' == conversion and arg & 0x8000 else arg)
+    try:
+        return format % tuple(values)
+    except (TypeError, ValueError):
+        return '%s %s' % (format, ' '.join(str(arg) for arg in args))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('file', nargs='?', help='file with captured stream, stdin if neither file nor port is set')
+    parser.add_argument('--dictionary', help='dictionary built by kmcdTraceDict.py')
+    parser.add_argument('--header', help='TraceMessages.h used instead of the dictionary')
+    parser.add_argument('--port', help='serial port of the detector')
+    parser.add_argument('--baud', type=int, default=9600, help='baud rate of the serial port')
+    parser.add_argument('--switch', type=int, help='switch detector to faster baud rate first, see kmcdBaud.py')
+    args = parser.parse_args()
+
+    if args.dictionary:
+        with open(args.dictionary) as source:
+            messages = json.load(source)['messages']
+    elif args.header:
+        with open(args.header) as source:
+            messages = build_dictionary(source.read())
+    else:
+        parser.error('either --dictionary or --header is required')
+    formats = {message['id']: message['format'] for message in messages}
+
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud)
+        if args.switch and not switch_baud(stream, args.switch):
+            parser.error('baud rate switch failed')
+    elif args.file:
+        stream = open(args.file, 'rb')
+    else:
+        stream = sys.stdin.buffer
+
+    timestamp = None
+    for frame in frames(stream):
+        record = decode_record(frame)
+        if record is None or RECORD_TRACE != record['type']:
+            continue
+        if timestamp is None:
+            timestamp = record['timestamp']
+        else:
+            timestamp += (record['timestamp'] - timestamp) & 0xFFFF
+        format = formats.get(record['message'])
+        if format is None:
+            text = 'unknown message %d: %s' % (record['message'], ' '.join(str(arg) for arg in record['args']))
+        else:
+            text = render(format, record['args'])
+        print('%10.3f %s' % (timestamp / 1000.0, text), flush=True)
+
+
+if __name__ == '__main__':
+    main()
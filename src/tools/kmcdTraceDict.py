@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+#
+# kmcdTraceDict.py
+#
+#  Created on: Oct 19, 2026
+#      Author: Krzysztof Moskwa
+#      License: GPL-3.0-or-later
+#
+#  Color detector based on AVR uC, TCS3200 and DFRobot Mini Player
+#  Copyright (C) 2019  Krzysztof Moskwa
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+"""Builds dictionary of trace messages used by kmcdTrace.py.
+
+Identifiers are assigned to TRC_MESSAGE(ID, FORMAT) entries of TraceMessages.h
+in order of appearance, the same way as TrcMessage enumeration in Trace.h.
+Run as post-build step of the project, dictionary is stored as JSON:
+
+    kmcdTraceDict.py ../kmColorDetector/TraceMessages.h kmColorDetector.trace.json
+"""
+
+import json
+import re
+import sys
+
+MESSAGE = re.compile(r'^\s*TRC_MESSAGE\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', re.MULTILINE)
+
+
+def build_dictionary(header):
+    messages = []
+    for number, match in enumerate(MESSAGE.finditer(header)):
+        messages.append({'id': number, 'name': match.group(1),
+                         'format': bytes(match.group(2), 'ascii').decode('unicode_escape')})
+    return messages
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__, file=sys.stderr)
+        return 1
+    with open(sys.argv[1]) as header:
+        messages = build_dictionary(header.read())
+    output = json.dumps({'messages': messages}, indent=2)
+    if len(sys.argv) > 2:
+        with open(sys.argv[2], 'w') as target:
+            target.write(output + '\n')
+    else:
+        print(output)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())